@@ -145,9 +145,9 @@ static bool construct_activity_from_json(discord_activity *activity){
             activity->status = json_object_get_string(valueobj);
         }
         else if (!strcmp(key, "emoji")){
-            activity->emoji = state_set_emoji(activity->state, valueobj);
+            const discord_emoji *emoji = state_set_emoji(activity->state, valueobj);
 
-            success = activity->emoji;
+            success = emoji && state_hold_emoji(activity->state, &activity->emoji, emoji);
         }
         else if (!strcmp(key, "party")){
             if (!activity->party){
@@ -510,6 +510,8 @@ void activity_free(void *ptr){
         return;
     }
 
+    state_hold_emoji(activity->state, &activity->emoji, NULL);
+
     free(activity->party);
     free(activity->assets);
     free(activity->secrets);
@@ -60,9 +60,9 @@ static bool construct_application(discord_application *application){
             application->privacy_policy_url = json_object_get_string(valueobj);
         }
         else if (!strcmp(key, "owner")){
-            application->owner = state_set_user(application->state, valueobj);
+            const discord_user *owner = state_set_user(application->state, valueobj);
 
-            success = application->owner;
+            success = owner && state_hold_user(application->state, &application->owner, owner);
         }
         else if (!strcmp(key, "verify_key")){
             application->verify_key = json_object_get_string(valueobj);
@@ -222,6 +222,8 @@ void application_free(void *applicationptr){
 
     json_object_put(application->raw_object);
 
+    state_hold_user(application->state, &application->owner, NULL);
+
     list_free(application->rpc_origins);
     list_free(application->tags);
 
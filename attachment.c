@@ -119,7 +119,7 @@ discord_attachment *attachment_init(discord_state *state, json_object *data){
     }
 
     attachment->state = state;
-    attachment->raw_object = data;
+    attachment->raw_object = json_object_get(data);
 
     if (!construct_attachment(attachment)){
         attachment_free(attachment);
@@ -0,0 +1,144 @@
+#include "cache.h"
+
+static void detach_node(discord_cache *cache, discord_cache_node *node){
+    if (node->prev){
+        node->prev->next = node->next;
+    }
+    else {
+        cache->head = node->next;
+    }
+
+    if (node->next){
+        node->next->prev = node->prev;
+    }
+    else {
+        cache->tail = node->prev;
+    }
+
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+static void push_node(discord_cache *cache, discord_cache_node *node){
+    node->prev = NULL;
+    node->next = cache->head;
+
+    if (cache->head){
+        cache->head->prev = node;
+    }
+    else {
+        cache->tail = node;
+    }
+
+    cache->head = node;
+}
+
+size_t cache_get_raw_size(json_object *raw, const discord_compact *compact){
+    if (raw){
+        return compact_get_json_size(raw);
+    }
+
+    return compact ? compact->size : 0;
+}
+
+size_t cache_get_list_size(const list *items, size_t itemsize){
+    if (!items){
+        return 0;
+    }
+
+    return list_get_length(items) * (sizeof(list_item) + itemsize);
+}
+
+void cache_link(discord_cache *cache, discord_cache_node *node, discord_cache_kind kind, snowflake key, snowflake parent, size_t size){
+    if (!cache || !node || node->linked){
+        return;
+    }
+
+    node->kind = kind;
+    node->key = key;
+    node->parent = parent;
+    node->size = size;
+    node->last_used = time(NULL);
+    node->refreshed = node->last_used;
+    node->linked = true;
+
+    push_node(cache, node);
+
+    cache->used += size;
+    cache->bytes[kind] += size;
+    ++cache->counts[kind];
+}
+
+void cache_unlink(discord_cache *cache, discord_cache_node *node){
+    if (!cache || !node || !node->linked){
+        return;
+    }
+
+    detach_node(cache, node);
+
+    cache->used -= node->size;
+    cache->bytes[node->kind] -= node->size;
+    --cache->counts[node->kind];
+
+    node->linked = false;
+}
+
+void cache_touch(discord_cache *cache, discord_cache_node *node){
+    if (!cache || !node || !node->linked){
+        return;
+    }
+
+    node->last_used = time(NULL);
+
+    if (cache->head == node){
+        return;
+    }
+
+    detach_node(cache, node);
+    push_node(cache, node);
+}
+
+void cache_resize(discord_cache *cache, discord_cache_node *node, size_t size){
+    if (!cache || !node || !node->linked){
+        return;
+    }
+
+    cache->used -= node->size;
+    cache->bytes[node->kind] -= node->size;
+
+    node->size = size;
+    node->refreshed = time(NULL);
+
+    cache->used += size;
+    cache->bytes[node->kind] += size;
+}
+
+/*
+ * start is where the last scan left off (the previous victim's prev, taken
+ * before it was evicted or moved), or NULL to begin at the tail -- resuming
+ * keeps a trim from walking the same held entities over and over
+ */
+discord_cache_node *cache_get_victim(const discord_cache *cache, const discord_cache_node *start, time_t now){
+    if (!cache){
+        return NULL;
+    }
+
+    bool overbudget = cache->budget && cache->used > cache->budget;
+    discord_cache_node *node = start ? (discord_cache_node *)start : cache->tail;
+
+    /* the head was just handed to a caller -- never evict it out from under them */
+    for (; node && node != cache->head; node = node->prev){
+        bool expired = cache->ttl && now - node->last_used >= cache->ttl;
+
+        if (!overbudget && !expired){
+            /* everything closer to the head was used more recently */
+            break;
+        }
+
+        if (!node->refs){
+            return node;
+        }
+    }
+
+    return NULL;
+}
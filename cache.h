@@ -0,0 +1,88 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "compact.h"
+#include "list.h"
+#include "snowflake.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#include <json-c/json.h>
+
+typedef enum discord_cache_kind {
+    CACHE_USER,
+    CACHE_EMOJI,
+    CACHE_MEMBER,
+    CACHE_MESSAGE,
+
+    CACHE_KIND_COUNT
+} discord_cache_kind;
+
+/*
+ * embedded in every cached entity -- links it into the state-wide LRU list
+ * and records what it costs; entities with refs are never evicted
+ */
+typedef struct discord_cache_node {
+    struct discord_cache_node *prev;
+    struct discord_cache_node *next;
+
+    discord_cache_kind kind;
+    snowflake key;
+    snowflake parent;
+
+    size_t size;
+    time_t last_used;
+    size_t refs;
+
+    /* when data from discord was last applied (linked or resized) */
+    time_t refreshed;
+
+    /* set by concurrent readers instead of relinking -- the writer moves the node later */
+    atomic_bool accessed;
+
+    bool linked;
+} discord_cache_node;
+
+typedef struct discord_cache {
+    /* head is the most recently used entity */
+    discord_cache_node *head;
+    discord_cache_node *tail;
+
+    size_t budget;
+    time_t ttl;
+
+    size_t used;
+    size_t bytes[CACHE_KIND_COUNT];
+    size_t counts[CACHE_KIND_COUNT];
+
+    size_t evictions;
+} discord_cache;
+
+typedef struct discord_cache_usage {
+    size_t used;
+    size_t budget;
+
+    size_t bytes[CACHE_KIND_COUNT];
+    size_t counts[CACHE_KIND_COUNT];
+
+    /* shared, so not charged to any single entity */
+    size_t strings;
+    size_t compact_saved;
+
+    size_t evictions;
+} discord_cache_usage;
+
+size_t cache_get_raw_size(json_object *, const discord_compact *);
+size_t cache_get_list_size(const list *, size_t);
+
+void cache_link(discord_cache *, discord_cache_node *, discord_cache_kind, snowflake, snowflake, size_t);
+void cache_unlink(discord_cache *, discord_cache_node *);
+void cache_touch(discord_cache *, discord_cache_node *);
+void cache_resize(discord_cache *, discord_cache_node *, size_t);
+
+discord_cache_node *cache_get_victim(const discord_cache *, const discord_cache_node *, time_t);
+
+#endif
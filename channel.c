@@ -2,6 +2,69 @@
 
 static const logctx *logger = NULL;
 
+static bool construct_channel_permission_overwrites(discord_channel *channel, json_object *data){
+    list *overwrites = list_init();
+
+    if (!overwrites){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] construct_channel_permission_overwrites() - overwrites initialization failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    bool success = true;
+
+    for (size_t index = 0; index < json_object_array_length(data); ++index){
+        discord_overwrite *overwrite = overwrite_from_json(json_object_array_get_idx(data, index));
+
+        if (!overwrite){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] construct_channel_permission_overwrites() - overwrite_from_json call failed\n",
+                __FILE__
+            );
+
+            success = false;
+
+            break;
+        }
+
+        list_item item = {0};
+        item.type = L_TYPE_GENERIC;
+        item.size = sizeof(*overwrite);
+        item.data = overwrite;
+        item.generic_free = free;
+
+        success = list_append(overwrites, &item);
+
+        if (!success){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] construct_channel_permission_overwrites() - list_append call failed\n",
+                __FILE__
+            );
+
+            free(overwrite);
+
+            break;
+        }
+    }
+
+    if (channel->permission_overwrites){
+        state_retire_list(channel->state, channel->permission_overwrites);
+    }
+
+    channel->permission_overwrites = overwrites;
+
+    return success;
+}
+
 static bool construct_channel(discord_channel *channel){
     bool success = true;
 
@@ -19,7 +82,8 @@ static bool construct_channel(discord_channel *channel){
             skip = true;
         }
         else if (type == json_type_array){
-            skip = !json_object_array_length(valueobj);
+            /* an emptied overwrite list still has to replace the old one */
+            skip = !json_object_array_length(valueobj) && strcmp(key, "permission_overwrites");
         }
 
         if (skip){
@@ -45,8 +109,7 @@ static bool construct_channel(discord_channel *channel){
             channel->position = json_object_get_int(valueobj);
         }
         else if (!strcmp(key, "permission_overwrites")){
-            // --- BOOKMARK --- permissions/permission_overwrites.c?
-            //success = construct_channel_permission_overwrites(channel, valueobj);
+            success = construct_channel_permission_overwrites(channel, valueobj);
         }
         else if (!strcmp(key, "name")){
             channel->name = json_object_get_string(valueobj);
@@ -168,7 +231,7 @@ discord_channel *channel_init(discord_state *state, json_object *data){
     }
 
     channel->state = state;
-    channel->raw_object = data;
+    channel->raw_object = json_object_get(data);
 
     if (!construct_channel(channel)){
         channel_free(channel);
@@ -179,6 +242,53 @@ discord_channel *channel_init(discord_state *state, json_object *data){
     return channel;
 }
 
+bool channel_update(discord_channel *channel, json_object *data){
+    if (!channel){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] channel_update() - channel is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] channel_update() - data is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!state_merge_object(channel->state, &channel->raw_object, data)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] channel_update() - state_merge_object call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!construct_channel(channel)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] channel_update() - construct_channel call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return true;
+}
+
 bool channel_send_message(discord_channel *channel, const discord_message_reply *message){
     if (!channel){
         log_write(
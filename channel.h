@@ -61,6 +61,7 @@ typedef struct discord_channel {
 } discord_channel;
 
 discord_channel *channel_init(discord_state *, json_object *);
+bool channel_update(discord_channel *, json_object *);
 
 /* API calls */
 bool channel_send_message(discord_channel *, const discord_message_reply *);
@@ -0,0 +1,195 @@
+#include "compact.h"
+
+#include "state.h"
+
+static const logctx *logger = NULL;
+
+static size_t get_json_size(json_object *);
+
+static size_t get_json_object_size(json_object *obj){
+    size_t size = DISCORD_COMPACT_JSON_TABLE_SIZE;
+    size_t entries = 0;
+
+    struct json_object_iterator curr = json_object_iter_begin(obj);
+    struct json_object_iterator end = json_object_iter_end(obj);
+
+    while (!json_object_iter_equal(&curr, &end)){
+        const char *key = json_object_iter_peek_name(&curr);
+        json_object *valueobj = json_object_iter_peek_value(&curr);
+
+        size += strlen(key) + 1;
+        size += get_json_size(valueobj);
+
+        ++entries;
+
+        json_object_iter_next(&curr);
+    }
+
+    if (entries < DISCORD_COMPACT_JSON_TABLE_ENTRIES){
+        entries = DISCORD_COMPACT_JSON_TABLE_ENTRIES;
+    }
+
+    return size + entries * DISCORD_COMPACT_JSON_ENTRY_SIZE;
+}
+
+static size_t get_json_array_size(json_object *obj){
+    size_t size = 0;
+    size_t length = json_object_array_length(obj);
+
+    for (size_t index = 0; index < length; ++index){
+        size += sizeof(obj);
+        size += get_json_size(json_object_array_get_idx(obj, index));
+    }
+
+    return size;
+}
+
+static size_t get_json_size(json_object *obj){
+    if (!obj){
+        return 0;
+    }
+
+    size_t size = DISCORD_COMPACT_JSON_NODE_SIZE;
+
+    switch (json_object_get_type(obj)){
+    case json_type_string:
+        size += json_object_get_string_len(obj) + 1;
+
+        break;
+    case json_type_array:
+        size += get_json_array_size(obj);
+
+        break;
+    case json_type_object:
+        size += get_json_object_size(obj);
+
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+size_t compact_get_json_size(json_object *obj){
+    return get_json_size(obj);
+}
+
+/* retained is how much of the DOM sub-objects keep referenced after the release -- it isn't saved */
+bool compact_object(discord_state *state, discord_compact *compact, json_object **raw, const char ***fields, size_t count, size_t retained){
+    if (!state){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] compact_object() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    logger = state->log;
+
+    if (!compact || !raw){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] compact_object() - compact and raw are required\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    size_t arenasize = 0;
+
+    for (size_t index = 0; index < count; ++index){
+        if (fields[index] && *fields[index]){
+            arenasize += strlen(*fields[index]) + 1;
+        }
+    }
+
+    char *arena = NULL;
+
+    if (arenasize){
+        arena = malloc(arenasize);
+
+        if (!arena){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] compact_object() - arena alloc failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+    }
+
+    size_t offset = 0;
+
+    for (size_t index = 0; index < count; ++index){
+        if (!fields[index] || !*fields[index]){
+            continue;
+        }
+
+        size_t length = strlen(*fields[index]) + 1;
+
+        memcpy(arena + offset, *fields[index], length);
+
+        *fields[index] = arena + offset;
+        offset += length;
+    }
+
+    /* a merged DOM would be at least as large as the biggest one released */
+    size_t jsonsize = compact_get_json_size(*raw);
+
+    jsonsize = jsonsize > retained ? jsonsize - retained : 0;
+
+    if (jsonsize > compact->json_size){
+        compact->json_size = jsonsize;
+    }
+
+    state_retire_object(state, *raw);
+
+    *raw = NULL;
+
+    state_retire(state, compact->arena, free);
+
+    state->compact_saved -= compact->saved;
+
+    compact->arena = arena;
+    compact->size = arenasize;
+    compact->saved = compact->json_size > arenasize ? compact->json_size - arenasize : 0;
+
+    state->compact_saved += compact->saved;
+
+    log_write(
+        logger,
+        LOG_DEBUG,
+        "[%s] compact_object() - released DOM (~%zu bytes) for %zu byte arena -- saved ~%zu bytes\n",
+        __FILE__,
+        compact->json_size,
+        compact->size,
+        compact->saved
+    );
+
+    return true;
+}
+
+void compact_release(discord_state *state, discord_compact *compact){
+    if (!compact){
+        return;
+    }
+
+    if (state){
+        state->compact_saved -= compact->saved;
+    }
+
+    free(compact->arena);
+
+    compact->arena = NULL;
+    compact->size = 0;
+    compact->json_size = 0;
+    compact->saved = 0;
+}
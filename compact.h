@@ -0,0 +1,33 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <json-c/json.h>
+
+/*
+ * rough json-c footprints used to estimate how much memory a retained DOM
+ * costs (node header, default lh_table and per-key hash entry)
+ */
+#define DISCORD_COMPACT_JSON_NODE_SIZE 48
+#define DISCORD_COMPACT_JSON_TABLE_SIZE 64
+#define DISCORD_COMPACT_JSON_TABLE_ENTRIES 16
+#define DISCORD_COMPACT_JSON_ENTRY_SIZE 40
+
+typedef struct discord_state discord_state;
+
+typedef struct discord_compact {
+    char *arena;
+    size_t size;
+
+    size_t json_size;
+    size_t saved;
+} discord_compact;
+
+size_t compact_get_json_size(json_object *);
+
+bool compact_object(discord_state *, discord_compact *, json_object **, const char ***, size_t, size_t);
+void compact_release(discord_state *, discord_compact *);
+
+#endif
@@ -78,6 +78,25 @@ discord *discord_init(const char *token, const discord_options *opts){
         sopts.log = opts->log;
         sopts.intent = opts->intent;
         sopts.max_messages = opts->max_messages;
+        sopts.compact = opts->compact;
+        sopts.intern = opts->intern;
+        sopts.on_diff = opts->on_diff;
+        sopts.cache_budget = opts->cache_budget;
+        sopts.cache_ttl = opts->cache_ttl;
+        sopts.concurrent_reads = opts->concurrent_reads;
+        sopts.search = opts->search;
+        sopts.read_through = opts->read_through;
+        sopts.revalidate_after = opts->revalidate_after;
+        sopts.on_fetch = opts->on_fetch;
+        sopts.presences = opts->presences;
+        sopts.presence_activities = opts->presence_activities;
+        sopts.on_journal = opts->on_journal;
+        sopts.shared_cache = opts->shared_cache;
+        sopts.shared_capacity = opts->shared_capacity;
+        sopts.global_limiter = opts->global_limiter;
+        sopts.global_rate = opts->global_rate;
+        sopts.on_breaker = opts->on_breaker;
+        sopts.http2 = opts->http2;
 
         gopts.compress = opts->compress;
         gopts.large_threshold = opts->large_threshold;
@@ -114,6 +133,7 @@ discord *discord_init(const char *token, const discord_options *opts){
     }
 
     client->state->event_context = client;
+    client->state->http->event_context = client;
     client->state->user_pointer = (void *)&client->user;
 
     if (!set_application_information(client)){
@@ -310,9 +330,10 @@ const discord_user *discord_get_user(discord *client, snowflake id, bool fetch){
         return NULL;
     }
 
-    const discord_user *user = NULL;
+    const discord_user *user = state_get_user(client->state, id);
 
-    if (fetch){
+    /* only go to the api for what the cache can't answer */
+    if (!user && fetch){
         discord_http_response *res = http_get_user(client->state->http, id);
 
         if (!res){
@@ -345,13 +366,144 @@ const discord_user *discord_get_user(discord *client, snowflake id, bool fetch){
 
         http_response_free(res);
     }
-    else {
-        user = state_get_user(client->state, id);
-    }
 
     return user;
 }
 
+const discord_user *discord_fetch_user(discord *client, snowflake id){
+    if (!client){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_fetch_user() - client is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    return state_fetch_user(client->state, id);
+}
+
+bool discord_get_cache_usage(discord *client, discord_cache_usage *usage){
+    if (!client){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_get_cache_usage() - client is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return state_get_cache_usage(client->state, usage);
+}
+
+bool discord_get_permissions(discord *client, snowflake guildid, snowflake channelid, snowflake userid, discord_permissions *permissions){
+    if (!client){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_get_permissions() - client is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return state_get_permissions(client->state, guildid, channelid, userid, permissions);
+}
+
+bool discord_can_moderate(discord *client, snowflake guildid, snowflake actorid, snowflake targetid){
+    if (!client){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_can_moderate() - client is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return state_can_moderate(client->state, guildid, actorid, targetid);
+}
+
+bool discord_snapshot(discord *client, const char *path){
+    if (!client){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_snapshot() - client is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return state_snapshot(
+        client->state,
+        path,
+        client->gateway->session_id,
+        client->gateway->last_sequence
+    );
+}
+
+bool discord_restore(discord *client, const char *path){
+    if (!client){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_restore() - client is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    discord_gateway *gateway = client->gateway;
+
+    bool success = state_restore(
+        client->state,
+        path,
+        gateway->session_id,
+        sizeof(gateway->session_id),
+        &gateway->last_sequence
+    );
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_restore() - state_restore call failed -- starting cold\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    /* a restored session lets the first connect RESUME instead of IDENTIFY */
+    gateway->resume = *gateway->session_id;
+
+    return true;
+}
+
+size_t discord_apply_journal(discord *client, const unsigned char *data, size_t size, uint64_t *sequence){
+    if (!client){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_apply_journal() - client is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+
+    return state_apply_journal(client->state, data, size, sequence);
+}
+
 bool discord_send_message(discord *client, snowflake channelid, const discord_message_reply *message){
     if (!client){
         log_write(
@@ -430,6 +582,76 @@ bool discord_send_message(discord *client, snowflake channelid, const discord_me
     return success;
 }
 
+/* returns once the request is queued -- callback gets the response from the gateway loop */
+bool discord_send_message_async(discord *client, snowflake channelid, const discord_message_reply *message, discord_http_callback callback, void *context){
+    if (!client){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_send_message_async() - client is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!message){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_send_message_async() - message is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!message->content && !message->embed && !message->embeds && !message->sticker_ids){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] discord_send_message_async() - one of content, file, embeds, sticker_ids required\n",
+            __FILE__
+        );
+
+        return true;
+    }
+
+    json_object *data = message_reply_to_json(message);
+
+    if (!data){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] discord_send_message_async() - message_reply_to_json call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    bool success = http_create_message_async(
+        client->state->http,
+        channelid,
+        data,
+        callback,
+        context
+    );
+
+    json_object_put(data);
+
+    if (!success && !client->state->http->ratelimited){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] discord_send_message_async() - http_create_message_async call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return true;
+}
+
 void discord_free(discord *client){
     if (!client){
         log_write(
@@ -442,10 +664,11 @@ void discord_free(discord *client){
         return;
     }
 
+    /* the application holds cached users -- release it while the state is alive */
+    application_free(client->application);
+
     state_free(client->state);
     gateway_free(client->gateway);
 
-    application_free(client->application);
-
     free(client);
 }
@@ -12,6 +12,25 @@ typedef struct discord_options {
 
     /* passthrough state options */
     size_t max_messages;
+    bool compact;
+    bool intern;
+    discord_state_diff on_diff;
+    size_t cache_budget;
+    time_t cache_ttl;
+    bool concurrent_reads;
+    bool search;
+    bool read_through;
+    time_t revalidate_after;
+    discord_state_fetched on_fetch;
+    bool presences;
+    bool presence_activities;
+    discord_state_journaled on_journal;
+    const char *shared_cache;
+    size_t shared_capacity;
+    const char *global_limiter;
+    unsigned global_rate;
+    discord_ratelimit_breaker_changed on_breaker;
+    bool http2;
 
     /* passthrough gateway options */
     bool compress;
@@ -36,8 +55,17 @@ bool discord_set_presence(discord *, const discord_presence *);
 bool discord_modify_presence(discord *, const time_t *, const list *, const char *, const bool *);
 
 const discord_user *discord_get_user(discord *, snowflake, bool);
+const discord_user *discord_fetch_user(discord *, snowflake);
+bool discord_get_cache_usage(discord *, discord_cache_usage *);
+bool discord_get_permissions(discord *, snowflake, snowflake, snowflake, discord_permissions *);
+bool discord_can_moderate(discord *, snowflake, snowflake, snowflake);
+
+bool discord_snapshot(discord *, const char *);
+bool discord_restore(discord *, const char *);
+size_t discord_apply_journal(discord *, const unsigned char *, size_t, uint64_t *);
 
 bool discord_send_message(discord *, snowflake, const discord_message_reply *);
+bool discord_send_message_async(discord *, snowflake, const discord_message_reply *, discord_http_callback, void *);
 
 void discord_free(discord *);
 
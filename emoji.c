@@ -96,15 +96,19 @@ static bool construct_emoji(discord_emoji *emoji){
             success = snowflake_from_string(objstr, &emoji->id);
         }
         else if (!strcmp(key, "name")){
-            emoji->name = json_object_get_string(valueobj);
+            success = state_intern_string(
+                emoji->state,
+                &emoji->name,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "roles")){
             success = construct_emoji_roles(emoji, valueobj);
         }
         else if (!strcmp(key, "user")){
-            emoji->user = state_set_user(emoji->state, valueobj);
+            const discord_user *user = state_set_user(emoji->state, valueobj);
 
-            success = emoji->user;
+            success = user && state_hold_user(emoji->state, &emoji->user, user);
         }
         else if (!strcmp(key, "require_colons")){
             emoji->require_colons = json_object_get_boolean(valueobj);
@@ -138,6 +142,21 @@ static bool construct_emoji(discord_emoji *emoji){
     return success;
 }
 
+static bool compact_emoji(discord_emoji *emoji){
+    const char **fields[] = {
+        emoji->state->strings ? NULL : &emoji->name
+    };
+
+    return compact_object(
+        emoji->state,
+        &emoji->compact,
+        &emoji->raw_object,
+        fields,
+        sizeof(fields) / sizeof(*fields),
+        0
+    );
+}
+
 discord_emoji *emoji_init(discord_state *state, json_object *data){
     if (!state){
         log_write(
@@ -177,7 +196,7 @@ discord_emoji *emoji_init(discord_state *state, json_object *data){
     }
 
     emoji->state = state;
-    emoji->raw_object = data;
+    emoji->raw_object = json_object_get(data);
 
     if (!construct_emoji(emoji)){
         emoji_free(emoji);
@@ -185,9 +204,35 @@ discord_emoji *emoji_init(discord_state *state, json_object *data){
         return NULL;
     }
 
+    if (state->compact && !compact_emoji(emoji)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] emoji_init() - compact_emoji call failed\n",
+            __FILE__
+        );
+
+        emoji_free(emoji);
+
+        return NULL;
+    }
+
     return emoji;
 }
 
+size_t emoji_get_size(const discord_emoji *emoji){
+    if (!emoji){
+        return 0;
+    }
+
+    size_t size = sizeof(*emoji);
+
+    size += cache_get_raw_size(emoji->raw_object, &emoji->compact);
+    size += cache_get_list_size(emoji->roles, sizeof(snowflake));
+
+    return size;
+}
+
 void emoji_free(void *ptr){
     discord_emoji *emoji = ptr;
 
@@ -202,8 +247,15 @@ void emoji_free(void *ptr){
         return;
     }
 
+    cache_unlink(&emoji->state->cache, &emoji->cache);
+
     json_object_put(emoji->raw_object);
 
+    compact_release(emoji->state, &emoji->compact);
+
+    state_release_string(emoji->state, emoji->name);
+    state_hold_user(emoji->state, &emoji->user, NULL);
+
     list_free(emoji->roles);
 
     free(emoji);
@@ -6,6 +6,8 @@
 typedef struct discord_emoji {
     discord_state *state;
     json_object *raw_object;
+    discord_compact compact;
+    discord_cache_node cache;
 
     snowflake id;
     const char *name;
@@ -19,6 +21,8 @@ typedef struct discord_emoji {
 
 discord_emoji *emoji_init(discord_state *, json_object *);
 
+size_t emoji_get_size(const discord_emoji *);
+
 void emoji_free(void *);
 
 #endif
@@ -0,0 +1,198 @@
+#include "epoch.h"
+
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+discord_epoch *epoch_init(void){
+    discord_epoch *epoch = aligned_alloc(DISCORD_EPOCH_CACHE_LINE, sizeof(*epoch));
+
+    if (!epoch){
+        DLOG(
+            "[%s] epoch_init() - epoch alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    memset(epoch, 0, sizeof(*epoch));
+
+    /* 0 marks a reader outside of any read section */
+    atomic_init(&epoch->global, 1);
+
+    for (size_t index = 0; index < DISCORD_EPOCH_MAX_READERS; ++index){
+        atomic_init(&epoch->readers[index].epoch, 0);
+        atomic_init(&epoch->readers[index].used, false);
+    }
+
+    return epoch;
+}
+
+int epoch_register(discord_epoch *epoch){
+    if (!epoch){
+        DLOG(
+            "[%s] epoch_register() - epoch is NULL\n",
+            __FILE__
+        );
+
+        return -1;
+    }
+
+    for (int index = 0; index < DISCORD_EPOCH_MAX_READERS; ++index){
+        bool expected = false;
+
+        if (atomic_compare_exchange_strong(&epoch->readers[index].used, &expected, true)){
+            return index;
+        }
+    }
+
+    DLOG(
+        "[%s] epoch_register() - all %d reader slots are taken\n",
+        __FILE__,
+        DISCORD_EPOCH_MAX_READERS
+    );
+
+    return -1;
+}
+
+void epoch_unregister(discord_epoch *epoch, int reader){
+    if (!epoch || reader < 0 || reader >= DISCORD_EPOCH_MAX_READERS){
+        return;
+    }
+
+    atomic_store(&epoch->readers[reader].epoch, 0);
+    atomic_store(&epoch->readers[reader].used, false);
+}
+
+void epoch_enter(discord_epoch *epoch, int reader){
+    if (!epoch || reader < 0 || reader >= DISCORD_EPOCH_MAX_READERS){
+        return;
+    }
+
+    atomic_store(&epoch->readers[reader].epoch, atomic_load(&epoch->global));
+
+    /* the announcement has to be visible before any shared pointer is loaded */
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void epoch_exit(discord_epoch *epoch, int reader){
+    if (!epoch || reader < 0 || reader >= DISCORD_EPOCH_MAX_READERS){
+        return;
+    }
+
+    atomic_store_explicit(&epoch->readers[reader].epoch, 0, memory_order_release);
+}
+
+bool epoch_retire(discord_epoch *epoch, void *ptr, void (*release)(void *)){
+    if (!epoch || !release){
+        DLOG(
+            "[%s] epoch_retire() - epoch and release are required\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!ptr){
+        return true;
+    }
+
+    discord_epoch_retired *retired = malloc(sizeof(*retired));
+
+    if (!retired){
+        DLOG(
+            "[%s] epoch_retire() - retired alloc failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    retired->ptr = ptr;
+    retired->release = release;
+    retired->epoch = atomic_load(&epoch->global);
+    retired->next = epoch->retired;
+
+    epoch->retired = retired;
+    ++epoch->pending;
+
+    /* readers entering from here on can no longer reach ptr */
+    atomic_fetch_add(&epoch->global, 1);
+
+    return true;
+}
+
+size_t epoch_collect(discord_epoch *epoch){
+    if (!epoch){
+        return 0;
+    }
+
+    uint64_t oldest = atomic_load(&epoch->global);
+
+    for (size_t index = 0; index < DISCORD_EPOCH_MAX_READERS; ++index){
+        if (!atomic_load(&epoch->readers[index].used)){
+            continue;
+        }
+
+        uint64_t curr = atomic_load(&epoch->readers[index].epoch);
+
+        if (curr && curr < oldest){
+            oldest = curr;
+        }
+    }
+
+    /* the list is newest first, so everything after the first old enough entry is too */
+    discord_epoch_retired **link = &epoch->retired;
+
+    while (*link && (*link)->epoch >= oldest){
+        link = &(*link)->next;
+    }
+
+    discord_epoch_retired *curr = *link;
+
+    *link = NULL;
+
+    size_t collected = 0;
+
+    while (curr){
+        discord_epoch_retired *next = curr->next;
+
+        curr->release(curr->ptr);
+        free(curr);
+
+        curr = next;
+
+        ++collected;
+    }
+
+    epoch->pending -= collected;
+
+    return collected;
+}
+
+void epoch_free(discord_epoch *epoch){
+    if (!epoch){
+        DLOG(
+            "[%s] epoch_free() - epoch is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    /* only safe once every reader is gone */
+    discord_epoch_retired *curr = epoch->retired;
+
+    while (curr){
+        discord_epoch_retired *next = curr->next;
+
+        curr->release(curr->ptr);
+        free(curr);
+
+        curr = next;
+    }
+
+    free(epoch);
+}
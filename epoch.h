@@ -0,0 +1,53 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DISCORD_EPOCH_MAX_READERS 64
+#define DISCORD_EPOCH_CACHE_LINE 64
+
+typedef struct discord_epoch_retired {
+    void *ptr;
+    void (*release)(void *);
+    uint64_t epoch;
+
+    struct discord_epoch_retired *next;
+} discord_epoch_retired;
+
+/* one per reader thread -- padded so readers never share a cache line */
+typedef struct discord_epoch_reader {
+    _Alignas(DISCORD_EPOCH_CACHE_LINE) _Atomic uint64_t epoch;
+    atomic_bool used;
+} discord_epoch_reader;
+
+/*
+ * epoch based reclamation: readers publish the epoch they entered in, the
+ * writer tags everything it unlinks with the current epoch and only frees it
+ * once every active reader has moved past that epoch
+ */
+typedef struct discord_epoch {
+    discord_epoch_reader readers[DISCORD_EPOCH_MAX_READERS];
+    _Atomic uint64_t global;
+
+    /* writer thread only */
+    discord_epoch_retired *retired;
+    size_t pending;
+} discord_epoch;
+
+discord_epoch *epoch_init(void);
+
+int epoch_register(discord_epoch *);
+void epoch_unregister(discord_epoch *, int);
+
+void epoch_enter(discord_epoch *, int);
+void epoch_exit(discord_epoch *, int);
+
+bool epoch_retire(discord_epoch *, void *, void (*)(void *));
+size_t epoch_collect(discord_epoch *);
+
+void epoch_free(discord_epoch *);
+
+#endif
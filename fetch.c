@@ -0,0 +1,289 @@
+#include "fetch.h"
+
+#include "state.h"
+
+static const logctx *logger = NULL;
+
+static discord_http_response *perform_request(discord_http *http, const discord_fetch_request *request){
+    switch (request->kind){
+    case FETCH_USER:
+        return http_get_user(http, request->id);
+    default:
+        return NULL;
+    }
+}
+
+static int run_fetcher(void *ptr){
+    discord_fetcher *fetcher = ptr;
+
+    mtx_lock(&fetcher->lock);
+
+    while (fetcher->running){
+        if (!fetcher->queue){
+            cnd_wait(&fetcher->ready, &fetcher->lock);
+
+            continue;
+        }
+
+        discord_fetch_request *request = fetcher->queue;
+
+        fetcher->queue = request->next;
+
+        if (!fetcher->queue){
+            fetcher->queue_tail = NULL;
+        }
+
+        mtx_unlock(&fetcher->lock);
+
+        /* the lock is never held across the network */
+        discord_http_response *res = perform_request(fetcher->http, request);
+
+        if (res){
+            request->status = res->status;
+            request->data = json_object_get(res->data);
+
+            http_response_free(res);
+        }
+        else {
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] run_fetcher() - request for %" PRIu64 " failed\n",
+                __FILE__,
+                request->id
+            );
+        }
+
+        mtx_lock(&fetcher->lock);
+
+        request->next = fetcher->completed;
+        fetcher->completed = request;
+
+        void (*wake)(void *) = fetcher->wake;
+        void *context = fetcher->context;
+
+        mtx_unlock(&fetcher->lock);
+
+        if (wake){
+            wake(context);
+        }
+
+        mtx_lock(&fetcher->lock);
+    }
+
+    mtx_unlock(&fetcher->lock);
+
+    return 0;
+}
+
+/* opts should share the main client's global limiter and breaker so fetches count against them */
+discord_fetcher *fetch_init(const char *token, const discord_http_options *opts){
+    logger = opts ? opts->log : NULL;
+
+    discord_fetcher *fetcher = calloc(1, sizeof(*fetcher));
+
+    if (!fetcher){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] fetch_init() - fetcher alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    /* a separate client so the worker never shares curl state with the caller */
+    fetcher->http = http_init(token, opts);
+
+    if (!fetcher->http){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] fetch_init() - http initialization failed\n",
+            __FILE__
+        );
+
+        free(fetcher);
+
+        return NULL;
+    }
+
+    if (mtx_init(&fetcher->lock, mtx_plain) != thrd_success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] fetch_init() - mtx_init call failed\n",
+            __FILE__
+        );
+
+        http_free(fetcher->http);
+        free(fetcher);
+
+        return NULL;
+    }
+
+    if (cnd_init(&fetcher->ready) != thrd_success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] fetch_init() - cnd_init call failed\n",
+            __FILE__
+        );
+
+        mtx_destroy(&fetcher->lock);
+
+        http_free(fetcher->http);
+        free(fetcher);
+
+        return NULL;
+    }
+
+    fetcher->running = true;
+
+    if (thrd_create(&fetcher->thread, run_fetcher, fetcher) != thrd_success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] fetch_init() - thrd_create call failed\n",
+            __FILE__
+        );
+
+        cnd_destroy(&fetcher->ready);
+        mtx_destroy(&fetcher->lock);
+
+        http_free(fetcher->http);
+        free(fetcher);
+
+        return NULL;
+    }
+
+    return fetcher;
+}
+
+void fetch_set_wake(discord_fetcher *fetcher, void (*wake)(void *), void *context){
+    if (!fetcher){
+        return;
+    }
+
+    mtx_lock(&fetcher->lock);
+
+    fetcher->wake = wake;
+    fetcher->context = context;
+
+    mtx_unlock(&fetcher->lock);
+}
+
+bool fetch_submit(discord_fetcher *fetcher, discord_fetch_kind kind, snowflake id){
+    if (!fetcher){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] fetch_submit() - fetcher is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    discord_fetch_request *request = calloc(1, sizeof(*request));
+
+    if (!request){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] fetch_submit() - request alloc failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    request->kind = kind;
+    request->id = id;
+
+    mtx_lock(&fetcher->lock);
+
+    if (fetcher->queue_tail){
+        fetcher->queue_tail->next = request;
+    }
+    else {
+        fetcher->queue = request;
+    }
+
+    fetcher->queue_tail = request;
+
+    cnd_signal(&fetcher->ready);
+    mtx_unlock(&fetcher->lock);
+
+    return true;
+}
+
+/* detaches everything completed so far -- the caller frees each request */
+discord_fetch_request *fetch_take_completed(discord_fetcher *fetcher){
+    if (!fetcher){
+        return NULL;
+    }
+
+    mtx_lock(&fetcher->lock);
+
+    discord_fetch_request *completed = fetcher->completed;
+
+    fetcher->completed = NULL;
+
+    mtx_unlock(&fetcher->lock);
+
+    return completed;
+}
+
+void fetch_request_free(discord_fetch_request *request){
+    if (!request){
+        return;
+    }
+
+    json_object_put(request->data);
+
+    free(request);
+}
+
+static void free_requests(discord_fetch_request *request){
+    while (request){
+        discord_fetch_request *next = request->next;
+
+        fetch_request_free(request);
+
+        request = next;
+    }
+}
+
+void fetch_free(discord_fetcher *fetcher){
+    if (!fetcher){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] fetch_free() - fetcher is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    mtx_lock(&fetcher->lock);
+
+    fetcher->running = false;
+
+    cnd_signal(&fetcher->ready);
+    mtx_unlock(&fetcher->lock);
+
+    /* waits out a request already in flight */
+    thrd_join(fetcher->thread, NULL);
+
+    free_requests(fetcher->queue);
+    free_requests(fetcher->completed);
+
+    cnd_destroy(&fetcher->ready);
+    mtx_destroy(&fetcher->lock);
+
+    http_free(fetcher->http);
+    free(fetcher);
+}
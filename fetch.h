@@ -0,0 +1,61 @@
+#ifndef FETCH_H
+#define FETCH_H
+
+#include "log.h"
+#include "snowflake.h"
+
+#include <stdbool.h>
+#include <threads.h>
+
+#include <json-c/json.h>
+
+typedef struct discord_http discord_http;
+typedef struct discord_http_options discord_http_options;
+
+typedef enum discord_fetch_kind {
+    FETCH_USER
+} discord_fetch_kind;
+
+typedef struct discord_fetch_request {
+    discord_fetch_kind kind;
+    snowflake id;
+
+    /* filled in by the worker -- data is NULL if the request never completed */
+    long status;
+    json_object *data;
+
+    struct discord_fetch_request *next;
+} discord_fetch_request;
+
+/*
+ * a worker thread with its own http client -- the state thread queues ids,
+ * the worker fetches them and hands the responses back through wake
+ */
+typedef struct discord_fetcher {
+    discord_http *http;
+
+    thrd_t thread;
+    mtx_t lock;
+    cnd_t ready;
+    bool running;
+
+    discord_fetch_request *queue;
+    discord_fetch_request *queue_tail;
+    discord_fetch_request *completed;
+
+    /* called from the worker after a response is queued -- must be thread safe */
+    void (*wake)(void *);
+    void *context;
+} discord_fetcher;
+
+discord_fetcher *fetch_init(const char *, const discord_http_options *);
+
+void fetch_set_wake(discord_fetcher *, void (*)(void *), void *);
+
+bool fetch_submit(discord_fetcher *, discord_fetch_kind, snowflake);
+discord_fetch_request *fetch_take_completed(discord_fetcher *);
+void fetch_request_free(discord_fetch_request *);
+
+void fetch_free(discord_fetcher *);
+
+#endif
@@ -295,6 +295,40 @@ static discord_gateway_event get_gateway_event_callback(discord_gateway *gateway
     return event;
 }
 
+static bool get_snowflake_field(json_object *data, const char *key, snowflake *id){
+    const char *idstr = json_object_get_string(
+        json_object_object_get(data, key)
+    );
+
+    if (!idstr){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] get_snowflake_field() - failed to get %s from data: %s\n",
+            __FILE__,
+            key,
+            json_object_to_json_string(data)
+        );
+
+        return false;
+    }
+
+    if (!snowflake_from_string(idstr, id)){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] get_snowflake_field() - snowflake_from_string call failed for %s: %s\n",
+            __FILE__,
+            key,
+            idstr
+        );
+
+        return false;
+    }
+
+    return true;
+}
+
 static bool handle_gateway_dispatch(discord_gateway *gateway, const char *name, json_object *data){
     log_write(
         logger,
@@ -316,6 +350,8 @@ static bool handle_gateway_dispatch(discord_gateway *gateway, const char *name,
     }
 
     const void *eventdata = NULL;
+    snowflake eventid = 0;
+    discord_presence_event presence = {0};
 
     if (!strcmp(name, "READY")){
         const discord_user *user = state_set_user(
@@ -334,7 +370,7 @@ static bool handle_gateway_dispatch(discord_gateway *gateway, const char *name,
             return false;
         }
 
-        gateway->state->user = user;
+        state_hold_user(gateway->state, &gateway->state->user, user);
         *gateway->state->user_pointer = user;
 
         const char *sessionid = json_object_get_string(json_object_object_get(data, "session_id"));
@@ -359,79 +395,294 @@ static bool handle_gateway_dispatch(discord_gateway *gateway, const char *name,
 
         eventdata = gateway->state->user;
     }
-    else if (!strcmp(name, "GUILD_CREATE")){
-        /* set guild up for cache */
+    else if (!strcmp(name, "GUILD_CREATE") || !strcmp(name, "GUILD_UPDATE")){
+        const discord_guild *guild = state_set_guild(gateway->state, data);
+
+        if (!guild){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] handle_gateway_dispatch() - state_set_guild call failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        json_object *members = json_object_object_get(data, "members");
+
+        for (size_t index = 0; index < json_object_array_length(members); ++index){
+            json_object *obj = json_object_array_get_idx(members, index);
+
+            if (!state_set_member(gateway->state, guild->id, obj)){
+                log_write(
+                    logger,
+                    LOG_WARNING,
+                    "[%s] handle_gateway_dispatch() - state_set_member call failed for %s\n",
+                    __FILE__,
+                    json_object_to_json_string(obj)
+                );
+            }
+        }
+
+        json_object *roles = json_object_object_get(data, "roles");
+
+        for (size_t index = 0; index < json_object_array_length(roles); ++index){
+            json_object *obj = json_object_array_get_idx(roles, index);
+
+            if (!state_set_role(gateway->state, guild->id, obj)){
+                log_write(
+                    logger,
+                    LOG_WARNING,
+                    "[%s] handle_gateway_dispatch() - state_set_role call failed for %s\n",
+                    __FILE__,
+                    json_object_to_json_string(obj)
+                );
+            }
+        }
+
+        json_object *channels = json_object_object_get(data, "channels");
+
+        for (size_t index = 0; index < json_object_array_length(channels); ++index){
+            json_object *obj = json_object_array_get_idx(channels, index);
+
+            if (!state_set_channel(gateway->state, guild->id, obj)){
+                log_write(
+                    logger,
+                    LOG_WARNING,
+                    "[%s] handle_gateway_dispatch() - state_set_channel call failed for %s\n",
+                    __FILE__,
+                    json_object_to_json_string(obj)
+                );
+            }
+        }
+
+        json_object *presences = json_object_object_get(data, "presences");
+
+        for (size_t index = 0; index < json_object_array_length(presences); ++index){
+            state_set_member_presence(
+                gateway->state,
+                guild->id,
+                json_object_array_get_idx(presences, index),
+                NULL
+            );
+        }
+
+        json_object *emojis = json_object_object_get(data, "emojis");
+
+        for (size_t index = 0; index < json_object_array_length(emojis); ++index){
+            json_object *obj = json_object_array_get_idx(emojis, index);
+
+            if (!state_set_emoji(gateway->state, obj)){
+                log_write(
+                    logger,
+                    LOG_WARNING,
+                    "[%s] handle_gateway_dispatch() - state_set_emoji call failed for %s\n",
+                    __FILE__,
+                    json_object_to_json_string(obj)
+                );
+            }
+        }
+
+        eventdata = guild;
     }
-    else if (!strcmp(name, "MESSAGE_CREATE")){
-        const discord_message *message = state_set_message(gateway->state, data, false);
+    else if (!strcmp(name, "GUILD_DELETE")){
+        if (!get_snowflake_field(data, "id", &eventid)){
+            return false;
+        }
 
-        if (!message){
+        /* unavailable guilds are only offline -- keep their cache for the outage */
+        if (!json_object_get_boolean(json_object_object_get(data, "unavailable"))){
+            state_remove_guild(gateway->state, eventid);
+        }
+
+        eventdata = &eventid;
+    }
+    else if (!strcmp(name, "USER_UPDATE")){
+        const discord_user *user = state_set_user(gateway->state, data);
+
+        if (!user){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] handle_gateway_dispatch() - state_set_message call failed\n",
+                "[%s] handle_gateway_dispatch() - state_set_user call failed\n",
                 __FILE__
             );
 
             return false;
         }
 
-        eventdata = message;
+        eventdata = user;
     }
-    else if (!strcmp(name, "MESSAGE_UPDATE")){
-        const discord_message *message = state_set_message(gateway->state, data, true);
+    else if (!strcmp(name, "GUILD_MEMBER_ADD") || !strcmp(name, "GUILD_MEMBER_UPDATE")){
+        snowflake guildid = 0;
 
-        if (!message){
+        if (!get_snowflake_field(data, "guild_id", &guildid)){
+            return false;
+        }
+
+        const discord_member *member = state_set_member(gateway->state, guildid, data);
+
+        if (!member){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] handle_gateway_dispatch() - state_set_message call failed\n",
+                "[%s] handle_gateway_dispatch() - state_set_member call failed\n",
                 __FILE__
             );
 
             return false;
         }
 
-        eventdata = message;
+        eventdata = member;
     }
-    else if (!strcmp(name, "MESSAGE_DELETE")){
-        const char *idstr = json_object_get_string(
-            json_object_object_get(data, "id")
+    else if (!strcmp(name, "GUILD_MEMBER_REMOVE")){
+        snowflake guildid = 0;
+
+        if (!get_snowflake_field(data, "guild_id", &guildid)){
+            return false;
+        }
+
+        const discord_user *user = state_set_user(
+            gateway->state,
+            json_object_object_get(data, "user")
         );
 
-        if (!idstr){
+        if (!user){
             log_write(
                 logger,
-                LOG_WARNING,
-                "[%s] id_from_message_object() - failed to get id from data: %s\n",
-                __FILE__,
-                json_object_to_json_string(data)
+                LOG_ERROR,
+                "[%s] handle_gateway_dispatch() - state_set_user call failed\n",
+                __FILE__
             );
 
             return false;
         }
 
-        snowflake id = 0;
-        bool success = snowflake_from_string(idstr, &id);
+        state_remove_member(gateway->state, guildid, user->id);
+        presence_remove(gateway->state->presences, guildid, user->id);
 
-        if (!success){
+        eventdata = user;
+    }
+    else if (!strcmp(name, "GUILD_ROLE_CREATE") || !strcmp(name, "GUILD_ROLE_UPDATE")){
+        snowflake guildid = 0;
+
+        if (!get_snowflake_field(data, "guild_id", &guildid)){
+            return false;
+        }
+
+        const discord_role *role = state_set_role(
+            gateway->state,
+            guildid,
+            json_object_object_get(data, "role")
+        );
+
+        if (!role){
             log_write(
                 logger,
-                LOG_WARNING,
-                "[%s] id_from_message_object() - snowflake_from_string call failed for id: %s\n",
-                __FILE__,
-                idstr
+                LOG_ERROR,
+                "[%s] handle_gateway_dispatch() - state_set_role call failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        eventdata = role;
+    }
+    else if (!strcmp(name, "GUILD_ROLE_DELETE")){
+        if (!get_snowflake_field(data, "role_id", &eventid)){
+            return false;
+        }
+
+        eventdata = &eventid;
+    }
+    else if (!strcmp(name, "CHANNEL_CREATE") || !strcmp(name, "CHANNEL_UPDATE")){
+        const discord_channel *channel = state_set_channel(gateway->state, 0, data);
+
+        if (!channel){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] handle_gateway_dispatch() - state_set_channel call failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        eventdata = channel;
+    }
+    else if (!strcmp(name, "CHANNEL_DELETE")){
+        if (!get_snowflake_field(data, "id", &eventid)){
+            return false;
+        }
+
+        eventdata = &eventid;
+    }
+    else if (!strcmp(name, "PRESENCE_UPDATE")){
+        snowflake guildid = 0;
+
+        if (!get_snowflake_field(data, "guild_id", &guildid)){
+            return false;
+        }
+
+        if (!state_set_member_presence(gateway->state, guildid, data, &presence)){
+            return false;
+        }
+
+        eventdata = &presence;
+    }
+    else if (!strcmp(name, "MESSAGE_CREATE")){
+        const discord_message *message = state_set_message(gateway->state, data, false);
+
+        if (!message){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] handle_gateway_dispatch() - state_set_message call failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        eventdata = message;
+    }
+    else if (!strcmp(name, "MESSAGE_UPDATE")){
+        const discord_message *message = state_set_message(gateway->state, data, true);
+
+        if (!message){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] handle_gateway_dispatch() - state_set_message call failed\n",
+                __FILE__
             );
 
             return false;
         }
 
-        eventdata = &id;
+        eventdata = message;
+    }
+    else if (!strcmp(name, "MESSAGE_DELETE")){
+        if (!get_snowflake_field(data, "id", &eventid)){
+            return false;
+        }
+
+        eventdata = &eventid;
+    }
+    else if (!strcmp(name, "MESSAGE_DELETE_BULK")){
+        eventdata = data;
     }
 
     discord_gateway_event event = get_gateway_event_callback(gateway, name);
+    bool success = true;
 
-    if (!event){
+    if (event){
+        success = event(gateway->state->event_context, eventdata);
+    }
+    else {
         log_write(
             logger,
             LOG_DEBUG,
@@ -439,11 +690,42 @@ static bool handle_gateway_dispatch(discord_gateway *gateway, const char *name,
             __FILE__,
             name
         );
+    }
 
-        return true;
+    /* deleted entities stay readable from the callback */
+    if (!strcmp(name, "MESSAGE_DELETE")){
+        state_remove_message(gateway->state, eventid);
+    }
+    else if (!strcmp(name, "CHANNEL_DELETE")){
+        state_remove_channel(gateway->state, eventid);
     }
+    else if (!strcmp(name, "GUILD_ROLE_DELETE")){
+        snowflake guildid = 0;
 
-    return event(gateway->state->event_context, eventdata);
+        if (get_snowflake_field(data, "guild_id", &guildid)){
+            state_remove_role(gateway->state, guildid, eventid);
+        }
+    }
+    else if (!strcmp(name, "MESSAGE_DELETE_BULK")){
+        json_object *ids = json_object_object_get(data, "ids");
+
+        for (size_t index = 0; index < json_object_array_length(ids); ++index){
+            snowflake id = 0;
+
+            if (snowflake_from_string(json_object_get_string(json_object_array_get_idx(ids, index)), &id)){
+                state_remove_message(gateway->state, id);
+            }
+        }
+    }
+
+    /* replicas get the event's mutations as one batch */
+    state_flush_journal(gateway->state);
+
+    /* evict only once the callback is done with eventdata */
+    state_trim(gateway->state);
+    state_reclaim(gateway->state);
+
+    return success;
 }
 
 static bool handle_gateway_payload(discord_gateway *gateway){
@@ -719,6 +1001,30 @@ static bool handle_gateway_receive(discord_gateway *gateway, struct lws *wsi, vo
     return last_frag ? handle_gateway_payload(gateway) : true;
 }
 
+/* lws_cancel_service is the one lws call that is safe from another thread */
+static void wake_gateway(void *context){
+    lws_cancel_service(context);
+}
+
+static void service_http(lws_sorted_usec_list_t *sul){
+    discord_gateway *gateway = lws_container_of(sul, discord_gateway, http_timer);
+
+    http_process(gateway->state->http);
+}
+
+/* curl's sockets are polled from an lws timer so replies complete between gateway events */
+static void schedule_http(void *context, long timeout){
+    discord_gateway *gateway = context;
+
+    lws_sul_schedule(
+        gateway->context,
+        0,
+        &gateway->http_timer,
+        service_http,
+        timeout * LWS_US_PER_MS
+    );
+}
+
 int handle_gateway_event(struct lws *wsi, enum lws_callback_reasons reason, void *user, void *data, size_t datalen){
     if (user){
         /* ignored for now */
@@ -795,6 +1101,11 @@ int handle_gateway_event(struct lws *wsi, enum lws_callback_reasons reason, void
 
         closeconn = true;
 
+        break;
+    case LWS_CALLBACK_EVENT_WAIT_CANCELLED:
+        /* woken by the background fetcher */
+        state_process_fetches(gateway->state);
+
         break;
     case LWS_CALLBACK_TIMER:
         log_write(
@@ -1164,6 +1475,9 @@ discord_gateway *gateway_init(discord_state *state, const discord_gateway_option
         return NULL;
     }
 
+    fetch_set_wake(gateway->state->fetcher, wake_gateway, gateway->context);
+    http_set_scheduler(gateway->state->http, schedule_http, gateway);
+
     return gateway;
 }
 
@@ -1487,6 +1801,11 @@ void gateway_free(discord_gateway *gateway){
 
     list_free(gateway->queue);
 
+    /* the state (and its http) may already be gone -- just drop the timer */
+    if (gateway->context){
+        lws_sul_cancel(&gateway->http_timer);
+    }
+
     lws_context_destroy(gateway->context);
 
     free(gateway->endpoint);
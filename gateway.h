@@ -73,6 +73,9 @@ typedef struct discord_gateway {
     struct lws *wsi;
     list *queue;
     gateway_receive_buffer *buffer;
+
+    /* drives the state's asynchronous REST transfers */
+    lws_sorted_usec_list_t http_timer;
 } discord_gateway;
 
 discord_gateway *gateway_init(discord_state *, const discord_gateway_options *);
@@ -91,6 +91,8 @@ static bool construct_guild(discord_guild *guild){
             //success = construct_guild_emojis(guild, valueobj);
         }
         else if (!strcmp(key, "features")){
+            state_retire_list(guild->state, guild->features);
+
             guild->features = json_array_to_list(valueobj);
 
             success = guild->features;
@@ -216,6 +218,31 @@ static bool construct_guild(discord_guild *guild){
     return success;
 }
 
+static bool compact_guild(discord_guild *guild){
+    const char **fields[] = {
+        &guild->name,
+        &guild->icon,
+        &guild->icon_hash,
+        &guild->splash,
+        &guild->discovery_splash,
+        &guild->permissions,
+        &guild->joined_at,
+        &guild->vanity_url_code,
+        &guild->description,
+        &guild->banner,
+        &guild->preferred_locale
+    };
+
+    return compact_object(
+        guild->state,
+        &guild->compact,
+        &guild->raw_object,
+        fields,
+        sizeof(fields) / sizeof(*fields),
+        0
+    );
+}
+
 discord_guild *guild_init(discord_state *state, json_object *data){
     if (!state){
         log_write(
@@ -255,7 +282,7 @@ discord_guild *guild_init(discord_state *state, json_object *data){
     }
 
     guild->state = state;
-    guild->raw_object = data;
+    guild->raw_object = json_object_get(data);
 
     if (!construct_guild(guild)){
         guild_free(guild);
@@ -263,9 +290,80 @@ discord_guild *guild_init(discord_state *state, json_object *data){
         return NULL;
     }
 
+    if (state->compact && !compact_guild(guild)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] guild_init() - compact_guild call failed\n",
+            __FILE__
+        );
+
+        guild_free(guild);
+
+        return NULL;
+    }
+
     return guild;
 }
 
+bool guild_update(discord_guild *guild, json_object *data){
+    if (!guild){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] guild_update() - guild is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] guild_update() - data is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!state_merge_object(guild->state, &guild->raw_object, data)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] guild_update() - state_merge_object call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!construct_guild(guild)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] guild_update() - construct_guild call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (guild->state->compact && !compact_guild(guild)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] guild_update() - compact_guild call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return true;
+}
+
 void guild_free(void *ptr){
     discord_guild *guild = ptr;
 
@@ -282,6 +380,8 @@ void guild_free(void *ptr){
 
     json_object_put(guild->raw_object);
 
+    compact_release(guild->state, &guild->compact);
+
     map_free(guild->roles);
     list_free(guild->emojis);
     list_free(guild->features);
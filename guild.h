@@ -53,6 +53,7 @@ typedef enum discord_guild_nsfw_level {
 typedef struct discord_guild {
     discord_state *state;
     json_object *raw_object;
+    discord_compact compact;
 
     snowflake id;
     const char *name;
@@ -63,6 +64,10 @@ typedef struct discord_guild {
     bool owner;
     snowflake owner_id;
     const char *permissions;
+
+    /* bumped whenever something feeding its members' permissions changes */
+    uint64_t permission_generation;
+
     snowflake afk_channel_id;
     int afk_timeout;
     bool widget_enabled;
@@ -107,6 +112,7 @@ typedef struct discord_guild {
 } discord_guild;
 
 discord_guild *guild_init(discord_state *, json_object *);
+bool guild_update(discord_guild *, json_object *);
 
 void guild_free(void *);
 
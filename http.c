@@ -3,7 +3,10 @@
 #include "log.h"
 #include "str.h"
 
+#include <ctype.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <threads.h>
 #include <time.h>
 
 #include <curl/curl.h>
@@ -13,336 +16,556 @@ static const logctx *logger = NULL;
 struct responsestr {
     char *data;
     size_t length;
+    size_t capacity;
 };
 
-static bool is_rate_limited(discord_http *http, const char *bucket){
-    if (!http){
+typedef struct discord_http_transfer {
+    CURL *handle;
+    char *route;
+    discord_ratelimit_bucket *bucket;
+
+    const struct curl_slist *requestheaders;
+    struct curl_slist reasonheader;
+    char reason[sizeof("X-Audit-Log-Reason: ") + DISCORD_HTTP_REASON_LENGTH];
+
+    discord_http_ratelimit_headers ratelimit;
+    struct responsestr rawheaders;
+
+    json_tokener *tokener;
+    json_object *data;
+    size_t received;
+    bool malformed;
+
+    discord_http_callback callback;
+    void *context;
+    double deadline;
+
+    struct discord_http_transfer *prev;
+    struct discord_http_transfer *next;
+
+    /* next request waiting on the same bucket */
+    struct discord_http_transfer *queuenext;
+} discord_http_transfer;
+
+static CURL *acquire_handle(discord_http *http){
+    CURL *handle = NULL;
+
+    if (http->pooled){
+        handle = http->pool[--http->pooled];
+
+        /* options don't carry over -- the connection cache does */
+        curl_easy_reset(handle);
+    }
+    else {
+        handle = curl_easy_init();
+
+        if (!handle){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] acquire_handle() - curl_easy_init call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+    }
+
+    if (curl_easy_setopt(handle, CURLOPT_SHARE, http->share) != CURLE_OK){
         log_write(
             logger,
-            LOG_ERROR,
-            "[%s] get_rate_limit() - http is NULL\n",
+            LOG_WARNING,
+            "[%s] acquire_handle() - failed to set CURLOPT_SHARE\n",
             __FILE__
         );
-
-        return true;
     }
-    else if (!bucket){
+
+    if (curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L) != CURLE_OK){
         log_write(
             logger,
-            LOG_ERROR,
-            "[%s] is_rate_limited() - bucket is NULL\n",
+            LOG_WARNING,
+            "[%s] acquire_handle() - failed to set CURLOPT_TCP_KEEPALIVE\n",
             __FILE__
         );
-
-        return true;
     }
 
-    if (http->globalratelimit){
-        bucket = "global";
+    /* "" offers every encoding curl was built with -- it decodes before our writer sees the data */
+    if (curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "") != CURLE_OK){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] acquire_handle() - failed to set CURLOPT_ACCEPT_ENCODING\n",
+            __FILE__
+        );
     }
 
-    size_t bucketlen = strlen(bucket);
-    double retryafter = map_get_double(http->buckets, bucketlen, bucket);
-
-    if (retryafter){
-        time_t curr = time(NULL);
-        time_t diff = retryafter - curr;
-
-        if (retryafter >= curr){
+    if (http->http2){
+        if (curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS) != CURLE_OK){
             log_write(
                 logger,
                 LOG_WARNING,
-                "[%s] is_rate_limited() - rate limit expires in %lu seconds (bucket: %s)\n",
-                __FILE__,
-                diff,
-                bucket
+                "[%s] acquire_handle() - failed to set CURLOPT_HTTP_VERSION\n",
+                __FILE__
             );
-
-            return true;
         }
 
-        map_remove(http->buckets, bucketlen, bucket);
+        /* wait for a connection being set up to multiplex on rather than opening another */
+        if (curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L) != CURLE_OK){
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] acquire_handle() - failed to set CURLOPT_PIPEWAIT\n",
+                __FILE__
+            );
+        }
     }
 
-    http->ratelimited = false;
-    http->globalratelimit = false;
+    return handle;
+}
 
-    return false;
+static void release_handle(discord_http *http, CURL *handle){
+    if (http->pooled < DISCORD_HTTP_POOL_SIZE){
+        http->pool[http->pooled++] = handle;
+    }
+    else {
+        curl_easy_cleanup(handle);
+    }
 }
 
-static bool set_rate_limited(discord_http *http, const char *bucket, double retryafter){
-    if (!http){
+static json_tokener *acquire_tokener(discord_http *http){
+    if (http->idletokeners){
+        json_tokener *tokener = http->tokeners[--http->idletokeners];
+
+        json_tokener_reset(tokener);
+
+        return tokener;
+    }
+
+    json_tokener *tokener = json_tokener_new();
+
+    if (!tokener){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] set_rate_limited() - http is NULL\n",
+            "[%s] acquire_tokener() - json_tokener_new call failed\n",
             __FILE__
         );
 
-        return false;
-    }
-
-    if (http->globalratelimit){
-        bucket = "global";
+        return NULL;
     }
 
-    map_item k = {0};
-    k.type = M_TYPE_STRING;
-    k.size = strlen(bucket);
-    k.data_copy = bucket;
+    return tokener;
+}
 
-    map_item v = {0};
-    v.type = M_TYPE_DOUBLE;
-    v.size = sizeof(retryafter);
-    v.data_copy = &retryafter;
+static void release_tokener(discord_http *http, json_tokener *tokener){
+    if (http->idletokeners < DISCORD_HTTP_POOL_SIZE){
+        http->tokeners[http->idletokeners++] = tokener;
+    }
+    else {
+        json_tokener_free(tokener);
+    }
+}
 
-    bool success = map_set(http->buckets, &k, &v);
+static CURLSH *create_share(void){
+    CURLSH *share = curl_share_init();
 
-    if (!success){
+    if (!share){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] set_rate_limited() - failed to store bucket rate limit\n",
+            "[%s] create_share() - curl_share_init call failed\n",
             __FILE__
         );
+
+        return NULL;
     }
 
-    http->ratelimited = true;
+    const curl_lock_data shared[] = {
+        CURL_LOCK_DATA_DNS,
+        CURL_LOCK_DATA_SSL_SESSION,
+        CURL_LOCK_DATA_CONNECT
+    };
 
-    return success;
-}
+    for (size_t index = 0; index < sizeof(shared) / sizeof(*shared); ++index){
+        CURLSHcode err = curl_share_setopt(share, CURLSHOPT_SHARE, shared[index]);
 
-static size_t write_response_headers(char *data, size_t size, size_t nitems, void *out){
-    size *= nitems;
-    map *m = out;
+        if (err != CURLSHE_OK){
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] create_share() - failed to share lock data %d: %s\n",
+                __FILE__,
+                shared[index],
+                curl_share_strerror(err)
+            );
+        }
+    }
 
-    list *parts = string_split_len(data, size, ": ", 1);
+    return share;
+}
 
-    if (!parts){
-        log_write(
-            logger,
-            LOG_ERROR,
-            "[%s] write_response_headers() - string_split_len call failed\n",
-            __FILE__
-        );
+static double get_request_delay(const discord_http *http, const discord_ratelimit_bucket *bucket, double now){
+    double delay = ratelimit_get_delay(bucket, now);
+    double global = ratelimit_global_get_delay(http->global, now);
 
-        return 0;
+    if (global > delay){
+        delay = global;
     }
-    else if (list_get_length(parts) != 2){
-        list_free(parts);
 
-        return size;
+    if (http->globalreset - now > delay){
+        delay = http->globalreset - now;
     }
 
-    const char *key = list_get_string(parts, 0);
-    const char *value = list_get_string(parts, 1);
+    double breaker = ratelimit_breaker_get_delay(http->breaker, now);
 
-    map_item k = {0};
-    k.type = M_TYPE_STRING;
-    k.size = strlen(key);
-    k.data_copy = key;
+    if (breaker > delay){
+        delay = breaker;
+    }
 
-    map_item v = {0};
-    v.type = M_TYPE_STRING;
-    v.size = strlen(value) - 2;
-    v.data_copy = value;
+    return delay;
+}
 
-    bool success = map_set(m, &k, &v);
+static void check_breaker(discord_http *http, double now){
+    discord_ratelimit_breaker_state state = ratelimit_breaker_get_state(http->breaker, now);
 
-    list_free(parts);
+    if (state == http->breakerstate){
+        return;
+    }
 
-    if (!success){
-        log_write(
-            logger,
-            LOG_ERROR,
-            "[%s] write_response_headers() - map_set call failed\n",
-            __FILE__
-        );
+    size_t count = ratelimit_breaker_get_count(http->breaker, now);
 
-        return 0;
+    log_write(
+        logger,
+        state == BREAKER_CLOSED ? LOG_DEBUG : LOG_WARNING,
+        "[%s] check_breaker() - invalid request breaker %s (%zu invalid requests in window)\n",
+        __FILE__,
+        state == BREAKER_OPEN ? "halted requests" : (state == BREAKER_THROTTLED ? "is throttling requests" : "closed"),
+        count
+    );
+
+    http->breakerstate = state;
+
+    if (http->on_breaker){
+        http->on_breaker(http->event_context, state, count);
     }
+}
 
-    return size;
+static void wait_for_rate_limit(double delay){
+    struct timespec duration = {0};
+    duration.tv_sec = delay;
+    duration.tv_nsec = (delay - duration.tv_sec) * 1e9;
+
+    /* resume after signals with whatever time is left */
+    while (thrd_sleep(&duration, &duration) == -1);
 }
 
-static size_t write_response_data(char *data, size_t length, size_t nmemb, void *out){
-    length *= nmemb;
-    struct responsestr *res = out;
+static bool append_response(struct responsestr *res, const char *data, size_t length){
+    if (res->length + length + 1 > res->capacity){
+        size_t capacity = res->capacity ? res->capacity : 256;
 
-    char *tmp = realloc(res->data, res->length + length + 1);
+        while (capacity < res->length + length + 1){
+            capacity *= 2;
+        }
 
-    if (!tmp){
-        log_write(
-            logger,
-            LOG_ERROR,
-            "[%s] write_response_data() - buffer data realloc failed\n",
-            __FILE__
-        );
+        char *tmp = realloc(res->data, capacity);
 
-        return 0;
+        if (!tmp){
+            return false;
+        }
+
+        res->data = tmp;
+        res->capacity = capacity;
     }
 
-    memcpy(tmp + res->length, data, length);
+    memcpy(res->data + res->length, data, length);
 
-    res->data = tmp;
     res->length += length;
     res->data[res->length] = '\0';
 
-    return length;
+    return true;
 }
 
-static char *create_request_bucket(const char *path){
-    if (!path){
+static void reset_ratelimit_headers(discord_http_ratelimit_headers *headers){
+    headers->limit = -1;
+    headers->remaining = -1;
+    headers->resetafter = -1;
+    headers->shared = false;
+    headers->bucket[0] = '\0';
+}
+
+static bool is_header(const char *name, size_t length, const char *known){
+    if (strlen(known) != length){
+        return false;
+    }
+
+    for (size_t index = 0; index < length; ++index){
+        if (tolower((unsigned char)name[index]) != known[index]){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void copy_header_value(char *buffer, size_t size, const char *value, size_t length){
+    if (length >= size){
+        length = size - 1;
+    }
+
+    memcpy(buffer, value, length);
+
+    buffer[length] = '\0';
+}
+
+static void parse_ratelimit_header(discord_http_ratelimit_headers *headers, const char *name, size_t namelen, const char *value, size_t length){
+    /* long enough for any count or duration discord sends */
+    char number[32];
+
+    if (is_header(name, namelen, "x-ratelimit-bucket")){
+        copy_header_value(headers->bucket, sizeof(headers->bucket), value, length);
+    }
+    else if (is_header(name, namelen, "x-ratelimit-limit")){
+        copy_header_value(number, sizeof(number), value, length);
+
+        headers->limit = strtol(number, NULL, 10);
+    }
+    else if (is_header(name, namelen, "x-ratelimit-remaining")){
+        copy_header_value(number, sizeof(number), value, length);
+
+        headers->remaining = strtol(number, NULL, 10);
+    }
+    else if (is_header(name, namelen, "x-ratelimit-reset-after")){
+        copy_header_value(number, sizeof(number), value, length);
+
+        headers->resetafter = strtod(number, NULL);
+    }
+    else if (is_header(name, namelen, "x-ratelimit-scope")){
+        headers->shared = length == strlen("shared") && !memcmp(value, "shared", length);
+    }
+}
+
+static size_t write_response_headers(char *data, size_t size, size_t nitems, void *out){
+    size *= nitems;
+    discord_http_transfer *transfer = out;
+
+    /* each status line starts a new block -- only the final response's headers count */
+    if (size >= strlen("HTTP/") && !memcmp(data, "HTTP/", strlen("HTTP/"))){
+        reset_ratelimit_headers(&transfer->ratelimit);
+
+        transfer->rawheaders.length = 0;
+    }
+
+    if (!append_response(&transfer->rawheaders, data, size)){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_bucket() - path is NULL\n",
+            "[%s] write_response_headers() - append_response call failed\n",
             __FILE__
         );
 
-        return NULL;
+        return 0;
+    }
+
+    const char *colon = memchr(data, ':', size);
+
+    if (!colon){
+        return size;
+    }
+
+    const char *value = colon + 1;
+    const char *end = data + size;
+
+    while (value < end && (*value == ' ' || *value == '\t')){
+        ++value;
+    }
+
+    while (end > value && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ')){
+        --end;
+    }
+
+    parse_ratelimit_header(&transfer->ratelimit, data, colon - data, value, end - value);
+
+    return size;
+}
+
+static size_t write_response_data(char *data, size_t length, size_t nmemb, void *out){
+    length *= nmemb;
+    discord_http_transfer *transfer = out;
+
+    transfer->received += length;
+
+    /* a bad body still lets the transfer finish -- the status code matters more */
+    if (transfer->data || transfer->malformed){
+        return length;
     }
 
-    list *parts = string_split(path, "/", -1);
+    transfer->data = json_tokener_parse_ex(transfer->tokener, data, length);
 
-    if (!parts){
+    enum json_tokener_error err = json_tokener_get_error(transfer->tokener);
+
+    if (!transfer->data && err != json_tokener_continue){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_bucket() - failed to split path string\n",
-            __FILE__
+            "[%s] write_response_data() - json_tokener_parse_ex call failed: %s\n",
+            __FILE__,
+            json_tokener_error_desc(err)
         );
 
-        return NULL;
+        transfer->malformed = true;
     }
 
-    const char *channelid = "NULL";
-    const char *guildid = "NULL";
+    return length;
+}
 
-    if (!strcmp(list_get_string(parts, 1), "channels")){
-        channelid = list_get_string(parts, 2);
-    }
-    else if (!strcmp(list_get_string(parts, 1), "guilds")){
-        guildid = list_get_string(parts, 2);
+static const char *get_method_name(http_method method){
+    switch (method){
+    case HTTP_GET:
+        return "GET";
+    case HTTP_DELETE:
+        return "DELETE";
+    case HTTP_PATCH:
+        return "PATCH";
+    case HTTP_POST:
+        return "POST";
+    case HTTP_PUT:
+        return "PUT";
+    default:
+        return "UNKNOWN";
     }
+}
 
-    char *bucket = string_create("%s:%s:%s", channelid, guildid, path);
-
-    list_free(parts);
-
-    if (!bucket){
+/*
+ * "POST /channels/<id>/messages/<id>" becomes "POST /channels/<id>/messages/:id"
+ * -- the major parameter stays since discord limits each one separately, and
+ * the emoji after "reactions" collapses to ":emoji" the same way ids do
+ */
+static char *create_request_route(http_method method, const char *path, snowflake *major){
+    if (!path){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_bucket() - failed to create bucket string\n",
+            "[%s] create_request_route() - path is NULL\n",
             __FILE__
         );
 
         return NULL;
     }
 
-    return bucket;
-}
+    const char *name = get_method_name(method);
+    size_t namelen = strlen(name);
 
-static struct curl_slist *create_request_header_list(const discord_http *http, const discord_http_request_options *opts){
-    if (!http){
+    /* ":id" at most doubles a one digit segment, ":emoji" always follows "/reactions" */
+    char *route = malloc(namelen + 2 * strlen(path) + 2);
+
+    if (!route){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_header_list() - http is NULL\n",
+            "[%s] create_request_route() - route alloc failed\n",
             __FILE__
         );
 
         return NULL;
     }
 
-    struct curl_slist *headers = NULL;
-    struct curl_slist *tmp = NULL;
+    memcpy(route, name, namelen);
 
-    if (opts){
-        if (opts->data){
-            tmp = curl_slist_append(NULL, "Content-Type: application/json");
+    size_t offset = namelen;
+    route[offset++] = ' ';
 
-            if (!tmp){
-                log_write(
-                    logger,
-                    LOG_ERROR,
-                    "[%s] create_request_header_list() - failed to append content type header\n",
-                    __FILE__
-                );
+    bool hasmajor = false;
+    bool reaction = false;
+    size_t index = 0;
 
-                return NULL;
-            }
+    /* the query string isn't part of the route -- every ?before=... would get its own bucket */
+    const char *pathend = path + strcspn(path, "?");
+
+    *major = 0;
+
+    for (const char *segment = path; segment < pathend && *segment == '/'; ++index){
+        const char *start = segment + 1;
+        const char *end = memchr(start, '/', pathend - start);
 
-            headers = tmp;
+        if (!end){
+            end = pathend;
         }
 
-        if (opts->reason){
-            char *reason = string_create("X-Audit-Log-Reason: %s", opts->reason);
+        size_t length = end - start;
+        bool numeric = length && strspn(start, "0123456789") >= length;
 
-            if (!reason){
-                log_write(
-                    logger,
-                    LOG_ERROR,
-                    "[%s] create_request_header_list() - failed to create reason string\n",
-                    __FILE__
-                );
+        route[offset++] = '/';
 
-                curl_slist_free_all(headers);
+        if (!index){
+            hasmajor = (length == 8 && !strncmp(start, "channels", length))
+                || (length == 6 && !strncmp(start, "guilds", length))
+                || (length == 8 && !strncmp(start, "webhooks", length));
+        }
 
-                return NULL;
+        if (reaction && length){
+            memcpy(route + offset, ":emoji", 6);
+            offset += 6;
+        }
+        else if (numeric && !(index == 1 && hasmajor)){
+            memcpy(route + offset, ":id", 3);
+            offset += 3;
+        }
+        else {
+            if (numeric){
+                *major = strtoull(start, NULL, 10);
             }
 
-            tmp = curl_slist_append(headers, reason);
-
-            free(reason);
+            memcpy(route + offset, start, length);
+            offset += length;
+        }
 
-            if (!tmp){
-                log_write(
-                    logger,
-                    LOG_ERROR,
-                    "[%s] create_request_header_list() - failed to append reason header\n",
-                    __FILE__
-                );
+        reaction = length == 9 && !strncmp(start, "reactions", length);
+        segment = end;
+    }
 
-                curl_slist_free_all(headers);
+    route[offset] = '\0';
 
-                return NULL;
-            }
+    return route;
+}
 
-            headers = tmp;
-        }
+/* a plain memset before free may be optimized away -- volatile stores can't be */
+static void clear_secret(char *secret){
+    for (volatile char *curr = secret; *curr; ++curr){
+        *curr = '\0';
     }
+}
 
-    char *authorization = string_create("Authorization: Bot %s", http->token);
+static struct curl_slist *create_static_header_list(const char *token){
+    struct curl_slist *headers = NULL;
+    struct curl_slist *tmp = NULL;
+
+    char *authorization = string_create("Authorization: Bot %s", token);
 
     if (!authorization){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_header_list() - failed to create authorization string\n",
+            "[%s] create_static_header_list() - failed to create authorization string\n",
             __FILE__
         );
 
-        curl_slist_free_all(headers);
-
         return NULL;
     }
 
     tmp = curl_slist_append(headers, authorization);
 
+    /* curl keeps its own copy -- don't leave another one of the token lying in freed memory */
+    clear_secret(authorization);
     free(authorization);
 
     if (!tmp){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_header_list() - failed to append authorization header\n",
+            "[%s] create_static_header_list() - failed to append authorization header\n",
             __FILE__
         );
 
-        curl_slist_free_all(headers);
-
         return NULL;
     }
 
@@ -354,7 +577,7 @@ static struct curl_slist *create_request_header_list(const discord_http *http, c
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_header_list() - failed to create user agent string\n",
+            "[%s] create_static_header_list() - failed to create user agent string\n",
             __FILE__
         );
 
@@ -371,7 +594,7 @@ static struct curl_slist *create_request_header_list(const discord_http *http, c
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_header_list() - failed to append user agent header\n",
+            "[%s] create_static_header_list() - failed to append user agent header\n",
             __FILE__
         );
 
@@ -388,7 +611,7 @@ static struct curl_slist *create_request_header_list(const discord_http *http, c
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] create_request_header_list() - failed to append accept header\n",
+            "[%s] create_static_header_list() - failed to append accept header\n",
             __FILE__
         );
 
@@ -402,19 +625,82 @@ static struct curl_slist *create_request_header_list(const discord_http *http, c
     return headers;
 }
 
-static bool set_request_method(CURL *handle, http_method method, const discord_http_request_options *opts){
-    if (!handle){
-        log_write(
-            logger,
-            LOG_ERROR,
-            "[%s] set_request_method() - handle is NULL\n",
-            __FILE__
-        );
+/*
+ * per-request headers are nodes owned by the transfer, linked in front of
+ * the lists built by http_init -- nothing here allocates or needs freeing
+ */
+static const struct curl_slist *get_request_header_list(discord_http *http, discord_http_transfer *transfer, const discord_http_request_options *opts){
+    struct curl_slist *headers = http->headers;
 
-        return false;
+    if (!opts){
+        return headers;
     }
 
-    CURLcode err = CURLE_FAILED_INIT;
+    if (opts->data){
+        headers = &http->jsonheaders;
+    }
+
+    if (opts->reason){
+        int length = snprintf(
+            transfer->reason,
+            sizeof(transfer->reason),
+            "X-Audit-Log-Reason: %s",
+            opts->reason
+        );
+
+        if (length < 0){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] get_request_header_list() - failed to format reason header\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+
+        if ((size_t)length >= sizeof(transfer->reason)){
+            size_t prefix = sizeof("X-Audit-Log-Reason: ") - 1;
+            size_t cut = sizeof(transfer->reason) - 1 - prefix;
+
+            /* opts->reason[cut] is the first byte left out -- never keep half of its character */
+            while (cut && ((unsigned char)opts->reason[cut] & 0xc0) == 0x80){
+                --cut;
+            }
+
+            transfer->reason[prefix + cut] = '\0';
+
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] get_request_header_list() - reason cut off at %zu bytes\n",
+                __FILE__,
+                cut
+            );
+        }
+
+        transfer->reasonheader.data = transfer->reason;
+        transfer->reasonheader.next = headers;
+
+        headers = &transfer->reasonheader;
+    }
+
+    return headers;
+}
+
+static bool set_request_method(CURL *handle, http_method method, const discord_http_request_options *opts){
+    if (!handle){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] set_request_method() - handle is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    CURLcode err = CURLE_FAILED_INIT;
 
     if (!opts || !opts->data){
         err = curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, 0);
@@ -444,13 +730,14 @@ static bool set_request_method(CURL *handle, http_method method, const discord_h
             return false;
         }
 
-        err = curl_easy_setopt(handle, CURLOPT_POSTFIELDS, jsonstr);
+        /* copied -- asynchronous callers may drop the json before the body is sent */
+        err = curl_easy_setopt(handle, CURLOPT_COPYPOSTFIELDS, jsonstr);
 
         if (err != CURLE_OK){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] set_request_method() - failed to set CURLOPT_POSTFIELDS\n",
+                "[%s] set_request_method() - failed to set CURLOPT_COPYPOSTFIELDS\n",
                 __FILE__
             );
 
@@ -737,7 +1024,7 @@ static bool set_response_data_writer(CURL *handle, void *out){
     return true;
 }
 
-static discord_http_response *create_response(CURL *handle, map *headers){
+static discord_http_response *create_response(CURL *handle){
     if (!handle){
         log_write(
             logger,
@@ -781,12 +1068,105 @@ static discord_http_response *create_response(CURL *handle, map *headers){
         return NULL;
     }
 
-    response->headers = headers;
-
     return response;
 }
 
-static void handle_response_status(discord_http *http, const char *bucket, const discord_http_response *response){
+static void enqueue_transfer(discord_http *http, discord_http_transfer *transfer){
+    discord_ratelimit_bucket *bucket = transfer->bucket;
+
+    if (bucket->tail){
+        bucket->tail->queuenext = transfer;
+    }
+    else {
+        bucket->head = transfer;
+    }
+
+    bucket->tail = transfer;
+
+    ++bucket->queued;
+    ++http->queued;
+}
+
+static void dequeue_transfer(discord_http *http, discord_http_transfer *prev, discord_http_transfer *transfer){
+    discord_ratelimit_bucket *bucket = transfer->bucket;
+
+    if (prev){
+        prev->queuenext = transfer->queuenext;
+    }
+    else {
+        bucket->head = transfer->queuenext;
+    }
+
+    if (bucket->tail == transfer){
+        bucket->tail = prev;
+    }
+
+    transfer->queuenext = NULL;
+
+    --bucket->queued;
+    --http->queued;
+}
+
+/* a route that turned out to share a bucket takes its waiting requests along, behind the ones already there */
+static void move_queued(discord_http *http, discord_ratelimit_bucket *from, discord_ratelimit_bucket *to, const char *route){
+    discord_http_transfer *prev = NULL;
+    discord_http_transfer *transfer = from->head;
+
+    while (transfer){
+        discord_http_transfer *next = transfer->queuenext;
+
+        if (!strcmp(transfer->route, route)){
+            dequeue_transfer(http, prev, transfer);
+
+            transfer->bucket = to;
+
+            enqueue_transfer(http, transfer);
+        }
+        else {
+            prev = transfer;
+        }
+
+        transfer = next;
+    }
+}
+
+static void update_rate_limit(discord_http *http, const discord_http_transfer *transfer, const discord_http_response *response){
+    const discord_http_ratelimit_headers *headers = &response->ratelimit;
+
+    /* unlimited routes don't send the headers */
+    if (headers->limit < 0 || headers->remaining < 0 || headers->resetafter < 0){
+        return;
+    }
+
+    bool success = ratelimit_update(
+        http->ratelimit,
+        transfer->route,
+        headers->bucket[0] ? headers->bucket : NULL,
+        headers->limit,
+        headers->remaining,
+        ratelimit_get_time() + headers->resetafter
+    );
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] update_rate_limit() - ratelimit_update call failed (route: %s)\n",
+            __FILE__,
+            transfer->route
+        );
+
+        return;
+    }
+
+    discord_ratelimit_bucket *bucket = ratelimit_get_bucket(http->ratelimit, transfer->route, transfer->bucket->major);
+
+    if (bucket && bucket != transfer->bucket && transfer->bucket->head){
+        move_queued(http, transfer->bucket, bucket, transfer->route);
+    }
+}
+
+static void handle_response_status(discord_http *http, const discord_http_transfer *transfer, const discord_http_response *response){
     if (!http){
         log_write(
             logger,
@@ -808,7 +1188,17 @@ static void handle_response_status(discord_http *http, const char *bucket, const
         return;
     }
 
-    bool success = false;
+    update_rate_limit(http, transfer, response);
+
+    /* 429s from a shared resource limit don't count against us */
+    if (response->status != 429 || !response->ratelimit.shared){
+        double now = ratelimit_get_time();
+
+        ratelimit_breaker_record(http->breaker, response->status, now);
+
+        check_breaker(http, now);
+    }
+
     double retryafter = 0;
     json_object *obj = NULL;
 
@@ -917,33 +1307,22 @@ static void handle_response_status(discord_http *http, const char *bucket, const
             break;
         }
 
-        retryafter = json_object_get_double(obj);
+        retryafter = ratelimit_get_time() + json_object_get_double(obj);
         obj = json_object_object_get(response->data, "global");
 
         if (obj && json_object_get_boolean(obj)){
-            http->globalratelimit = true;
+            http->globalreset = retryafter;
         }
-
-        success = set_rate_limited(http, bucket, time(NULL) + retryafter);
-
-        if (!success){
-            log_write(
-                logger,
-                LOG_ERROR,
-                "[%s] handle_response_status() - failed to set rate limit (bucket: %s)",
-                __FILE__,
-                bucket
-            );
-
-            break;
+        else {
+            ratelimit_exhaust(transfer->bucket, retryafter);
         }
 
         log_write(
             logger,
             LOG_WARNING,
-            "[%s] handle_response_status() - rate limit exceeded (bucket: %s)",
+            "[%s] handle_response_status() - rate limit exceeded (route: %s)",
             __FILE__,
-            bucket
+            transfer->route
         );
 
         break;
@@ -976,66 +1355,583 @@ static void handle_response_status(discord_http *http, const char *bucket, const
     log_write(logger, LOG_RAW, "\n");
 }
 
+static void free_transfer(discord_http *http, discord_http_transfer *transfer){
+    if (transfer->handle){
+        release_handle(http, transfer->handle);
+    }
+
+    if (transfer->tokener){
+        release_tokener(http, transfer->tokener);
+    }
+
+    json_object_put(transfer->data);
+
+    free(transfer->rawheaders.data);
+    free(transfer->route);
+    free(transfer);
+}
+
+static discord_http_transfer *create_transfer(discord_http *http, http_method method, const char *path, const discord_http_request_options *opts){
+    discord_http_transfer *transfer = calloc(1, sizeof(*transfer));
+
+    if (!transfer){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - transfer alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    snowflake major = 0;
+
+    transfer->route = create_request_route(method, path, &major);
+
+    if (!transfer->route){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - create_request_route call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    transfer->bucket = ratelimit_get_bucket(http->ratelimit, transfer->route, major);
+
+    if (!transfer->bucket){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - ratelimit_get_bucket call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    transfer->handle = acquire_handle(http);
+
+    if (!transfer->handle){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - acquire_handle call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    if (!set_request_method(transfer->handle, method, opts)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - set_request_method call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    if (!set_request_url(transfer->handle, path)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - set_request_url call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    transfer->requestheaders = get_request_header_list(http, transfer, opts);
+
+    if (!transfer->requestheaders){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - get_request_header_list call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    if (!set_request_headers(transfer->handle, transfer->requestheaders)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - set_request_headers call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    transfer->tokener = acquire_tokener(http);
+
+    if (!transfer->tokener){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - acquire_tokener call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    if (!set_response_data_writer(transfer->handle, transfer)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - set_response_data_writer call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    reset_ratelimit_headers(&transfer->ratelimit);
+
+    if (!set_response_header_writer(transfer->handle, transfer)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] create_transfer() - set_response_header_writer call failed\n",
+            __FILE__
+        );
+
+        free_transfer(http, transfer);
+
+        return NULL;
+    }
+
+    return transfer;
+}
+
+static discord_http_response *finish_transfer(discord_http *http, discord_http_transfer *transfer){
+    discord_http_response *response = create_response(transfer->handle);
+
+    if (!response){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] finish_transfer() - create_response call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    /* the response takes the raw headers over in case someone asks for the map */
+    response->ratelimit = transfer->ratelimit;
+    response->rawheaders = transfer->rawheaders.data;
+    response->rawlength = transfer->rawheaders.length;
+
+    transfer->rawheaders.data = NULL;
+
+    /* the body was parsed while it streamed in */
+    response->data = transfer->data;
+
+    transfer->data = NULL;
+
+    if (transfer->received > 0 && !response->data && !transfer->malformed){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] finish_transfer() - response body ended before its json did\n",
+            __FILE__
+        );
+    }
+
+    handle_response_status(http, transfer, response);
+
+    return response;
+}
+
+/* for requests that never reach curl -- the callback still hears about them */
+static void abandon_transfer(discord_http *http, discord_http_transfer *transfer){
+    if (transfer->callback){
+        transfer->callback(transfer->context, NULL);
+    }
+
+    free_transfer(http, transfer);
+}
+
+static bool start_transfer(discord_http *http, discord_http_transfer *transfer){
+    if (curl_easy_setopt(transfer->handle, CURLOPT_PRIVATE, transfer) != CURLE_OK){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] start_transfer() - failed to set CURLOPT_PRIVATE\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    CURLMcode err = curl_multi_add_handle(http->multi, transfer->handle);
+
+    if (err != CURLM_OK){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] start_transfer() - curl_multi_add_handle call failed: %s\n",
+            __FILE__,
+            curl_multi_strerror(err)
+        );
+
+        return false;
+    }
+
+    transfer->next = http->transfers;
+
+    if (http->transfers){
+        http->transfers->prev = transfer;
+    }
+
+    http->transfers = transfer;
+
+    ++http->active;
+
+    double sent = ratelimit_get_time();
+
+    ratelimit_consume(transfer->bucket, sent);
+    ratelimit_breaker_sent(http->breaker, sent);
+
+    return true;
+}
+
+static void drain_bucket(discord_http *http, discord_ratelimit_bucket *bucket, double now){
+    discord_http_transfer *prev = NULL;
+    discord_http_transfer *transfer = bucket->head;
+
+    while (transfer){
+        discord_http_transfer *next = transfer->queuenext;
+
+        if (transfer->deadline > 0 && transfer->deadline <= now){
+            dequeue_transfer(http, prev, transfer);
+
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] drain_bucket() - dropping request, deadline passed while queued (route: %s)\n",
+                __FILE__,
+                transfer->route
+            );
+
+            abandon_transfer(http, transfer);
+        }
+        else if (!prev && get_request_delay(http, bucket, now) <= 0 && ratelimit_global_acquire(http->global, now)){
+            dequeue_transfer(http, prev, transfer);
+
+            if (!start_transfer(http, transfer)){
+                log_write(
+                    logger,
+                    LOG_ERROR,
+                    "[%s] drain_bucket() - start_transfer call failed\n",
+                    __FILE__
+                );
+
+                abandon_transfer(http, transfer);
+            }
+        }
+        else {
+            prev = transfer;
+        }
+
+        transfer = next;
+    }
+}
+
+static void drain_queues(discord_http *http){
+    if (!http->queued){
+        return;
+    }
+
+    double now = ratelimit_get_time();
+
+    for (discord_ratelimit_bucket *bucket = http->ratelimit->buckets; bucket; bucket = bucket->next){
+        if (bucket->head){
+            drain_bucket(http, bucket, now);
+        }
+    }
+}
+
+/* seconds until the first queued request could be sent or has to be dropped */
+static double get_queue_delay(const discord_http *http){
+    double now = ratelimit_get_time();
+    double delay = -1;
+
+    for (const discord_ratelimit_bucket *bucket = http->ratelimit->buckets; bucket; bucket = bucket->next){
+        if (!bucket->head){
+            continue;
+        }
+
+        double curr = get_request_delay(http, bucket, now);
+
+        /* an expired request is only dropped (and its callback run) when the loop wakes */
+        for (const discord_http_transfer *transfer = bucket->head; transfer; transfer = transfer->queuenext){
+            if (transfer->deadline > 0 && transfer->deadline - now < curr){
+                curr = transfer->deadline - now;
+            }
+        }
+
+        /* a negative delay would read as "no timeout" to the scheduler */
+        if (curr < 0){
+            curr = 0;
+        }
+
+        if (delay < 0 || curr < delay){
+            delay = curr;
+        }
+    }
+
+    return delay;
+}
+
+static void schedule_transfers(discord_http *http){
+    if ((!http->active && !http->queued) || !http->schedule){
+        return;
+    }
+
+    long timeout = -1;
+
+    if (http->active && curl_multi_timeout(http->multi, &timeout) != CURLM_OK){
+        timeout = -1;
+    }
+
+    /* the loop doesn't watch curl's sockets, so never wait longer than one poll */
+    if (http->active && (timeout < 0 || timeout > DISCORD_HTTP_POLL_INTERVAL)){
+        timeout = DISCORD_HTTP_POLL_INTERVAL;
+    }
+
+    if (http->queued){
+        long wait = get_queue_delay(http) * 1000 + 1;
+
+        if (timeout < 0 || wait < timeout){
+            timeout = wait;
+        }
+    }
+
+    http->schedule(http->context, timeout);
+}
+
+static void complete_transfer(discord_http *http, discord_http_transfer *transfer, CURLcode result){
+    curl_multi_remove_handle(http->multi, transfer->handle);
+
+    if (transfer->prev){
+        transfer->prev->next = transfer->next;
+    }
+    else {
+        http->transfers = transfer->next;
+    }
+
+    if (transfer->next){
+        transfer->next->prev = transfer->prev;
+    }
+
+    --http->active;
+
+    discord_http_response *response = NULL;
+
+    if (result == CURLE_OK){
+        response = finish_transfer(http, transfer);
+    }
+    else if (result != CURLE_ABORTED_BY_CALLBACK){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] complete_transfer() - failed to perform request: %s\n",
+            __FILE__,
+            curl_easy_strerror(result)
+        );
+    }
+
+    if (transfer->callback){
+        transfer->callback(transfer->context, response);
+    }
+
+    if (response){
+        http_response_free(response);
+    }
+
+    free_transfer(http, transfer);
+}
+
 discord_http *http_init(const char *token, const discord_http_options *opts){
-    if (!opts){
-        /* unused for now */
+    if (!token){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] http_init() - token is NULL, refusing to initialize\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    if (curl_global_init(CURL_GLOBAL_ALL)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] http_init() - curl_global_init call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    discord_ratelimit *ratelimit = ratelimit_init();
+
+    if (!ratelimit){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] http_init() - ratelimit_init call failed\n",
+            __FILE__
+        );
+
+        curl_global_cleanup();
+
+        return NULL;
+    }
+
+    discord_http *http = calloc(1, sizeof(*http));
+
+    if (!http){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] http_init() - alloc for discord_http failed\n",
+            __FILE__
+        );
+
+        curl_global_cleanup();
+        ratelimit_free(ratelimit);
+
+        return NULL;
+    }
+
+    http->token = token;
+    http->ratelimit = ratelimit;
+    http->on_breaker = opts ? opts->on_breaker : NULL;
+    http->http2 = opts ? opts->http2 : false;
+    http->sharedglobal = opts && opts->global;
+    http->global = http->sharedglobal ? opts->global : ratelimit_global_init(
+        opts ? opts->global_limiter : NULL,
+        opts ? opts->global_rate : 0
+    );
+
+    if (!http->global){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] http_init() - ratelimit_global_init call failed\n",
+            __FILE__
+        );
+
+        http_free(http);
+
+        return NULL;
     }
 
-    if (!token){
+    http->sharedbreaker = opts && opts->breaker;
+    http->breaker = http->sharedbreaker ? opts->breaker : ratelimit_breaker_init();
+
+    if (!http->breaker){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_init() - token is NULL, refusing to initialize\n",
+            "[%s] http_init() - ratelimit_breaker_init call failed\n",
             __FILE__
         );
 
+        http_free(http);
+
         return NULL;
     }
 
-    if (curl_global_init(CURL_GLOBAL_ALL)){
+    http->headers = create_static_header_list(token);
+
+    if (!http->headers){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_init() - curl_global_init call failed\n",
+            "[%s] http_init() - create_static_header_list call failed\n",
             __FILE__
         );
 
+        http_free(http);
+
         return NULL;
     }
 
-    map *buckets = map_init();
+    /* curl only reads header data, so the literal is never written through */
+    http->jsonheaders.data = (char *)"Content-Type: application/json";
+    http->jsonheaders.next = http->headers;
+
+    http->share = create_share();
 
-    if (!buckets){
+    if (!http->share){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_init() - failed to initialize rate limit buckets\n",
+            "[%s] http_init() - create_share call failed\n",
             __FILE__
         );
 
-        curl_global_cleanup();
+        http_free(http);
 
         return NULL;
     }
 
-    discord_http *http = calloc(1, sizeof(*http));
+    http->multi = curl_multi_init();
 
-    if (!http){
+    if (!http->multi){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_init() - alloc for discord_http failed\n",
+            "[%s] http_init() - curl_multi_init call failed\n",
             __FILE__
         );
 
-        curl_global_cleanup();
-        map_free(buckets);
+        http_free(http);
 
         return NULL;
     }
 
-    http->token = token;
-    http->buckets = buckets;
+    if (http->http2 && curl_multi_setopt(http->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX) != CURLM_OK){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] http_init() - failed to enable multiplexing, requests fall back to separate connections\n",
+            __FILE__
+        );
+    }
 
     return http;
 }
@@ -1062,215 +1958,314 @@ discord_http_response *http_request(discord_http *http, http_method method, cons
         return NULL;
     }
 
-    char *bucket = create_request_bucket(path);
+    discord_http_transfer *transfer = create_transfer(http, method, path, opts);
 
-    if (!bucket){
+    if (!transfer){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - create_request_bucket call failed\n",
+            "[%s] http_request() - create_transfer call failed\n",
             __FILE__
         );
 
         return NULL;
     }
 
-    if (is_rate_limited(http, bucket)){
+    discord_ratelimit_bucket *bucket = transfer->bucket;
+
+    /* asynchronous requests already waiting on the bucket go first */
+    drain_bucket(http, bucket, ratelimit_get_time());
+
+    double delay = get_request_delay(http, bucket, ratelimit_get_time());
+
+    /* other processes can take the global token between the check and the acquire */
+    while (bucket->head || delay > 0 || !ratelimit_global_acquire(http->global, ratelimit_get_time())){
+        if (delay > DISCORD_HTTP_MAX_WAIT){
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] http_request() - refusing request, rate limited for %.3f seconds (route: %s)\n",
+                __FILE__,
+                delay,
+                transfer->route
+            );
+
+            http->ratelimited = true;
+
+            schedule_transfers(http);
+            free_transfer(http, transfer);
+
+            return NULL;
+        }
+
+        /* only the queue or the shared global limiter is in the way -- check back after a poll */
+        if (delay <= 0){
+            delay = DISCORD_HTTP_POLL_INTERVAL / 1000.0;
+        }
+
         log_write(
             logger,
-            LOG_WARNING,
-            "[%s] http_request() - refusing request, rate limited (bucket: %s)\n",
+            LOG_DEBUG,
+            "[%s] http_request() - waiting %.3f seconds for rate limit (route: %s, %zu queued ahead)\n",
             __FILE__,
-            (http->globalratelimit ? "global" : bucket)
+            delay,
+            transfer->route,
+            bucket->queued
         );
 
-        free(bucket);
+        wait_for_rate_limit(delay);
 
-        return NULL;
+        drain_bucket(http, bucket, ratelimit_get_time());
+
+        delay = get_request_delay(http, bucket, ratelimit_get_time());
     }
 
-    CURL *handle = curl_easy_init();
+    /* anything started from the queue above is finished by http_process */
+    schedule_transfers(http);
 
-    if (!handle){
+    http->ratelimited = false;
+
+    double sent = ratelimit_get_time();
+
+    ratelimit_consume(transfer->bucket, sent);
+    ratelimit_breaker_sent(http->breaker, sent);
+
+    CURLcode err = curl_easy_perform(transfer->handle);
+
+    if (err != CURLE_OK){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - curl_easy_init call failed\n"
-            __FILE__
+            "[%s] http_request() - failed to perform request: %s\n",
+            __FILE__,
+            curl_easy_strerror(err)
         );
 
-        free(bucket);
+        free_transfer(http, transfer);
 
         return NULL;
     }
 
-    if (!set_request_method(handle, method, opts)){
+    discord_http_response *response = finish_transfer(http, transfer);
+
+    free_transfer(http, transfer);
+
+    return response;
+}
+
+/* the callback runs from http_process, on the thread that owns http */
+bool http_request_async(discord_http *http, http_method method, const char *path, const discord_http_request_options *opts, discord_http_callback callback, void *context){
+    if (!http){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - set_request_method call failed\n",
+            "[%s] http_request_async() - http is NULL\n",
             __FILE__
         );
 
-        curl_easy_cleanup(handle);
-        free(bucket);
-
-        return NULL;
+        return false;
     }
-
-    if (!set_request_url(handle, path)){
+    else if (!path){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - set_request_url call failed\n",
+            "[%s] http_request_async() - path is NULL\n",
             __FILE__
         );
 
-        curl_easy_cleanup(handle);
-        free(bucket);
-
-        return NULL;
+        return false;
     }
 
-    struct curl_slist *requestheaders = create_request_header_list(http, opts);
-
-    if (!requestheaders){
+    else if (http->closing){
         log_write(
             logger,
-            LOG_ERROR,
-            "[%s] http_request() - create_request_header_list call failed\n",
+            LOG_WARNING,
+            "[%s] http_request_async() - refusing request made while http is being freed\n",
             __FILE__
         );
 
-        curl_easy_cleanup(handle);
-        free(bucket);
-
-        return NULL;
+        return false;
     }
 
-    if (!set_request_headers(handle, requestheaders)){
+    discord_http_transfer *transfer = create_transfer(http, method, path, opts);
+
+    if (!transfer){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - set_request_headers call failed\n",
+            "[%s] http_request_async() - create_transfer call failed\n",
             __FILE__
         );
 
-        curl_slist_free_all(requestheaders);
-        curl_easy_cleanup(handle);
-        free(bucket);
-
-        return NULL;
+        return false;
     }
 
-    struct responsestr out = {0};
+    transfer->callback = callback;
+    transfer->context = context;
+
+    double now = ratelimit_get_time();
+
+    if (opts && opts->deadline > 0){
+        transfer->deadline = now + opts->deadline;
+    }
 
-    if (!set_response_data_writer(handle, &out)){
+    /* requests behind a queue or an exhausted bucket wait their turn */
+    if (transfer->bucket->head || get_request_delay(http, transfer->bucket, now) > 0 || !ratelimit_global_acquire(http->global, now)){
+        enqueue_transfer(http, transfer);
+    }
+    else if (!start_transfer(http, transfer)){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - set_response_data_writer call failed\n",
+            "[%s] http_request_async() - start_transfer call failed\n",
             __FILE__
         );
 
-        curl_slist_free_all(requestheaders);
-        curl_easy_cleanup(handle);
-        free(bucket);
+        free_transfer(http, transfer);
 
-        return NULL;
+        return false;
     }
 
-    map *responseheaders = map_init();
+    http->ratelimited = false;
+
+    schedule_transfers(http);
+
+    return true;
+}
 
-    if (!responseheaders){
+/* drops queued and in-flight requests made with context, their callbacks get NULL */
+size_t http_cancel(discord_http *http, const void *context){
+    if (!http){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - map_init call failed\n",
+            "[%s] http_cancel() - http is NULL\n",
             __FILE__
         );
 
-        curl_slist_free_all(requestheaders);
-        curl_easy_cleanup(handle);
-        free(bucket);
+        return 0;
+    }
 
-        return NULL;
+    size_t cancelled = 0;
+
+    for (discord_ratelimit_bucket *bucket = http->ratelimit->buckets; bucket; bucket = bucket->next){
+        discord_http_transfer *prev = NULL;
+        discord_http_transfer *transfer = bucket->head;
+
+        while (transfer){
+            discord_http_transfer *next = transfer->queuenext;
+
+            if (transfer->context == context){
+                dequeue_transfer(http, prev, transfer);
+                abandon_transfer(http, transfer);
+
+                ++cancelled;
+            }
+            else {
+                prev = transfer;
+            }
+
+            transfer = next;
+        }
     }
 
-    if (!set_response_header_writer(handle, responseheaders)){
-        log_write(
-            logger,
-            LOG_ERROR,
-            "[%s] http_request() - set_response_header_writer call failed\n",
-            __FILE__
-        );
+    discord_http_transfer *transfer = http->transfers;
 
-        map_free(responseheaders);
-        curl_slist_free_all(requestheaders);
-        curl_easy_cleanup(handle);
-        free(bucket);
+    while (transfer){
+        discord_http_transfer *next = transfer->next;
 
-        return NULL;
+        if (transfer->context == context){
+            complete_transfer(http, transfer, CURLE_ABORTED_BY_CALLBACK);
+
+            ++cancelled;
+        }
+
+        transfer = next;
+    }
+
+    return cancelled;
+}
+
+void http_set_scheduler(discord_http *http, void (*schedule)(void *, long), void *context){
+    if (!http){
+        return;
     }
 
-    CURLcode err = curl_easy_perform(handle);
+    http->schedule = schedule;
+    http->context = context;
 
-    curl_slist_free_all(requestheaders);
+    schedule_transfers(http);
+}
 
-    if (err != CURLE_OK){
+/* sends queued requests whose buckets have reset, advances in-flight transfers and completes finished ones -- returns how many remain */
+size_t http_process(discord_http *http){
+    if (!http){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - failed to perform request: %s\n",
-            __FILE__,
-            curl_easy_strerror(err)
+            "[%s] http_process() - http is NULL\n",
+            __FILE__
         );
 
-        map_free(responseheaders);
-        curl_easy_cleanup(handle);
-        free(bucket);
-
-        return NULL;
+        return 0;
     }
 
-    discord_http_response *response = create_response(handle, responseheaders);
+    check_breaker(http, ratelimit_get_time());
+    drain_queues(http);
 
-    curl_easy_cleanup(handle);
+    int running = 0;
+    CURLMcode err = curl_multi_perform(http->multi, &running);
 
-    if (!response){
+    if (err != CURLM_OK){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] http_request() - create_response call failed\n",
-            __FILE__
+            "[%s] http_process() - curl_multi_perform call failed: %s\n",
+            __FILE__,
+            curl_multi_strerror(err)
         );
-
-        map_free(responseheaders);
-        free(bucket);
     }
 
-    if (out.length > 0){
-        response->data = json_tokener_parse(out.data);
+    CURLMsg *msg = NULL;
+    int queued = 0;
+
+    while ((msg = curl_multi_info_read(http->multi, &queued))){
+        if (msg->msg != CURLMSG_DONE){
+            continue;
+        }
 
-        free(out.data);
+        /* msg is invalidated once the handle leaves the multi */
+        CURLcode result = msg->data.result;
+        discord_http_transfer *transfer = NULL;
 
-        if (!response->data){
+        if (curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&transfer) != CURLE_OK || !transfer){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] http_request() - json_tokener_parse call failed\n",
+                "[%s] http_process() - failed to get CURLINFO_PRIVATE\n",
                 __FILE__
             );
+
+            curl_multi_remove_handle(http->multi, msg->easy_handle);
+
+            continue;
         }
+
+        complete_transfer(http, transfer, result);
     }
 
-    handle_response_status(http, bucket, response);
+    schedule_transfers(http);
 
-    free(bucket);
+    return http->active + http->queued;
+}
 
-    return response;
+size_t http_get_queued(const discord_http *http){
+    return http ? http->queued : 0;
 }
 
+size_t http_get_invalid_requests(const discord_http *http){
+    return http ? ratelimit_breaker_get_count(http->breaker, ratelimit_get_time()) : 0;
+}
 discord_http_response *http_get_gateway(discord_http *http){
     return http_request(http, HTTP_GET, "/gateway", NULL);
 }
@@ -2052,6 +3047,40 @@ discord_http_response *http_create_message(discord_http *http, snowflake channel
     return response;
 }
 
+bool http_create_message_async(discord_http *http, snowflake channelid, json_object *data, discord_http_callback callback, void *context){
+    char *path = string_create(
+        "/channels/%" PRIu64 "/messages",
+        channelid
+    );
+
+    if (!path){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] http_create_message_async() - string_create call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    discord_http_request_options opts = {0};
+    opts.data = data;
+
+    bool success = http_request_async(
+        http,
+        HTTP_POST,
+        path,
+        &opts,
+        callback,
+        context
+    );
+
+    free(path);
+
+    return success;
+}
+
 discord_http_response *http_edit_message(discord_http *http, snowflake channelid, snowflake messageid, json_object *data){
     char *path = string_create(
         "/channels/%" PRIu64 "/messages/%" PRIu64,
@@ -2337,6 +3366,98 @@ discord_http_response *http_delete_all_reactions_for_emoji(discord_http *http, s
     return response;
 }
 
+static bool set_response_header(map *headers, char *line, size_t length){
+    char *colon = memchr(line, ':', length);
+
+    if (!colon){
+        return true;
+    }
+
+    /* header names are case-insensitive -- the map keys are lowercased */
+    for (char *curr = line; curr < colon; ++curr){
+        *curr = tolower((unsigned char)*curr);
+    }
+
+    const char *value = colon + 1;
+    const char *end = line + length;
+
+    while (value < end && (*value == ' ' || *value == '\t')){
+        ++value;
+    }
+
+    while (end > value && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ')){
+        --end;
+    }
+
+    map_item k = {0};
+    k.type = M_TYPE_STRING;
+    k.size = colon - line;
+    k.data_copy = line;
+
+    map_item v = {0};
+    v.type = M_TYPE_STRING;
+    v.size = end - value;
+    v.data_copy = value;
+
+    return map_set(headers, &k, &v);
+}
+
+map *http_response_get_headers(discord_http_response *response){
+    if (!response){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] http_response_get_headers() - response is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (response->headers){
+        return response->headers;
+    }
+
+    map *headers = map_init();
+
+    if (!headers){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] http_response_get_headers() - map_init call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    char *line = response->rawheaders;
+    char *end = line + response->rawlength;
+
+    while (line && line < end){
+        char *next = memchr(line, '\n', end - line);
+        next = next ? next + 1 : end;
+
+        if (!set_response_header(headers, line, next - line)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] http_response_get_headers() - set_response_header call failed\n",
+                __FILE__
+            );
+
+            map_free(headers);
+
+            return NULL;
+        }
+
+        line = next;
+    }
+
+    response->headers = headers;
+
+    return headers;
+}
+
 void http_response_free(discord_http_response *response){
     if (!response){
         log_write(
@@ -2350,7 +3471,12 @@ void http_response_free(discord_http_response *response){
     }
 
     json_object_put(response->data);
-    map_free(response->headers);
+
+    if (response->headers){
+        map_free(response->headers);
+    }
+
+    free(response->rawheaders);
     free(response);
 }
 
@@ -2366,7 +3492,54 @@ void http_free(discord_http *http){
         return;
     }
 
-    map_free(http->buckets);
+    /*
+     * every queued and in-flight transfer is cancelled so its callback can
+     * release its context -- requests made from those callbacks are refused
+     */
+    http->closing = true;
+
+    for (discord_ratelimit_bucket *bucket = http->ratelimit ? http->ratelimit->buckets : NULL; bucket; bucket = bucket->next){
+        while (bucket->head){
+            discord_http_transfer *transfer = bucket->head;
+
+            dequeue_transfer(http, NULL, transfer);
+            abandon_transfer(http, transfer);
+        }
+    }
+
+    while (http->transfers){
+        complete_transfer(http, http->transfers, CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    if (http->multi){
+        curl_multi_cleanup(http->multi);
+    }
+
+    for (size_t index = 0; index < http->idletokeners; ++index){
+        json_tokener_free(http->tokeners[index]);
+    }
+
+    /* every transfer pointing into these is gone by now */
+    curl_slist_free_all(http->headers);
+
+    /* pooled handles go before the share object they're attached to */
+    for (size_t index = 0; index < http->pooled; ++index){
+        curl_easy_cleanup(http->pool[index]);
+    }
+
+    if (http->share){
+        curl_share_cleanup(http->share);
+    }
+
+    if (http->global && !http->sharedglobal){
+        ratelimit_global_free(http->global);
+    }
+
+    if (http->breaker && !http->sharedbreaker){
+        ratelimit_breaker_free(http->breaker);
+    }
+
+    ratelimit_free(http->ratelimit);
     free(http);
 
     curl_global_cleanup();
@@ -3,11 +3,28 @@
 
 #include "map.h"
 
+#include "ratelimit.h"
 #include "snowflake.h"
 #include "state.h"
 
+#include <curl/curl.h>
 #include <json-c/json.h>
 
+/* idle easy handles kept for reuse -- each holds on to its live connections */
+#define DISCORD_HTTP_POOL_SIZE 8
+
+/* longest wait between polls of in-flight transfers, in milliseconds */
+#define DISCORD_HTTP_POLL_INTERVAL 10
+
+/* synchronous requests sleep through shorter rate limits instead of failing */
+#define DISCORD_HTTP_MAX_WAIT 5
+
+/* bytes of an audit log reason sent along with a request -- discord allows 512 characters */
+#define DISCORD_HTTP_REASON_LENGTH 512
+
+/* bucket hashes are short -- longer ones are cut off */
+#define DISCORD_HTTP_BUCKET_LENGTH 64
+
 typedef enum http_method {
     HTTP_GET,
     HTTP_DELETE,
@@ -19,30 +36,117 @@ typedef enum http_method {
 typedef struct discord_http_request_options {
     json_object *data;
     const char *reason;
+
+    /* seconds an asynchronous request may wait for its bucket, 0 waits indefinitely */
+    double deadline;
 } discord_http_request_options;
 
+/* the headers rate limiting needs, picked out as they arrive -- numbers are -1 when absent */
+typedef struct discord_http_ratelimit_headers {
+    long limit;
+    long remaining;
+    double resetafter;
+
+    bool shared;
+    char bucket[DISCORD_HTTP_BUCKET_LENGTH];
+} discord_http_ratelimit_headers;
+
 typedef struct discord_http_response {
     long status;
-    map *headers;
+    discord_http_ratelimit_headers ratelimit;
     json_object *data;
+
+    /* raw header block, turned into a map by http_response_get_headers on first use */
+    char *rawheaders;
+    size_t rawlength;
+    map *headers;
 } discord_http_response;
 
 typedef struct discord_http_options {
     const logctx *log;
+
+    /* shm_open name for a global limiter shared by processes on the same token */
+    const char *global_limiter;
+    unsigned global_rate;
+
+    discord_ratelimit_breaker_changed on_breaker;
+
+    /*
+     * limiter and breaker of another client on the same token, so both count
+     * toward one budget -- they stay owned by that client, which must outlive
+     * this one. global_limiter and global_rate are ignored when global is set
+     */
+    discord_ratelimit_global *global;
+    discord_ratelimit_breaker *breaker;
+
+    /* multiplex concurrent requests over one http/2 connection */
+    bool http2;
 } discord_http_options;
 
+/* response is NULL if the transfer failed or was cancelled -- it is freed once the callback returns */
+typedef void (*discord_http_callback)(void *, const discord_http_response *);
+
+/*
+ * a discord_http belongs to one thread -- its share object has no lock
+ * callbacks, so threads that need REST each get their own
+ */
 typedef struct discord_http {
     const char *token;
 
+    /* set when the last request was refused for being rate limited */
     bool ratelimited;
-    bool globalratelimit;
-    map *buckets;
+    double globalreset;
+    discord_ratelimit *ratelimit;
+    discord_ratelimit_global *global;
+
+    /* 401, 403 and 429 responses, counted toward cloudflare's ban threshold */
+    discord_ratelimit_breaker *breaker;
+    discord_ratelimit_breaker_state breakerstate;
+    discord_ratelimit_breaker_changed on_breaker;
+    void *event_context;
+
+    /* set when global and breaker were borrowed from another client */
+    bool sharedglobal;
+    bool sharedbreaker;
+
+    /* connections, dns lookups and tls sessions outlive any one request */
+    CURLSH *share;
+    CURL *pool[DISCORD_HTTP_POOL_SIZE];
+    size_t pooled;
+    bool http2;
+
+    /* headers every request sends, built once -- jsonheaders is a content type node in front of them */
+    struct curl_slist *headers;
+    struct curl_slist jsonheaders;
+
+    /* bodies are parsed as they arrive -- idle tokeners wait here for the next transfer */
+    json_tokener *tokeners[DISCORD_HTTP_POOL_SIZE];
+    size_t idletokeners;
+
+    /* asynchronous transfers, advanced by http_process */
+    bool closing;
+    CURLM *multi;
+    struct discord_http_transfer *transfers;
+    size_t active;
+    size_t queued;
+
+    /* asks the owning event loop to call http_process within the given milliseconds */
+    void (*schedule)(void *, long);
+    void *context;
 } discord_http;
 
 discord_http *http_init(const char *, const discord_http_options *);
 
 discord_http_response *http_request(discord_http *, http_method, const char *, const discord_http_request_options *);
 
+bool http_request_async(discord_http *, http_method, const char *, const discord_http_request_options *, discord_http_callback, void *);
+size_t http_cancel(discord_http *, const void *);
+void http_set_scheduler(discord_http *, void (*)(void *, long), void *);
+size_t http_process(discord_http *);
+
+size_t http_get_queued(const discord_http *);
+size_t http_get_invalid_requests(const discord_http *);
+
 /*
  * API calls by type
  */
@@ -89,6 +193,7 @@ discord_http_response *http_get_channel_message(discord_http *, snowflake, snowf
 discord_http_response *http_crosspost_message(discord_http *, snowflake, snowflake);
 
 discord_http_response *http_create_message(discord_http *, snowflake, json_object *);
+bool http_create_message_async(discord_http *, snowflake, json_object *, discord_http_callback, void *);
 discord_http_response *http_edit_message(discord_http *, snowflake, snowflake, json_object *);
 discord_http_response *http_delete_message(discord_http *, snowflake, snowflake, const char *);
 discord_http_response *http_bulk_delete_messages(discord_http *, snowflake, json_object *, const char *);
@@ -100,6 +205,7 @@ discord_http_response *http_delete_user_reaction(discord_http *, snowflake, snow
 discord_http_response *http_delete_all_reactions(discord_http *, snowflake, snowflake);
 discord_http_response *http_delete_all_reactions_for_emoji(discord_http *, snowflake, snowflake, const char *);
 
+map *http_response_get_headers(discord_http_response *);
 void http_response_free(discord_http_response *);
 void http_free(discord_http *);
 
@@ -0,0 +1,250 @@
+#include "intern.h"
+
+#include "log.h"
+#include "str.h"
+
+static uint64_t hash_string(const char *string){
+    /* FNV-1a */
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (const unsigned char *curr = (const unsigned char *)string; *curr; ++curr){
+        hash ^= *curr;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static bool resize_table(discord_intern_table *table, size_t capacity){
+    discord_intern_entry *entries = calloc(capacity, sizeof(*entries));
+
+    if (!entries){
+        DLOG(
+            "[%s] resize_table() - entries alloc failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    size_t mask = capacity - 1;
+
+    for (size_t index = 0; index < table->capacity; ++index){
+        discord_intern_entry *entry = &table->entries[index];
+
+        if (!entry->string){
+            continue;
+        }
+
+        size_t slot = entry->hash & mask;
+
+        while (entries[slot].string){
+            slot = (slot + 1) & mask;
+        }
+
+        entries[slot] = *entry;
+    }
+
+    free(table->entries);
+
+    table->entries = entries;
+    table->capacity = capacity;
+
+    return true;
+}
+
+static discord_intern_entry *find_entry(const discord_intern_table *table, const char *string, uint64_t hash){
+    size_t mask = table->capacity - 1;
+
+    for (size_t slot = hash & mask; table->entries[slot].string; slot = (slot + 1) & mask){
+        discord_intern_entry *entry = &table->entries[slot];
+
+        if (entry->hash == hash && (entry->string == string || !strcmp(entry->string, string))){
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void remove_entry(discord_intern_table *table, size_t hole){
+    size_t mask = table->capacity - 1;
+
+    /* backward shift deletion keeps probe sequences intact without tombstones */
+    for (size_t next = (hole + 1) & mask; table->entries[next].string; next = (next + 1) & mask){
+        size_t home = table->entries[next].hash & mask;
+        bool movable = false;
+
+        if (next > hole){
+            movable = home <= hole || home > next;
+        }
+        else {
+            movable = home <= hole && home > next;
+        }
+
+        if (movable){
+            table->entries[hole] = table->entries[next];
+
+            hole = next;
+        }
+    }
+
+    table->entries[hole].string = NULL;
+    table->entries[hole].hash = 0;
+    table->entries[hole].refs = 0;
+}
+
+discord_intern_table *intern_init(void){
+    discord_intern_table *table = calloc(1, sizeof(*table));
+
+    if (!table){
+        DLOG(
+            "[%s] intern_init() - table alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    if (!resize_table(table, DISCORD_INTERN_INITIAL_CAPACITY)){
+        DLOG(
+            "[%s] intern_init() - resize_table call failed\n",
+            __FILE__
+        );
+
+        intern_free(table);
+
+        return NULL;
+    }
+
+    return table;
+}
+
+const char *intern_acquire(discord_intern_table *table, const char *string){
+    if (!table){
+        DLOG(
+            "[%s] intern_acquire() - table is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!string){
+        return NULL;
+    }
+
+    uint64_t hash = hash_string(string);
+    discord_intern_entry *entry = find_entry(table, string, hash);
+
+    if (entry){
+        ++entry->refs;
+        ++table->references;
+
+        return entry->string;
+    }
+
+    if ((table->length + 1) * 10 >= table->capacity * 7){
+        if (!resize_table(table, table->capacity * 2)){
+            DLOG(
+                "[%s] intern_acquire() - resize_table call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+    }
+
+    char *copy = string_duplicate(string);
+
+    if (!copy){
+        DLOG(
+            "[%s] intern_acquire() - string_duplicate call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    size_t mask = table->capacity - 1;
+    size_t slot = hash & mask;
+
+    while (table->entries[slot].string){
+        slot = (slot + 1) & mask;
+    }
+
+    table->entries[slot].string = copy;
+    table->entries[slot].hash = hash;
+    table->entries[slot].refs = 1;
+
+    ++table->length;
+    ++table->references;
+
+    table->bytes += strlen(copy) + 1;
+
+    return copy;
+}
+
+bool intern_release(discord_intern_table *table, const char *string){
+    if (!table){
+        DLOG(
+            "[%s] intern_release() - table is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!string){
+        return true;
+    }
+
+    uint64_t hash = hash_string(string);
+    discord_intern_entry *entry = find_entry(table, string, hash);
+
+    if (!entry || entry->string != string){
+        DLOG(
+            "[%s] intern_release() - string is not interned: %s\n",
+            __FILE__,
+            string
+        );
+
+        return false;
+    }
+
+    --table->references;
+
+    if (--entry->refs){
+        return true;
+    }
+
+    table->bytes -= strlen(entry->string) + 1;
+    --table->length;
+
+    if (table->string_free){
+        table->string_free(table->context, entry->string);
+    }
+    else {
+        free(entry->string);
+    }
+
+    remove_entry(table, entry - table->entries);
+
+    return true;
+}
+
+void intern_free(discord_intern_table *table){
+    if (!table){
+        DLOG(
+            "[%s] intern_free() - table is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    for (size_t index = 0; index < table->capacity; ++index){
+        free(table->entries[index].string);
+    }
+
+    free(table->entries);
+    free(table);
+}
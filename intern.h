@@ -0,0 +1,36 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DISCORD_INTERN_INITIAL_CAPACITY 256
+
+typedef struct discord_intern_entry {
+    char *string;
+    uint64_t hash;
+    size_t refs;
+} discord_intern_entry;
+
+typedef struct discord_intern_table {
+    discord_intern_entry *entries;
+    size_t capacity;
+    size_t length;
+
+    size_t bytes;
+    size_t references;
+
+    /* optional hook for strings that drop to zero references (defaults to free) */
+    void (*string_free)(void *, char *);
+    void *context;
+} discord_intern_table;
+
+discord_intern_table *intern_init(void);
+
+const char *intern_acquire(discord_intern_table *, const char *);
+bool intern_release(discord_intern_table *, const char *);
+
+void intern_free(discord_intern_table *);
+
+#endif
@@ -0,0 +1,207 @@
+#include "journal.h"
+
+#include "log.h"
+
+#include <stdlib.h>
+
+static bool begin_record(discord_journal *journal, discord_journal_op op, discord_snapshot_kind kind){
+    /* the length is patched in once the payload is written */
+    return snapshot_write_u32(&journal->buffer, 0) &&
+           snapshot_write_u64(&journal->buffer, journal->sequence + 1) &&
+           snapshot_write_u8(&journal->buffer, op) &&
+           snapshot_write_u8(&journal->buffer, kind);
+}
+
+static void end_record(discord_journal *journal, size_t start){
+    uint32_t length = journal->buffer.size - start - sizeof(length);
+
+    for (size_t index = 0; index < sizeof(length); ++index){
+        journal->buffer.data[start + index] = (length >> (index * 8)) & 0xff;
+    }
+
+    ++journal->sequence;
+}
+
+discord_journal *journal_init(void){
+    discord_journal *journal = calloc(1, sizeof(*journal));
+
+    if (!journal){
+        DLOG(
+            "[%s] journal_init() - journal alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    return journal;
+}
+
+bool journal_write_entity(discord_journal *journal, discord_journal_op op, discord_snapshot_kind kind, const void *entity){
+    if (!journal){
+        DLOG(
+            "[%s] journal_write_entity() - journal is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (op == JOURNAL_DELETE){
+        DLOG(
+            "[%s] journal_write_entity() - deletes are written with journal_write_delete\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    size_t start = journal->buffer.size;
+
+    if (!begin_record(journal, op, kind) || !snapshot_write_entity(&journal->buffer, kind, entity)){
+        DLOG(
+            "[%s] journal_write_entity() - failed to encode record\n",
+            __FILE__
+        );
+
+        /* drop the partial record so the stream stays readable */
+        journal->buffer.size = start;
+
+        return false;
+    }
+
+    end_record(journal, start);
+
+    return true;
+}
+
+bool journal_write_delete(discord_journal *journal, discord_snapshot_kind kind, snowflake guildid, snowflake id){
+    if (!journal){
+        DLOG(
+            "[%s] journal_write_delete() - journal is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    size_t start = journal->buffer.size;
+
+    if (!begin_record(journal, JOURNAL_DELETE, kind) || !snapshot_write_u64(&journal->buffer, guildid) || !snapshot_write_u64(&journal->buffer, id)){
+        DLOG(
+            "[%s] journal_write_delete() - failed to encode record\n",
+            __FILE__
+        );
+
+        journal->buffer.size = start;
+
+        return false;
+    }
+
+    end_record(journal, start);
+
+    return true;
+}
+
+/*
+ * returns the bytes taken by the record at the front of data, or 0 if it is
+ * still incomplete -- success is cleared when the record is malformed
+ */
+size_t journal_read_record(const unsigned char *data, size_t size, discord_journal_record *record, bool *success){
+    if (!data || !record || !success){
+        DLOG(
+            "[%s] journal_read_record() - data, record and success are required\n",
+            __FILE__
+        );
+
+        if (success){
+            *success = false;
+        }
+
+        return 0;
+    }
+
+    *success = true;
+
+    discord_snapshot_reader reader = {0};
+    reader.data = data;
+    reader.size = size;
+
+    uint32_t length = 0;
+
+    if (!snapshot_read_u32(&reader, &length) || size - reader.offset < length){
+        return 0;
+    }
+
+    reader.size = reader.offset + length;
+
+    uint8_t op = 0;
+    uint8_t kind = 0;
+
+    *record = (discord_journal_record){0};
+
+    *success = snapshot_read_u64(&reader, &record->sequence) &&
+               snapshot_read_u8(&reader, &op) &&
+               snapshot_read_u8(&reader, &kind);
+
+    record->op = op;
+    record->kind = kind;
+
+    if (*success && op == JOURNAL_DELETE){
+        *success = snapshot_read_u64(&reader, &record->guild_id) && snapshot_read_u64(&reader, &record->id);
+    }
+    else if (*success && (op == JOURNAL_INSERT || op == JOURNAL_UPDATE)){
+        record->data = snapshot_read_entity(&reader, kind);
+
+        *success = record->data;
+    }
+    else {
+        *success = false;
+    }
+
+    if (!*success){
+        DLOG(
+            "[%s] journal_read_record() - malformed record\n",
+            __FILE__
+        );
+
+        journal_record_release(record);
+
+        return 0;
+    }
+
+    return reader.size;
+}
+
+void journal_record_release(discord_journal_record *record){
+    if (!record){
+        return;
+    }
+
+    json_object_put(record->data);
+
+    record->data = NULL;
+}
+
+/* drops flushed records -- sequence numbers keep counting */
+void journal_reset(discord_journal *journal){
+    if (!journal){
+        return;
+    }
+
+    journal->buffer.size = 0;
+}
+
+void journal_free(discord_journal *journal){
+    if (!journal){
+        DLOG(
+            "[%s] journal_free() - journal is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    snapshot_buffer_free(&journal->buffer);
+
+    free(journal);
+}
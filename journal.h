@@ -0,0 +1,55 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "snapshot.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json-c/json.h>
+
+/* record length, sequence, operation and entity kind */
+#define DISCORD_JOURNAL_HEADER_SIZE 14
+
+typedef enum discord_journal_op {
+    JOURNAL_INSERT = 1,
+    JOURNAL_UPDATE,
+    JOURNAL_DELETE
+} discord_journal_op;
+
+/*
+ * an append-only stream of cache mutations -- inserts and updates carry the
+ * whole entity in the snapshot encoding, deletes carry only its key, so a
+ * replica replays them through the same constructors the owner used
+ */
+typedef struct discord_journal {
+    discord_snapshot_buffer buffer;
+    uint64_t sequence;
+} discord_journal;
+
+typedef struct discord_journal_record {
+    uint64_t sequence;
+    discord_journal_op op;
+    discord_snapshot_kind kind;
+
+    /* deletes only */
+    snowflake guild_id;
+    snowflake id;
+
+    /* inserts and updates only -- owned by the record */
+    json_object *data;
+} discord_journal_record;
+
+discord_journal *journal_init(void);
+
+bool journal_write_entity(discord_journal *, discord_journal_op, discord_snapshot_kind, const void *);
+bool journal_write_delete(discord_journal *, discord_snapshot_kind, snowflake, snowflake);
+
+size_t journal_read_record(const unsigned char *, size_t, discord_journal_record *, bool *);
+void journal_record_release(discord_journal_record *);
+
+void journal_reset(discord_journal *);
+void journal_free(discord_journal *);
+
+#endif
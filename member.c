@@ -2,67 +2,104 @@
 
 static const logctx *logger = NULL;
 
+static void free_roles(void *roles){
+    snowflake_set_free(roles);
+}
+
 static bool construct_member_roles(discord_member *member, json_object *data){
+    snowflake_set *roles = snowflake_set_from_json(data);
+
+    if (!roles){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] construct_member_roles() - snowflake_set_from_json call failed for %s\n",
+            __FILE__,
+            json_object_to_json_string(data)
+        );
+
+        return false;
+    }
+
     if (member->roles){
-        list_empty(member->roles);
+        state_retire(member->state, member->roles, free_roles);
     }
-    else {
-        member->roles = list_init();
 
-        if (!member->roles){
-            log_write(
-                logger,
-                LOG_ERROR,
-                "[%s] construct_member_roles() - roles initialization failed\n",
-                __FILE__
-            );
+    member->roles = roles;
 
-            return false;
-        }
+    return true;
+}
+
+static bool is_string_changed(const char *curr, json_object *valueobj){
+    const char *value = json_object_get_string(valueobj);
+
+    if (!curr || !value){
+        return curr != value;
     }
 
-    bool success = true;
+    return strcmp(curr, value);
+}
 
-    for (size_t index = 0; index < json_object_array_length(data); ++index){
-        json_object *obj = json_object_array_get_idx(data, index);
-        const char *objstr = json_object_get_string(obj);
+/* role order in the payload is arbitrary -- compare the sorted sets */
+static bool is_roles_changed(const snowflake_set *roles, json_object *valueobj){
+    snowflake_set *update = snowflake_set_from_json(valueobj);
 
-        snowflake id = 0;
+    if (!update){
+        return true;
+    }
 
-        success = snowflake_from_string(objstr, &id);
+    bool changed = !snowflake_set_equal(roles, update);
 
-        if (!success){
-            log_write(
-                logger,
-                LOG_WARNING,
-                "[%s] construct_member_roles() - snowflake_from_string call failed for %s\n",
-                __FILE__,
-                json_object_to_json_string(obj)
-            );
+    snowflake_set_free(update);
 
-            break;
-        }
+    return changed;
+}
 
-        list_item item = {0};
-        item.type = L_TYPE_UINT;
-        item.size = sizeof(id);
-        item.data_copy = &id;
+static int get_member_changes(const discord_member *member, json_object *data){
+    int changes = 0;
 
-        success = list_append(member->roles, &item);
+    struct json_object_iterator curr = json_object_iter_begin(data);
+    struct json_object_iterator end = json_object_iter_end(data);
 
-        if (!success){
-            log_write(
-                logger,
-                LOG_ERROR,
-                "[%s] construct_member_roles() - list_append call failed\n",
-                __FILE__
-            );
+    while (!json_object_iter_equal(&curr, &end)){
+        const char *key = json_object_iter_peek_name(&curr);
+        json_object *valueobj = json_object_iter_peek_value(&curr);
 
-            break;
+        if (!strcmp(key, "nick") && is_string_changed(member->nick, valueobj)){
+            changes |= MEMBER_FIELD_NICK;
+        }
+        else if (!strcmp(key, "avatar") && is_string_changed(member->avatar, valueobj)){
+            changes |= MEMBER_FIELD_AVATAR;
+        }
+        else if (!strcmp(key, "roles") && is_roles_changed(member->roles, valueobj)){
+            changes |= MEMBER_FIELD_ROLES;
+        }
+        else if (!strcmp(key, "joined_at") && is_string_changed(member->joined_at, valueobj)){
+            changes |= MEMBER_FIELD_JOINED_AT;
+        }
+        else if (!strcmp(key, "premium_since") && is_string_changed(member->premium_since, valueobj)){
+            changes |= MEMBER_FIELD_PREMIUM_SINCE;
         }
+        else if (!strcmp(key, "deaf") && member->deaf != json_object_get_boolean(valueobj)){
+            changes |= MEMBER_FIELD_DEAF;
+        }
+        else if (!strcmp(key, "mute") && member->mute != json_object_get_boolean(valueobj)){
+            changes |= MEMBER_FIELD_MUTE;
+        }
+        else if (!strcmp(key, "pending") && member->pending != json_object_get_boolean(valueobj)){
+            changes |= MEMBER_FIELD_PENDING;
+        }
+        else if (!strcmp(key, "permissions") && is_string_changed(member->permissions, valueobj)){
+            changes |= MEMBER_FIELD_PERMISSIONS;
+        }
+        else if (!strcmp(key, "communication_disabled_until") && is_string_changed(member->communication_disabled_until, valueobj)){
+            changes |= MEMBER_FIELD_COMMUNICATION_DISABLED_UNTIL;
+        }
+
+        json_object_iter_next(&curr);
     }
 
-    return success;
+    return changes;
 }
 
 static bool construct_member(discord_member *member){
@@ -71,39 +108,38 @@ static bool construct_member(discord_member *member){
     struct json_object_iterator curr = json_object_iter_begin(member->raw_object);
     struct json_object_iterator end = json_object_iter_end(member->raw_object);
 
+    /* null values and empty role arrays are applied so updates can clear them */
     while (!json_object_iter_equal(&curr, &end)){
         const char *key = json_object_iter_peek_name(&curr);
         json_object *valueobj = json_object_iter_peek_value(&curr);
-        json_type type = json_object_get_type(valueobj);
 
-        bool skip = false;
-
-        if (!valueobj || type == json_type_null){
-            skip = true;
-        }
-        else if (type == json_type_array){
-            skip = !json_object_array_length(valueobj);
-        }
-
-        if (skip){
-            json_object_iter_next(&curr);
+        if (!strcmp(key, "user")){
+            if (!valueobj){
+                json_object_iter_next(&curr);
 
-            continue;
-        }
+                continue;
+            }
 
-        if (!strcmp(key, "user")){
-            member->user = state_set_user(
+            const discord_user *user = state_set_user(
                 member->state,
                 valueobj
             );
 
-            success = member->user;
+            success = user && state_hold_user(member->state, &member->user, user);
         }
         else if (!strcmp(key, "nick")){
-            member->nick = json_object_get_string(valueobj);
+            success = state_intern_string(
+                member->state,
+                &member->nick,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "avatar")){
-            member->avatar = json_object_get_string(valueobj);
+            success = state_intern_string(
+                member->state,
+                &member->avatar,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "roles")){
             success = construct_member_roles(member, valueobj);
@@ -124,7 +160,11 @@ static bool construct_member(discord_member *member){
             member->pending = json_object_get_boolean(valueobj);
         }
         else if (!strcmp(key, "permissions")){
-            member->permissions = json_object_get_string(valueobj);
+            success = state_intern_string(
+                member->state,
+                &member->permissions,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "communication_disabled_until")){
             member->communication_disabled_until = json_object_get_string(valueobj);
@@ -149,6 +189,26 @@ static bool construct_member(discord_member *member){
     return success;
 }
 
+static bool compact_member(discord_member *member){
+    const char **fields[] = {
+        member->state->strings ? NULL : &member->nick,
+        member->state->strings ? NULL : &member->avatar,
+        &member->joined_at,
+        &member->premium_since,
+        member->state->strings ? NULL : &member->permissions,
+        &member->communication_disabled_until
+    };
+
+    return compact_object(
+        member->state,
+        &member->compact,
+        &member->raw_object,
+        fields,
+        sizeof(fields) / sizeof(*fields),
+        0
+    );
+}
+
 discord_member *member_init(discord_state *state, json_object *data){
     if (!state){
         log_write(
@@ -196,9 +256,100 @@ discord_member *member_init(discord_state *state, json_object *data){
         return NULL;
     }
 
+    if (state->compact && !compact_member(member)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] member_init() - compact_member call failed\n",
+            __FILE__
+        );
+
+        member_free(member);
+
+        return NULL;
+    }
+
     return member;
 }
 
+bool member_update(discord_member *member, json_object *data, int *changes){
+    if (!member){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] member_update() - member is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] member_update() - data is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    int fields = get_member_changes(member, data);
+
+    if (changes){
+        *changes = fields;
+    }
+
+    if (!state_merge_object(member->state, &member->raw_object, data)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] member_update() - state_merge_object call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    /* always reconstructed -- the embedded user object may have changed */
+    if (!construct_member(member)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] member_update() - construct_member call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (member->state->compact && !compact_member(member)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] member_update() - compact_member call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return true;
+}
+
+size_t member_get_size(const discord_member *member){
+    if (!member){
+        return 0;
+    }
+
+    size_t size = sizeof(*member);
+
+    size += cache_get_raw_size(member->raw_object, &member->compact);
+    size += snowflake_set_get_size(member->roles);
+
+    return size;
+}
+
 void member_free(void *memberptr){
     discord_member *member = memberptr;
 
@@ -213,9 +364,18 @@ void member_free(void *memberptr){
         return;
     }
 
+    cache_unlink(&member->state->cache, &member->cache);
+
     json_object_put(member->raw_object);
 
-    list_free(member->roles);
+    compact_release(member->state, &member->compact);
+
+    state_release_string(member->state, member->nick);
+    state_release_string(member->state, member->avatar);
+    state_release_string(member->state, member->permissions);
+    state_hold_user(member->state, &member->user, NULL);
+
+    snowflake_set_free(member->roles);
 
     free(member);
 }
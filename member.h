@@ -5,14 +5,31 @@
 
 #include <json-c/json.h>
 
+typedef enum discord_member_fields {
+    MEMBER_FIELD_NICK = 1,
+    MEMBER_FIELD_AVATAR = 2,
+    MEMBER_FIELD_ROLES = 4,
+    MEMBER_FIELD_JOINED_AT = 8,
+    MEMBER_FIELD_PREMIUM_SINCE = 16,
+    MEMBER_FIELD_DEAF = 32,
+    MEMBER_FIELD_MUTE = 64,
+    MEMBER_FIELD_PENDING = 128,
+    MEMBER_FIELD_PERMISSIONS = 256,
+    MEMBER_FIELD_COMMUNICATION_DISABLED_UNTIL = 512
+} discord_member_fields;
+
 typedef struct discord_member {
     discord_state *state;
     json_object *raw_object;
+    discord_compact compact;
+    discord_cache_node cache;
+
+    snowflake guild_id;
 
     const discord_user *user;
     const char *nick;
     const char *avatar;
-    list *roles;
+    snowflake_set *roles;
     const char *joined_at;
     const char *premium_since;
     bool deaf;
@@ -23,6 +40,9 @@ typedef struct discord_member {
 } discord_member;
 
 discord_member *member_init(discord_state *, json_object *);
+bool member_update(discord_member *, json_object *, int *);
+
+size_t member_get_size(const discord_member *);
 
 void member_free(void *);
 
@@ -71,23 +71,28 @@ static bool construct_message_reference(discord_message *message, json_object *d
     return success;
 }
 
-static bool construct_message_mentions(discord_message *message, json_object *data){
-    if (message->mentions){
-        list_empty(message->mentions);
+static void release_message_mentions(discord_message *message){
+    size_t mentionslen = list_get_length(message->mentions);
+
+    for (size_t index = 0; index < mentionslen; ++index){
+        const discord_user *user = list_get_generic(message->mentions, index);
+
+        state_hold_user(message->state, &user, NULL);
     }
-    else {
-        message->mentions = list_init();
+}
 
-        if (!message->mentions){
-            log_write(
-                logger,
-                LOG_ERROR,
-                "[%s] construct_message_mentions() - mentions initialization failed\n",
-                __FILE__
-            );
+static bool construct_message_mentions(discord_message *message, json_object *data){
+    list *mentions = list_init();
 
-            return false;
-        }
+    if (!mentions){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] construct_message_mentions() - mentions initialization failed\n",
+            __FILE__
+        );
+
+        return false;
     }
 
     bool success = true;
@@ -95,8 +100,9 @@ static bool construct_message_mentions(discord_message *message, json_object *da
     for (size_t index = 0; index < json_object_array_length(data); ++index){
         json_object *obj = json_object_array_get_idx(data, index);
         const discord_user *user = state_set_user(message->state, obj);
+        const discord_user *held = NULL;
 
-        if (!user){
+        if (!user || !state_hold_user(message->state, &held, user)){
             log_write(
                 logger,
                 LOG_ERROR,
@@ -113,7 +119,7 @@ static bool construct_message_mentions(discord_message *message, json_object *da
         item.size = sizeof(*user);
         item.data_copy = user;
 
-        success = list_append(message->mentions, &item);
+        success = list_append(mentions, &item);
 
         if (!success){
             log_write(
@@ -123,30 +129,36 @@ static bool construct_message_mentions(discord_message *message, json_object *da
                 __FILE__
             );
 
+            state_hold_user(message->state, &held, NULL);
+
             break;
         }
     }
 
+    if (message->mentions){
+        release_message_mentions(message);
+
+        state_retire_list(message->state, message->mentions);
+    }
+
+    /* published whole -- a reader never sees it half built */
+    message->mentions = mentions;
+
     return success;
 }
 
 static bool construct_message_mention_roles(discord_message *message, json_object *data){
-    if (message->mention_roles){
-        list_empty(message->mention_roles);
-    }
-    else {
-        message->mention_roles = list_init();
+    list *mention_roles = list_init();
 
-        if (!message->mention_roles){
-            log_write(
-                logger,
-                LOG_ERROR,
-                "[%s] construct_message_mention_roles() - mention_roles initialization failed\n",
-                __FILE__
-            );
+    if (!mention_roles){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] construct_message_mention_roles() - mention_roles initialization failed\n",
+            __FILE__
+        );
 
-            return false;
-        }
+        return false;
     }
 
     bool success = true;
@@ -175,7 +187,7 @@ static bool construct_message_mention_roles(discord_message *message, json_objec
         item.size = sizeof(id);
         item.data_copy = &id;
 
-        success = list_append(message->mention_roles, &item);
+        success = list_append(mention_roles, &item);
 
         if (!success){
             log_write(
@@ -189,26 +201,27 @@ static bool construct_message_mention_roles(discord_message *message, json_objec
         }
     }
 
+    if (message->mention_roles){
+        state_retire_list(message->state, message->mention_roles);
+    }
+
+    message->mention_roles = mention_roles;
+
     return success;
 }
 
 static bool construct_message_mention_channels(discord_message *message, json_object *data){
-    if (message->mention_channels){
-        list_empty(message->mention_channels);
-    }
-    else {
-        message->mention_channels = list_init();
+    list *mention_channels = list_init();
 
-        if (!message->mention_channels){
-            log_write(
-                logger,
-                LOG_ERROR,
-                "[%s] construct_message_mention_channels() - mention_channels initialization failed\n",
-                __FILE__
-            );
+    if (!mention_channels){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] construct_message_mention_channels() - mention_channels initialization failed\n",
+            __FILE__
+        );
 
-            return false;
-        }
+        return false;
     }
 
     bool success = true;
@@ -274,13 +287,15 @@ static bool construct_message_mention_channels(discord_message *message, json_ob
         item.size = sizeof(*cmention);
         item.data = cmention;
 
-        success = list_append(message->mention_roles, &item);
+        item.generic_free = free;
+
+        success = list_append(mention_channels, &item);
 
         if (!success){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] construct_message_mention_roles() - list_append call failed\n",
+                "[%s] construct_message_mention_channels() - list_append call failed\n",
                 __FILE__
             );
 
@@ -292,26 +307,27 @@ static bool construct_message_mention_channels(discord_message *message, json_ob
         free(cmention);
     }
 
+    if (message->mention_channels){
+        state_retire_list(message->state, message->mention_channels);
+    }
+
+    message->mention_channels = mention_channels;
+
     return success;
 }
 
 static bool construct_message_attachments(discord_message *message, json_object *data){
-    if (message->attachments){
-        list_empty(message->attachments);
-    }
-    else {
-        message->attachments = list_init();
+    list *attachments = list_init();
 
-        if (!message->attachments){
-            log_write(
-                logger,
-                LOG_ERROR,
-                "[%s] construct_message_attachments() - attachments initialization failed\n",
-                __FILE__
-            );
+    if (!attachments){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] construct_message_attachments() - attachments initialization failed\n",
+            __FILE__
+        );
 
-            return false;
-        }
+        return false;
     }
 
     bool success = true;
@@ -337,8 +353,9 @@ static bool construct_message_attachments(discord_message *message, json_object
         item.type = L_TYPE_GENERIC;
         item.size = sizeof(*attachment);
         item.data = attachment;
+        item.generic_free = attachment_free;
 
-        success = list_append(message->attachments, &item);
+        success = list_append(attachments, &item);
 
         if (!success){
             log_write(
@@ -354,26 +371,27 @@ static bool construct_message_attachments(discord_message *message, json_object
         }
     }
 
+    if (message->attachments){
+        state_retire_list(message->state, message->attachments);
+    }
+
+    message->attachments = attachments;
+
     return success;
 }
 
 static bool construct_message_reactions(discord_message *message, json_object *data){
-    if (message->reactions){
-        list_empty(message->reactions);
-    }
-    else {
-        message->reactions = list_init();
+    list *reactions = list_init();
 
-        if (!message->reactions){
-            log_write(
-                logger,
-                LOG_ERROR,
-                "[%s] construct_message_reactions() - reactions initialization failed\n",
-                __FILE__
-            );
+    if (!reactions){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] construct_message_reactions() - reactions initialization failed\n",
+            __FILE__
+        );
 
-            return false;
-        }
+        return false;
     }
 
     bool success = true;
@@ -401,7 +419,7 @@ static bool construct_message_reactions(discord_message *message, json_object *d
         item.data = reaction;
         item.generic_free = reaction_free;
 
-        success = list_append(message->reactions, &item);
+        success = list_append(reactions, &item);
 
         if (!success){
             log_write(
@@ -417,6 +435,12 @@ static bool construct_message_reactions(discord_message *message, json_object *d
         }
     }
 
+    if (message->reactions){
+        state_retire_list(message->state, message->reactions);
+    }
+
+    message->reactions = reactions;
+
     return success;
 }
 
@@ -462,13 +486,13 @@ static bool construct_message(discord_message *message){
             success = snowflake_from_string(objstr, &message->guild_id);
         }
         else if (!strcmp(key, "author")){
-            message->author = state_set_user(message->state, valueobj);
+            const discord_user *author = state_set_user(message->state, valueobj);
 
-            success = message->author;
+            success = author && state_hold_user(message->state, &message->author, author);
         }
         else if (!strcmp(key, "member")){
             if (message->member){
-                member_free(message->member);
+                state_retire(message->state, message->member, member_free);
 
                 message->member = NULL;
             }
@@ -508,7 +532,7 @@ static bool construct_message(discord_message *message){
         }
         else if (!strcmp(key, "embeds")){
             if (message->embeds){
-                list_free(message->embeds);
+                state_retire_list(message->state, message->embeds);
             }
 
             message->embeds = embed_list_from_json_array(message->state, valueobj);
@@ -534,7 +558,7 @@ static bool construct_message(discord_message *message){
         }
         else if (!strcmp(key, "activity")){
             if (message->activity){
-                free(message->activity);
+                state_retire(message->state, message->activity, free);
 
                 message->activity = NULL;
             }
@@ -542,6 +566,10 @@ static bool construct_message(discord_message *message){
             success = construct_message_activity(message, valueobj);
         }
         else if (!strcmp(key, "application")){
+            if (message->application){
+                state_retire(message->state, message->application, application_free);
+            }
+
             message->application = application_init(message->state, valueobj);
 
             success = message->application;
@@ -553,7 +581,7 @@ static bool construct_message(discord_message *message){
         }
         else if (!strcmp(key, "message_reference")){
             if (message->reference){
-                free(message->reference);
+                state_retire(message->state, message->reference, free);
 
                 message->reference = NULL;
             }
@@ -564,13 +592,17 @@ static bool construct_message(discord_message *message){
             message->flags = json_object_get_int(valueobj);
         }
         else if (!strcmp(key, "referenced_message")){
-            message->referenced_message = state_set_message(
+            const discord_message *referenced = state_set_message(
                 message->state,
                 valueobj,
                 false
             );
 
-            success = message->referenced_message;
+            success = referenced && state_hold_message(
+                message->state,
+                &message->referenced_message,
+                referenced
+            );
         }
         else if (!strcmp(key, "interaction")){
             // interaction.c ???
@@ -628,6 +660,90 @@ static bool construct_message(discord_message *message){
     return success;
 }
 
+/* embeds and the application still hold their subtrees of the message DOM */
+static size_t get_retained_size(const discord_message *message){
+    size_t size = 0;
+
+    for (size_t index = 0; index < list_get_length(message->embeds); ++index){
+        const discord_embed *embed = list_get_generic(message->embeds, index);
+
+        size += compact_get_json_size(embed->raw_object);
+    }
+
+    if (message->application){
+        size += compact_get_json_size(message->application->raw_object);
+    }
+
+    return size;
+}
+
+static bool compact_message(discord_message *message){
+    size_t mentionslen = list_get_length(message->mention_channels);
+    size_t attachmentslen = list_get_length(message->attachments);
+    size_t count = 5 + mentionslen + 5 * attachmentslen;
+    const char ***fields = calloc(count, sizeof(*fields));
+
+    if (!fields){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] compact_message() - fields alloc failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    fields[0] = &message->content;
+    fields[1] = &message->timestamp;
+    fields[2] = &message->edited_timestamp;
+    fields[3] = &message->nonce;
+    fields[4] = message->activity ? &message->activity->party_id : NULL;
+
+    for (size_t index = 0; index < mentionslen; ++index){
+        discord_message_channel_mention *cmention = list_get_generic(message->mention_channels, index);
+
+        fields[5 + index] = &cmention->name;
+    }
+
+    /* attachments move into the arena too, so they can let go of their subtrees */
+    for (size_t index = 0; index < attachmentslen; ++index){
+        discord_attachment *attachment = list_get_generic(message->attachments, index);
+        const char ***curr = &fields[5 + mentionslen + 5 * index];
+
+        curr[0] = &attachment->filename;
+        curr[1] = &attachment->description;
+        curr[2] = &attachment->content_type;
+        curr[3] = &attachment->url;
+        curr[4] = &attachment->proxy_url;
+    }
+
+    bool success = compact_object(
+        message->state,
+        &message->compact,
+        &message->raw_object,
+        fields,
+        count,
+        get_retained_size(message)
+    );
+
+    free(fields);
+
+    if (!success){
+        return false;
+    }
+
+    for (size_t index = 0; index < attachmentslen; ++index){
+        discord_attachment *attachment = list_get_generic(message->attachments, index);
+
+        state_retire_object(message->state, attachment->raw_object);
+
+        attachment->raw_object = NULL;
+    }
+
+    return true;
+}
+
 discord_message *message_init(discord_state *state, json_object *data){
     if (!state){
         log_write(
@@ -672,7 +788,20 @@ discord_message *message_init(discord_state *state, json_object *data){
     if (!construct_message(message)){
         message_free(message);
 
-        message = NULL;
+        return NULL;
+    }
+
+    if (state->compact && !compact_message(message)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] message_init() - compact_message call failed\n",
+            __FILE__
+        );
+
+        message_free(message);
+
+        return NULL;
     }
 
     return message;
@@ -700,18 +829,33 @@ bool message_update(discord_message *message, json_object *data){
         return false;
     }
 
-    if (!json_merge_objects(data, message->raw_object)){
+    if (!state_merge_object(message->state, &message->raw_object, data)){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] message_update() - json_merge_objects call failed\n",
+            "[%s] message_update() - state_merge_object call failed\n",
             __FILE__
         );
 
         return false;
     }
 
-    return construct_message(message);
+    if (!construct_message(message)){
+        return false;
+    }
+
+    if (message->state->compact && !compact_message(message)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] message_update() - compact_message call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return true;
 }
 
 /* API calls */
@@ -762,6 +906,36 @@ bool message_delete(const discord_message *message, const char *reason){
     return success;
 }
 
+size_t message_get_size(const discord_message *message){
+    if (!message){
+        return 0;
+    }
+
+    size_t size = sizeof(*message);
+
+    size += cache_get_raw_size(message->raw_object, &message->compact);
+    size += member_get_size(message->member);
+
+    size += cache_get_list_size(message->mentions, 0);
+    size += cache_get_list_size(message->mention_roles, sizeof(snowflake));
+    size += cache_get_list_size(message->mention_channels, sizeof(discord_message_channel_mention));
+    size += cache_get_list_size(message->attachments, sizeof(discord_attachment));
+    size += cache_get_list_size(message->embeds, sizeof(discord_embed));
+    size += cache_get_list_size(message->reactions, sizeof(discord_reaction));
+    size += cache_get_list_size(message->components, 0);
+    size += cache_get_list_size(message->sticker_items, 0);
+
+    if (message->activity){
+        size += sizeof(*message->activity);
+    }
+
+    if (message->reference){
+        size += sizeof(*message->reference);
+    }
+
+    return size;
+}
+
 void message_free(void *messageptr){
     discord_message *message = messageptr;
 
@@ -776,11 +950,20 @@ void message_free(void *messageptr){
         return;
     }
 
+    cache_unlink(&message->state->cache, &message->cache);
+
     json_object_put(message->raw_object);
 
+    compact_release(message->state, &message->compact);
+
     /* --- BOOKMARK --- add guild object, guild will have ownership of member */
     member_free(message->member);
 
+    state_hold_user(message->state, &message->author, NULL);
+    state_hold_message(message->state, &message->referenced_message, NULL);
+
+    release_message_mentions(message);
+
     list_free(message->mentions);
     list_free(message->mention_roles);
     list_free(message->mention_channels);
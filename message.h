@@ -91,6 +91,8 @@ typedef struct discord_message_channel_mention {
 typedef struct discord_message {
     discord_state *state;
     json_object *raw_object;
+    discord_compact compact;
+    discord_cache_node cache;
 
     snowflake id;
     snowflake channel_id;
@@ -127,6 +129,8 @@ typedef struct discord_message {
 discord_message *message_init(discord_state *, json_object *);
 bool message_update(discord_message *, json_object *);
 
+size_t message_get_size(const discord_message *);
+
 /* API calls */
 //bool message_edit(discord_message *, params);
 bool message_delete(const discord_message *, const char *);
@@ -0,0 +1,177 @@
+#include "permission.h"
+
+#include "log.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+static discord_permission_memo_entry *get_memo_entry(discord_permission_memo *memo, snowflake guildid, snowflake channelid, snowflake userid){
+    /* the ids share their timestamp bits -- mix before masking */
+    uint64_t hash = (guildid ^ (channelid * 0xc2b2ae3d27d4eb4fULL) ^ (userid * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL;
+
+    return &memo->entries[(hash >> 32) & (DISCORD_PERMISSION_MEMO_SIZE - 1)];
+}
+
+bool permission_from_string(const char *string, discord_permissions *permissions){
+    if (!permissions){
+        DLOG(
+            "[%s] permission_from_string() - permissions is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    *permissions = 0;
+
+    if (!string){
+        return true;
+    }
+
+    char *end = NULL;
+
+    errno = 0;
+
+    unsigned long long value = strtoull(string, &end, 10);
+
+    if (errno || end == string || *end){
+        DLOG(
+            "[%s] permission_from_string() - invalid permission string: %s\n",
+            __FILE__,
+            string
+        );
+
+        return false;
+    }
+
+    *permissions = value;
+
+    return true;
+}
+
+discord_overwrite *overwrite_from_json(json_object *data){
+    discord_overwrite *overwrite = calloc(1, sizeof(*overwrite));
+
+    if (!overwrite){
+        DLOG(
+            "[%s] overwrite_from_json() - overwrite alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const char *idstr = json_object_get_string(json_object_object_get(data, "id"));
+
+    overwrite->type = json_object_get_int(json_object_object_get(data, "type"));
+
+    bool success = snowflake_from_string(idstr, &overwrite->id);
+
+    success = success && permission_from_string(
+        json_object_get_string(json_object_object_get(data, "allow")),
+        &overwrite->allow
+    );
+
+    success = success && permission_from_string(
+        json_object_get_string(json_object_object_get(data, "deny")),
+        &overwrite->deny
+    );
+
+    if (!success){
+        DLOG(
+            "[%s] overwrite_from_json() - malformed overwrite: %s\n",
+            __FILE__,
+            json_object_to_json_string(data)
+        );
+
+        free(overwrite);
+
+        return NULL;
+    }
+
+    return overwrite;
+}
+
+discord_permissions permission_apply_overwrite(discord_permissions permissions, const discord_overwrite *overwrite){
+    if (!overwrite){
+        return permissions;
+    }
+
+    return (permissions & ~overwrite->deny) | overwrite->allow;
+}
+
+discord_permission_memo *permission_memo_init(void){
+    discord_permission_memo *memo = calloc(1, sizeof(*memo));
+
+    if (!memo){
+        DLOG(
+            "[%s] permission_memo_init() - memo alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    return memo;
+}
+
+/* generation is the guild's -- anything it was computed under before is stale */
+bool permission_memo_get(discord_permission_memo *memo, snowflake guildid, snowflake channelid, snowflake userid, uint64_t generation, discord_permissions *permissions){
+    if (!memo || !permissions){
+        return false;
+    }
+
+    discord_permission_memo_entry *entry = get_memo_entry(memo, guildid, channelid, userid);
+    unsigned sequence = atomic_load_explicit(&entry->sequence, memory_order_acquire);
+
+    bool found = !(sequence & 1)
+        && atomic_load_explicit(&entry->guild_id, memory_order_relaxed) == guildid
+        && atomic_load_explicit(&entry->channel_id, memory_order_relaxed) == channelid
+        && atomic_load_explicit(&entry->user_id, memory_order_relaxed) == userid
+        && atomic_load_explicit(&entry->generation, memory_order_relaxed) == generation;
+
+    discord_permissions value = atomic_load_explicit(&entry->permissions, memory_order_relaxed);
+
+    /* a torn entry could belong to anyone -- only trust it if nobody wrote meanwhile */
+    atomic_thread_fence(memory_order_acquire);
+
+    if (!found || atomic_load_explicit(&entry->sequence, memory_order_relaxed) != sequence){
+        atomic_fetch_add_explicit(&memo->misses, 1, memory_order_relaxed);
+
+        return false;
+    }
+
+    atomic_fetch_add_explicit(&memo->hits, 1, memory_order_relaxed);
+
+    *permissions = value;
+
+    return true;
+}
+
+void permission_memo_set(discord_permission_memo *memo, snowflake guildid, snowflake channelid, snowflake userid, uint64_t generation, discord_permissions permissions){
+    if (!memo){
+        return;
+    }
+
+    discord_permission_memo_entry *entry = get_memo_entry(memo, guildid, channelid, userid);
+    unsigned sequence = atomic_load_explicit(&entry->sequence, memory_order_relaxed);
+
+    /* another thread holds the entry -- its result is as good as ours */
+    if ((sequence & 1) || !atomic_compare_exchange_strong_explicit(&entry->sequence, &sequence, sequence + 1, memory_order_relaxed, memory_order_relaxed)){
+        return;
+    }
+
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&entry->guild_id, guildid, memory_order_relaxed);
+    atomic_store_explicit(&entry->channel_id, channelid, memory_order_relaxed);
+    atomic_store_explicit(&entry->user_id, userid, memory_order_relaxed);
+    atomic_store_explicit(&entry->generation, generation, memory_order_relaxed);
+    atomic_store_explicit(&entry->permissions, permissions, memory_order_relaxed);
+
+    atomic_store_explicit(&entry->sequence, sequence + 2, memory_order_release);
+}
+
+void permission_memo_free(discord_permission_memo *memo){
+    free(memo);
+}
@@ -0,0 +1,112 @@
+#ifndef PERMISSION_H
+#define PERMISSION_H
+
+#include "snowflake.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json-c/json.h>
+
+/* bit flags wider than an int can't be enum constants in iso c */
+#define PERMISSION_CREATE_INSTANT_INVITE (UINT64_C(1) << 0)
+#define PERMISSION_KICK_MEMBERS (UINT64_C(1) << 1)
+#define PERMISSION_BAN_MEMBERS (UINT64_C(1) << 2)
+#define PERMISSION_ADMINISTRATOR (UINT64_C(1) << 3)
+#define PERMISSION_MANAGE_CHANNELS (UINT64_C(1) << 4)
+#define PERMISSION_MANAGE_GUILD (UINT64_C(1) << 5)
+#define PERMISSION_ADD_REACTIONS (UINT64_C(1) << 6)
+#define PERMISSION_VIEW_AUDIT_LOG (UINT64_C(1) << 7)
+#define PERMISSION_PRIORITY_SPEAKER (UINT64_C(1) << 8)
+#define PERMISSION_STREAM (UINT64_C(1) << 9)
+#define PERMISSION_VIEW_CHANNEL (UINT64_C(1) << 10)
+#define PERMISSION_SEND_MESSAGES (UINT64_C(1) << 11)
+#define PERMISSION_SEND_TTS_MESSAGES (UINT64_C(1) << 12)
+#define PERMISSION_MANAGE_MESSAGES (UINT64_C(1) << 13)
+#define PERMISSION_EMBED_LINKS (UINT64_C(1) << 14)
+#define PERMISSION_ATTACH_FILES (UINT64_C(1) << 15)
+#define PERMISSION_READ_MESSAGE_HISTORY (UINT64_C(1) << 16)
+#define PERMISSION_MENTION_EVERYONE (UINT64_C(1) << 17)
+#define PERMISSION_USE_EXTERNAL_EMOJIS (UINT64_C(1) << 18)
+#define PERMISSION_VIEW_GUILD_INSIGHTS (UINT64_C(1) << 19)
+#define PERMISSION_CONNECT (UINT64_C(1) << 20)
+#define PERMISSION_SPEAK (UINT64_C(1) << 21)
+#define PERMISSION_MUTE_MEMBERS (UINT64_C(1) << 22)
+#define PERMISSION_DEAFEN_MEMBERS (UINT64_C(1) << 23)
+#define PERMISSION_MOVE_MEMBERS (UINT64_C(1) << 24)
+#define PERMISSION_USE_VAD (UINT64_C(1) << 25)
+#define PERMISSION_CHANGE_NICKNAME (UINT64_C(1) << 26)
+#define PERMISSION_MANAGE_NICKNAMES (UINT64_C(1) << 27)
+#define PERMISSION_MANAGE_ROLES (UINT64_C(1) << 28)
+#define PERMISSION_MANAGE_WEBHOOKS (UINT64_C(1) << 29)
+#define PERMISSION_MANAGE_EMOJIS_AND_STICKERS (UINT64_C(1) << 30)
+#define PERMISSION_USE_APPLICATION_COMMANDS (UINT64_C(1) << 31)
+#define PERMISSION_REQUEST_TO_SPEAK (UINT64_C(1) << 32)
+#define PERMISSION_MANAGE_EVENTS (UINT64_C(1) << 33)
+#define PERMISSION_MANAGE_THREADS (UINT64_C(1) << 34)
+#define PERMISSION_CREATE_PUBLIC_THREADS (UINT64_C(1) << 35)
+#define PERMISSION_CREATE_PRIVATE_THREADS (UINT64_C(1) << 36)
+#define PERMISSION_USE_EXTERNAL_STICKERS (UINT64_C(1) << 37)
+#define PERMISSION_SEND_MESSAGES_IN_THREADS (UINT64_C(1) << 38)
+#define PERMISSION_USE_EMBEDDED_ACTIVITIES (UINT64_C(1) << 39)
+#define PERMISSION_MODERATE_MEMBERS (UINT64_C(1) << 40)
+
+#define PERMISSION_ALL UINT64_MAX
+
+/* direct-mapped, so a colliding lookup just recomputes */
+#define DISCORD_PERMISSION_MEMO_SIZE 4096
+
+typedef uint64_t discord_permissions;
+
+typedef enum discord_overwrite_type {
+    OVERWRITE_ROLE = 0,
+    OVERWRITE_MEMBER = 1
+} discord_overwrite_type;
+
+typedef struct discord_overwrite {
+    snowflake id;
+    discord_overwrite_type type;
+
+    discord_permissions allow;
+    discord_permissions deny;
+} discord_overwrite;
+
+/*
+ * guild-level results keep channel_id 0 -- a legacy default channel shares
+ * its guild's id, so the guild id alone can't tell the two apart
+ *
+ * sequence is odd while a thread is rewriting the entry, readers that see
+ * it change treat the entry as a miss
+ */
+typedef struct discord_permission_memo_entry {
+    atomic_uint sequence;
+
+    _Atomic snowflake guild_id;
+    _Atomic snowflake channel_id;
+    _Atomic snowflake user_id;
+    _Atomic uint64_t generation;
+
+    _Atomic discord_permissions permissions;
+} discord_permission_memo_entry;
+
+/* any thread may read or fill it -- a writer that loses the race just skips */
+typedef struct discord_permission_memo {
+    discord_permission_memo_entry entries[DISCORD_PERMISSION_MEMO_SIZE];
+
+    atomic_size_t hits;
+    atomic_size_t misses;
+} discord_permission_memo;
+
+bool permission_from_string(const char *, discord_permissions *);
+discord_overwrite *overwrite_from_json(json_object *);
+
+discord_permissions permission_apply_overwrite(discord_permissions, const discord_overwrite *);
+
+discord_permission_memo *permission_memo_init(void);
+bool permission_memo_get(discord_permission_memo *, snowflake, snowflake, snowflake, uint64_t, discord_permissions *);
+void permission_memo_set(discord_permission_memo *, snowflake, snowflake, snowflake, uint64_t, discord_permissions);
+void permission_memo_free(discord_permission_memo *);
+
+#endif
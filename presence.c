@@ -0,0 +1,345 @@
+#include "presence.h"
+
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char *clients[CLIENT_TYPE_COUNT] = {
+    "desktop",
+    "mobile",
+    "web"
+};
+
+static void put_activities(void *activities){
+    json_object_put(activities);
+}
+
+static void free_guild(void *ptr){
+    discord_presence_guild *guild = ptr;
+
+    if (!guild){
+        return;
+    }
+
+    snowflake_map_free(guild->statuses);
+
+    if (guild->activities){
+        snowflake_map_free(guild->activities);
+    }
+
+    free(guild);
+}
+
+static discord_status status_from_string(const char *status){
+    if (!status){
+        return STATUS_OFFLINE;
+    }
+    else if (!strcmp(status, "online")){
+        return STATUS_ONLINE;
+    }
+    else if (!strcmp(status, "idle")){
+        return STATUS_IDLE;
+    }
+    else if (!strcmp(status, "dnd")){
+        return STATUS_DND;
+    }
+
+    return STATUS_OFFLINE;
+}
+
+/* slot 0 is the overall status, slot 1 + client type each client's */
+static discord_status unpack_status(uintptr_t packed, size_t slot){
+    return (packed >> (slot * DISCORD_PRESENCE_STATUS_BITS)) & DISCORD_PRESENCE_STATUS_MASK;
+}
+
+static uintptr_t pack_presence(discord_status status, json_object *clientstatus){
+    uintptr_t packed = DISCORD_PRESENCE_PRESENT | status;
+
+    for (size_t index = 0; index < CLIENT_TYPE_COUNT; ++index){
+        discord_status client = status_from_string(
+            json_object_get_string(json_object_object_get(clientstatus, clients[index]))
+        );
+
+        packed |= (uintptr_t)client << ((index + 1) * DISCORD_PRESENCE_STATUS_BITS);
+    }
+
+    return packed;
+}
+
+static discord_presence_guild *get_guild(discord_presence_store *store, snowflake guildid){
+    discord_presence_guild *guild = snowflake_map_get(store->guilds, guildid);
+
+    if (guild){
+        return guild;
+    }
+
+    guild = calloc(1, sizeof(*guild));
+
+    if (!guild){
+        DLOG(
+            "[%s] get_guild() - guild alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    guild->statuses = snowflake_map_init(NULL);
+
+    if (store->keep_activities){
+        guild->activities = snowflake_map_init(put_activities);
+    }
+
+    if (!guild->statuses || (store->keep_activities && !guild->activities) || !snowflake_map_set(store->guilds, guildid, guild)){
+        DLOG(
+            "[%s] get_guild() - guild initialization failed\n",
+            __FILE__
+        );
+
+        free_guild(guild);
+
+        return NULL;
+    }
+
+    return guild;
+}
+
+discord_presence_store *presence_store_init(bool activities){
+    discord_presence_store *store = calloc(1, sizeof(*store));
+
+    if (!store){
+        DLOG(
+            "[%s] presence_store_init() - store alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    store->keep_activities = activities;
+    store->guilds = snowflake_map_init(free_guild);
+
+    if (!store->guilds){
+        DLOG(
+            "[%s] presence_store_init() - guilds map initialization failed\n",
+            __FILE__
+        );
+
+        free(store);
+
+        return NULL;
+    }
+
+    return store;
+}
+
+/* previous is left offline -- only a store knows what the user had before */
+bool presence_read_event(snowflake guildid, json_object *data, discord_presence_event *event){
+    if (!guildid || !data || !event){
+        DLOG(
+            "[%s] presence_read_event() - guild id, data and event are required\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    snowflake userid = 0;
+    const char *idstr = json_object_get_string(
+        json_object_object_get(
+            json_object_object_get(data, "user"),
+            "id"
+        )
+    );
+
+    if (!idstr || !snowflake_from_string(idstr, &userid)){
+        DLOG(
+            "[%s] presence_read_event() - failed to get user id from data\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    event->guild_id = guildid;
+    event->user_id = userid;
+    event->status = status_from_string(
+        json_object_get_string(json_object_object_get(data, "status"))
+    );
+    event->previous = STATUS_OFFLINE;
+
+    return true;
+}
+
+bool presence_update(discord_presence_store *store, snowflake guildid, json_object *data, discord_presence_event *event){
+    if (!store){
+        DLOG(
+            "[%s] presence_update() - store is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    discord_presence_event update = {0};
+
+    if (!presence_read_event(guildid, data, &update)){
+        DLOG(
+            "[%s] presence_update() - presence_read_event call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    discord_presence_guild *guild = get_guild(store, guildid);
+
+    if (!guild){
+        DLOG(
+            "[%s] presence_update() - get_guild call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    snowflake userid = update.user_id;
+    discord_status status = update.status;
+    uintptr_t previous = (uintptr_t)snowflake_map_get(guild->statuses, userid);
+
+    update.previous = unpack_status(previous, 0);
+
+    if (event){
+        *event = update;
+    }
+
+    if (status == STATUS_OFFLINE){
+        if (previous){
+            --guild->counts[update.previous];
+        }
+
+        snowflake_map_remove(guild->statuses, userid);
+        snowflake_map_remove(guild->activities, userid);
+
+        return true;
+    }
+
+    uintptr_t packed = pack_presence(status, json_object_object_get(data, "client_status"));
+
+    if (!snowflake_map_set(guild->statuses, userid, (void *)packed)){
+        DLOG(
+            "[%s] presence_update() - snowflake_map_set call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    /* only once the new status is stored, so a failed set leaves the counts alone */
+    if (previous){
+        --guild->counts[update.previous];
+    }
+
+    ++guild->counts[status];
+
+    if (guild->activities){
+        json_object *activities = json_object_object_get(data, "activities");
+
+        if (json_object_array_length(activities)){
+            snowflake_map_set(guild->activities, userid, json_object_get(activities));
+        }
+        else {
+            snowflake_map_remove(guild->activities, userid);
+        }
+    }
+
+    return true;
+}
+
+bool presence_remove(discord_presence_store *store, snowflake guildid, snowflake userid){
+    if (!store){
+        return false;
+    }
+
+    discord_presence_guild *guild = snowflake_map_get(store->guilds, guildid);
+
+    if (!guild){
+        return false;
+    }
+
+    uintptr_t packed = (uintptr_t)snowflake_map_pop(guild->statuses, userid);
+
+    if (!packed){
+        return false;
+    }
+
+    --guild->counts[unpack_status(packed, 0)];
+
+    snowflake_map_remove(guild->activities, userid);
+
+    return true;
+}
+
+bool presence_remove_guild(discord_presence_store *store, snowflake guildid){
+    if (!store){
+        return false;
+    }
+
+    return snowflake_map_remove(store->guilds, guildid);
+}
+
+discord_status presence_get_status(const discord_presence_store *store, snowflake guildid, snowflake userid){
+    if (!store){
+        return STATUS_OFFLINE;
+    }
+
+    const discord_presence_guild *guild = snowflake_map_get(store->guilds, guildid);
+
+    return guild ? unpack_status((uintptr_t)snowflake_map_get(guild->statuses, userid), 0) : STATUS_OFFLINE;
+}
+
+discord_status presence_get_client_status(const discord_presence_store *store, snowflake guildid, snowflake userid, discord_client_type client){
+    if (!store || client >= CLIENT_TYPE_COUNT){
+        return STATUS_OFFLINE;
+    }
+
+    const discord_presence_guild *guild = snowflake_map_get(store->guilds, guildid);
+
+    return guild ? unpack_status((uintptr_t)snowflake_map_get(guild->statuses, userid), client + 1) : STATUS_OFFLINE;
+}
+
+json_object *presence_get_activities(const discord_presence_store *store, snowflake guildid, snowflake userid){
+    if (!store){
+        return NULL;
+    }
+
+    const discord_presence_guild *guild = snowflake_map_get(store->guilds, guildid);
+
+    return guild ? snowflake_map_get(guild->activities, userid) : NULL;
+}
+
+size_t presence_get_count(const discord_presence_store *store, snowflake guildid, discord_status status){
+    if (!store || status >= STATUS_COUNT){
+        return 0;
+    }
+
+    const discord_presence_guild *guild = snowflake_map_get(store->guilds, guildid);
+
+    return guild ? guild->counts[status] : 0;
+}
+
+void presence_store_free(discord_presence_store *store){
+    if (!store){
+        DLOG(
+            "[%s] presence_store_free() - store is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    snowflake_map_free(store->guilds);
+
+    free(store);
+}
@@ -0,0 +1,78 @@
+#ifndef PRESENCE_H
+#define PRESENCE_H
+
+#include "snowflake.h"
+#include "snowflake_map.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json-c/json.h>
+
+/* fits in two bits -- invisible users are reported as offline */
+typedef enum discord_status {
+    STATUS_OFFLINE,
+    STATUS_ONLINE,
+    STATUS_IDLE,
+    STATUS_DND,
+
+    STATUS_COUNT
+} discord_status;
+
+typedef enum discord_client_type {
+    CLIENT_DESKTOP,
+    CLIENT_MOBILE,
+    CLIENT_WEB,
+
+    CLIENT_TYPE_COUNT
+} discord_client_type;
+
+/*
+ * a presence packs into the low nine bits of the map value: the overall
+ * status in bits 0-1, each client's status in the next pairs (bits 2-7) and
+ * DISCORD_PRESENCE_PRESENT in bit 8 so the pointer is never NULL
+ */
+#define DISCORD_PRESENCE_STATUS_BITS 2
+#define DISCORD_PRESENCE_STATUS_MASK 3
+#define DISCORD_PRESENCE_PRESENT 0x100
+
+typedef struct discord_presence_guild {
+    snowflake_map *statuses;
+
+    /* user id -> activities array, only filled when activities are kept */
+    snowflake_map *activities;
+
+    size_t counts[STATUS_COUNT];
+} discord_presence_guild;
+
+/* offline users aren't stored, so they aren't counted either */
+typedef struct discord_presence_store {
+    snowflake_map *guilds;
+
+    bool keep_activities;
+} discord_presence_store;
+
+typedef struct discord_presence_event {
+    snowflake guild_id;
+    snowflake user_id;
+
+    discord_status status;
+    discord_status previous;
+} discord_presence_event;
+
+discord_presence_store *presence_store_init(bool);
+
+bool presence_read_event(snowflake, json_object *, discord_presence_event *);
+bool presence_update(discord_presence_store *, snowflake, json_object *, discord_presence_event *);
+bool presence_remove(discord_presence_store *, snowflake, snowflake);
+bool presence_remove_guild(discord_presence_store *, snowflake);
+
+discord_status presence_get_status(const discord_presence_store *, snowflake, snowflake);
+discord_status presence_get_client_status(const discord_presence_store *, snowflake, snowflake, discord_client_type);
+json_object *presence_get_activities(const discord_presence_store *, snowflake, snowflake);
+size_t presence_get_count(const discord_presence_store *, snowflake, discord_status);
+
+void presence_store_free(discord_presence_store *);
+
+#endif
@@ -0,0 +1,694 @@
+/* shm_open and ftruncate for the shared global limiter */
+#define _POSIX_C_SOURCE 200809L
+
+#include "ratelimit.h"
+
+#include "log.h"
+#include "str.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t hash_key(const char *key){
+    /* FNV-1a */
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (const unsigned char *curr = (const unsigned char *)key; *curr; ++curr){
+        hash ^= *curr;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static bool resize_table(discord_ratelimit *ratelimit, size_t capacity){
+    discord_ratelimit_entry *entries = calloc(capacity, sizeof(*entries));
+
+    if (!entries){
+        DLOG(
+            "[%s] resize_table() - entries alloc failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    size_t mask = capacity - 1;
+
+    for (size_t index = 0; index < ratelimit->capacity; ++index){
+        discord_ratelimit_entry *entry = &ratelimit->entries[index];
+
+        if (!entry->key){
+            continue;
+        }
+
+        size_t slot = entry->hash & mask;
+
+        while (entries[slot].key){
+            slot = (slot + 1) & mask;
+        }
+
+        entries[slot] = *entry;
+    }
+
+    free(ratelimit->entries);
+
+    ratelimit->entries = entries;
+    ratelimit->capacity = capacity;
+
+    return true;
+}
+
+static discord_ratelimit_entry *find_entry(const discord_ratelimit *ratelimit, const char *key, uint64_t hash){
+    size_t mask = ratelimit->capacity - 1;
+
+    for (size_t slot = hash & mask; ratelimit->entries[slot].key; slot = (slot + 1) & mask){
+        discord_ratelimit_entry *entry = &ratelimit->entries[slot];
+
+        if (entry->hash == hash && !strcmp(entry->key, key)){
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static discord_ratelimit_entry *insert_entry(discord_ratelimit *ratelimit, const char *key, uint64_t hash, discord_ratelimit_bucket *bucket){
+    if ((ratelimit->length + 1) * 10 >= ratelimit->capacity * 7){
+        if (!resize_table(ratelimit, ratelimit->capacity * 2)){
+            DLOG(
+                "[%s] insert_entry() - resize_table call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+    }
+
+    char *copy = string_duplicate(key);
+
+    if (!copy){
+        DLOG(
+            "[%s] insert_entry() - string_duplicate call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    size_t mask = ratelimit->capacity - 1;
+    size_t slot = hash & mask;
+
+    while (ratelimit->entries[slot].key){
+        slot = (slot + 1) & mask;
+    }
+
+    discord_ratelimit_entry *entry = &ratelimit->entries[slot];
+    entry->key = copy;
+    entry->hash = hash;
+    entry->bucket = bucket;
+
+    ++ratelimit->length;
+
+    return entry;
+}
+
+static discord_ratelimit_bucket *create_bucket(discord_ratelimit *ratelimit, snowflake major){
+    discord_ratelimit_bucket *bucket = calloc(1, sizeof(*bucket));
+
+    if (!bucket){
+        DLOG(
+            "[%s] create_bucket() - bucket alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    bucket->major = major;
+    bucket->limit = -1;
+    bucket->remaining = -1;
+
+    bucket->next = ratelimit->buckets;
+    ratelimit->buckets = bucket;
+
+    return bucket;
+}
+
+static discord_ratelimit_global_state *map_global_state(const char *name){
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+
+    if (fd == -1){
+        DLOG(
+            "[%s] map_global_state() - shm_open call failed for %s\n",
+            __FILE__,
+            name
+        );
+
+        return NULL;
+    }
+
+    /* every process sizes the segment the same, so whoever gets here first wins */
+    if (ftruncate(fd, sizeof(discord_ratelimit_global_state)) == -1){
+        DLOG(
+            "[%s] map_global_state() - ftruncate call failed\n",
+            __FILE__
+        );
+
+        close(fd);
+
+        return NULL;
+    }
+
+    void *base = mmap(NULL, sizeof(discord_ratelimit_global_state), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (base == MAP_FAILED){
+        DLOG(
+            "[%s] map_global_state() - mmap call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    return base;
+}
+
+static uint64_t to_microseconds(double seconds){
+    return seconds * 1e6;
+}
+
+static uint64_t get_breaker_period(double now){
+    return now / (DISCORD_RATELIMIT_INVALID_WINDOW / DISCORD_RATELIMIT_INVALID_SLOTS);
+}
+
+double ratelimit_get_time(void){
+    struct timespec ts = {0};
+
+    timespec_get(&ts, TIME_UTC);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+discord_ratelimit *ratelimit_init(void){
+    discord_ratelimit *ratelimit = calloc(1, sizeof(*ratelimit));
+
+    if (!ratelimit){
+        DLOG(
+            "[%s] ratelimit_init() - ratelimit alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    if (!resize_table(ratelimit, DISCORD_RATELIMIT_INITIAL_CAPACITY)){
+        DLOG(
+            "[%s] ratelimit_init() - resize_table call failed\n",
+            __FILE__
+        );
+
+        ratelimit_free(ratelimit);
+
+        return NULL;
+    }
+
+    return ratelimit;
+}
+
+/* routes get a bucket of their own until discord tells us which one they share */
+discord_ratelimit_bucket *ratelimit_get_bucket(discord_ratelimit *ratelimit, const char *route, snowflake major){
+    if (!ratelimit){
+        DLOG(
+            "[%s] ratelimit_get_bucket() - ratelimit is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!route){
+        DLOG(
+            "[%s] ratelimit_get_bucket() - route is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    uint64_t hash = hash_key(route);
+    discord_ratelimit_entry *entry = find_entry(ratelimit, route, hash);
+
+    if (entry){
+        return entry->bucket;
+    }
+
+    discord_ratelimit_bucket *bucket = create_bucket(ratelimit, major);
+
+    if (!bucket){
+        DLOG(
+            "[%s] ratelimit_get_bucket() - create_bucket call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    if (!insert_entry(ratelimit, route, hash, bucket)){
+        DLOG(
+            "[%s] ratelimit_get_bucket() - insert_entry call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    return bucket;
+}
+
+bool ratelimit_update(discord_ratelimit *ratelimit, const char *route, const char *bucketid, long limit, long remaining, double reset){
+    if (!ratelimit){
+        DLOG(
+            "[%s] ratelimit_update() - ratelimit is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!route){
+        DLOG(
+            "[%s] ratelimit_update() - route is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    discord_ratelimit_entry *entry = find_entry(ratelimit, route, hash_key(route));
+
+    if (!entry){
+        DLOG(
+            "[%s] ratelimit_update() - unknown route: %s\n",
+            __FILE__,
+            route
+        );
+
+        return false;
+    }
+
+    discord_ratelimit_bucket *bucket = entry->bucket;
+
+    if (bucketid){
+        char *key = string_create("%s:%" PRIu64, bucketid, bucket->major);
+
+        if (!key){
+            DLOG(
+                "[%s] ratelimit_update() - string_create call failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        uint64_t hash = hash_key(key);
+        discord_ratelimit_entry *shared = find_entry(ratelimit, key, hash);
+
+        if (!shared){
+            /* the first route seen under a bucket hash lends it its bucket -- entry dangles if this grows the table */
+            bool success = insert_entry(ratelimit, key, hash, bucket);
+
+            free(key);
+
+            if (!success){
+                DLOG(
+                    "[%s] ratelimit_update() - insert_entry call failed\n",
+                    __FILE__
+                );
+
+                return false;
+            }
+        }
+        else {
+            free(key);
+
+            entry->bucket = shared->bucket;
+            bucket = shared->bucket;
+        }
+    }
+
+    /* responses can arrive out of order -- within a window the lowest count wins */
+    if (reset > bucket->reset || bucket->remaining < 0 || remaining < bucket->remaining){
+        bucket->remaining = remaining;
+    }
+
+    /* and a late response from an older window can't pull the reset back and reopen the bucket early */
+    if (reset > bucket->reset){
+        bucket->reset = reset;
+    }
+
+    bucket->limit = limit;
+
+    return true;
+}
+
+/* seconds until the bucket lets another request through */
+double ratelimit_get_delay(const discord_ratelimit_bucket *bucket, double now){
+    if (!bucket || bucket->remaining != 0 || bucket->reset <= now){
+        return 0;
+    }
+
+    return bucket->reset - now;
+}
+
+void ratelimit_consume(discord_ratelimit_bucket *bucket, double now){
+    if (!bucket){
+        return;
+    }
+
+    if (bucket->limit > 0 && bucket->reset <= now){
+        bucket->remaining = bucket->limit;
+    }
+
+    if (bucket->remaining > 0){
+        --bucket->remaining;
+    }
+}
+
+void ratelimit_exhaust(discord_ratelimit_bucket *bucket, double reset){
+    if (!bucket){
+        return;
+    }
+
+    bucket->remaining = 0;
+
+    if (reset > bucket->reset){
+        bucket->reset = reset;
+    }
+}
+
+void ratelimit_free(discord_ratelimit *ratelimit){
+    if (!ratelimit){
+        DLOG(
+            "[%s] ratelimit_free() - ratelimit is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    for (size_t index = 0; index < ratelimit->capacity; ++index){
+        free(ratelimit->entries[index].key);
+    }
+
+    discord_ratelimit_bucket *bucket = ratelimit->buckets;
+
+    while (bucket){
+        discord_ratelimit_bucket *next = bucket->next;
+
+        free(bucket);
+
+        bucket = next;
+    }
+
+    free(ratelimit->entries);
+    free(ratelimit);
+}
+
+/* name is an shm_open segment shared with other processes on the token, NULL keeps the limiter private */
+discord_ratelimit_global *ratelimit_global_init(const char *name, unsigned rate){
+    discord_ratelimit_global *global = calloc(1, sizeof(*global));
+
+    if (!global){
+        DLOG(
+            "[%s] ratelimit_global_init() - global alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    if (!rate){
+        rate = DISCORD_RATELIMIT_GLOBAL_RATE;
+    }
+
+    global->interval = 1000000 / rate;
+    global->tolerance = global->interval * (rate - 1);
+
+    if (name){
+        global->state = map_global_state(name);
+        global->mapped = true;
+    }
+    else {
+        global->state = calloc(1, sizeof(*global->state));
+    }
+
+    if (!global->state){
+        DLOG(
+            "[%s] ratelimit_global_init() - failed to allocate limiter state\n",
+            __FILE__
+        );
+
+        free(global);
+
+        return NULL;
+    }
+
+    return global;
+}
+
+double ratelimit_global_get_delay(const discord_ratelimit_global *global, double now){
+    if (!global){
+        return 0;
+    }
+
+    uint64_t tat = atomic_load_explicit(&global->state->tat, memory_order_relaxed);
+    uint64_t allowed = to_microseconds(now) + global->tolerance;
+
+    return tat > allowed ? (tat - allowed) / 1e6 : 0;
+}
+
+/* takes a token if one is free -- other processes may be racing for the same one */
+bool ratelimit_global_acquire(discord_ratelimit_global *global, double now){
+    if (!global){
+        return true;
+    }
+
+    uint64_t curr = to_microseconds(now);
+    uint64_t tat = atomic_load_explicit(&global->state->tat, memory_order_relaxed);
+
+    do {
+        if (tat > curr + global->tolerance){
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(
+        &global->state->tat,
+        &tat,
+        (tat > curr ? tat : curr) + global->interval,
+        memory_order_relaxed,
+        memory_order_relaxed
+    ));
+
+    return true;
+}
+
+void ratelimit_global_free(discord_ratelimit_global *global){
+    if (!global){
+        DLOG(
+            "[%s] ratelimit_global_free() - global is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    /* the segment stays behind for the other processes -- a stale tat is just a full bucket */
+    if (global->mapped){
+        munmap(global->state, sizeof(*global->state));
+    }
+    else {
+        free(global->state);
+    }
+
+    free(global);
+}
+
+discord_ratelimit_breaker *ratelimit_breaker_init(void){
+    discord_ratelimit_breaker *breaker = calloc(1, sizeof(*breaker));
+
+    if (!breaker){
+        DLOG(
+            "[%s] ratelimit_breaker_init() - breaker alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    if (mtx_init(&breaker->lock, mtx_plain) != thrd_success){
+        DLOG(
+            "[%s] ratelimit_breaker_init() - mtx_init call failed\n",
+            __FILE__
+        );
+
+        free(breaker);
+
+        return NULL;
+    }
+
+    return breaker;
+}
+
+void ratelimit_breaker_record(discord_ratelimit_breaker *breaker, long status, double now){
+    if (!breaker){
+        return;
+    }
+
+    mtx_lock(&breaker->lock);
+
+    switch (status){
+    case 401:
+        ++breaker->unauthorized;
+
+        break;
+    case 403:
+        ++breaker->forbidden;
+
+        break;
+    case 429:
+        ++breaker->ratelimited;
+
+        break;
+    default:
+        mtx_unlock(&breaker->lock);
+
+        return;
+    }
+
+    uint64_t period = get_breaker_period(now);
+    size_t slot = period % DISCORD_RATELIMIT_INVALID_SLOTS;
+
+    if (breaker->periods[slot] != period){
+        breaker->periods[slot] = period;
+        breaker->counts[slot] = 0;
+    }
+
+    ++breaker->counts[slot];
+
+    mtx_unlock(&breaker->lock);
+}
+
+void ratelimit_breaker_sent(discord_ratelimit_breaker *breaker, double now){
+    if (!breaker){
+        return;
+    }
+
+    mtx_lock(&breaker->lock);
+
+    breaker->last_sent = now;
+
+    mtx_unlock(&breaker->lock);
+}
+
+/* the helpers below expect the lock to be held */
+static size_t count_invalid(const discord_ratelimit_breaker *breaker, uint64_t period){
+    size_t count = 0;
+
+    for (size_t slot = 0; slot < DISCORD_RATELIMIT_INVALID_SLOTS; ++slot){
+        if (breaker->periods[slot] + DISCORD_RATELIMIT_INVALID_SLOTS > period){
+            count += breaker->counts[slot];
+        }
+    }
+
+    return count;
+}
+
+static discord_ratelimit_breaker_state get_breaker_state(size_t count){
+    if (count >= DISCORD_RATELIMIT_INVALID_LIMIT * DISCORD_RATELIMIT_HALT_RATIO){
+        return BREAKER_OPEN;
+    }
+    else if (count >= DISCORD_RATELIMIT_INVALID_LIMIT * DISCORD_RATELIMIT_THROTTLE_RATIO){
+        return BREAKER_THROTTLED;
+    }
+
+    return BREAKER_CLOSED;
+}
+
+size_t ratelimit_breaker_get_count(discord_ratelimit_breaker *breaker, double now){
+    if (!breaker){
+        return 0;
+    }
+
+    mtx_lock(&breaker->lock);
+
+    size_t count = count_invalid(breaker, get_breaker_period(now));
+
+    mtx_unlock(&breaker->lock);
+
+    return count;
+}
+
+discord_ratelimit_breaker_state ratelimit_breaker_get_state(discord_ratelimit_breaker *breaker, double now){
+    return get_breaker_state(ratelimit_breaker_get_count(breaker, now));
+}
+
+/* an open breaker holds requests until enough old slots slide out of the window */
+double ratelimit_breaker_get_delay(discord_ratelimit_breaker *breaker, double now){
+    if (!breaker){
+        return 0;
+    }
+
+    double delay = 0;
+    uint64_t period = get_breaker_period(now);
+
+    mtx_lock(&breaker->lock);
+
+    size_t count = count_invalid(breaker, period);
+
+    switch (get_breaker_state(count)){
+    case BREAKER_THROTTLED:
+        delay = breaker->last_sent + DISCORD_RATELIMIT_THROTTLE_SPACING - now;
+
+        break;
+    case BREAKER_OPEN:
+        for (uint64_t curr = period + 1 - DISCORD_RATELIMIT_INVALID_SLOTS; curr <= period; ++curr){
+            size_t slot = curr % DISCORD_RATELIMIT_INVALID_SLOTS;
+
+            if (breaker->periods[slot] == curr){
+                count -= breaker->counts[slot];
+            }
+
+            if (count < DISCORD_RATELIMIT_INVALID_LIMIT * DISCORD_RATELIMIT_HALT_RATIO){
+                delay = (double)(curr + DISCORD_RATELIMIT_INVALID_SLOTS) * (DISCORD_RATELIMIT_INVALID_WINDOW / DISCORD_RATELIMIT_INVALID_SLOTS) - now;
+
+                break;
+            }
+        }
+
+        break;
+    default:
+        break;
+    }
+
+    mtx_unlock(&breaker->lock);
+
+    return delay > 0 ? delay : 0;
+}
+
+void ratelimit_breaker_free(discord_ratelimit_breaker *breaker){
+    if (!breaker){
+        DLOG(
+            "[%s] ratelimit_breaker_free() - breaker is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    mtx_destroy(&breaker->lock);
+    free(breaker);
+}
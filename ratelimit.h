@@ -0,0 +1,138 @@
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include "snowflake.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+
+#define DISCORD_RATELIMIT_INITIAL_CAPACITY 64
+
+/* requests per second discord allows a bot token across every route */
+#define DISCORD_RATELIMIT_GLOBAL_RATE 50
+
+/* cloudflare bans the ip for an hour past this many 401, 403 and 429 responses in the window */
+#define DISCORD_RATELIMIT_INVALID_LIMIT 10000
+#define DISCORD_RATELIMIT_INVALID_WINDOW 600
+#define DISCORD_RATELIMIT_INVALID_SLOTS 60
+
+/* share of the invalid limit at which the breaker spaces requests out, and at which it halts them */
+#define DISCORD_RATELIMIT_THROTTLE_RATIO 0.5
+#define DISCORD_RATELIMIT_HALT_RATIO 0.9
+#define DISCORD_RATELIMIT_THROTTLE_SPACING 1.0
+
+struct discord_http_transfer;
+
+typedef struct discord_ratelimit_bucket {
+    snowflake major;
+
+    /* limit is -1 until discord reports it -- reset is an absolute time in seconds */
+    long limit;
+    long remaining;
+    double reset;
+
+    /* requests waiting for the bucket to reset, oldest first */
+    struct discord_http_transfer *head;
+    struct discord_http_transfer *tail;
+    size_t queued;
+
+    struct discord_ratelimit_bucket *next;
+} discord_ratelimit_bucket;
+
+typedef struct discord_ratelimit_entry {
+    char *key;
+    uint64_t hash;
+    discord_ratelimit_bucket *bucket;
+} discord_ratelimit_entry;
+
+/*
+ * routes ("POST /channels/<major>/messages/:id") and discovered buckets
+ * ("<X-RateLimit-Bucket>:<major>") share one table -- routes reported under
+ * the same bucket hash end up pointing at the same bucket
+ */
+typedef struct discord_ratelimit {
+    discord_ratelimit_entry *entries;
+    size_t capacity;
+    size_t length;
+
+    /* every bucket created, including ones routes have moved away from */
+    discord_ratelimit_bucket *buckets;
+} discord_ratelimit;
+
+/*
+ * the global limit as a generic cell rate: tat is when the schedule of sent
+ * requests catches up with the clock, in microseconds since the epoch. a
+ * zeroed state is a full bucket, so a fresh shm segment needs no setup and
+ * processes on the same token can share it without a lock
+ */
+typedef struct discord_ratelimit_global_state {
+    _Atomic uint64_t tat;
+} discord_ratelimit_global_state;
+
+typedef struct discord_ratelimit_global {
+    discord_ratelimit_global_state *state;
+    bool mapped;
+
+    /* microseconds per request, and how far ahead of the clock tat may run (the burst) */
+    uint64_t interval;
+    uint64_t tolerance;
+} discord_ratelimit_global;
+
+typedef enum discord_ratelimit_breaker_state {
+    BREAKER_CLOSED,
+    BREAKER_THROTTLED,
+    BREAKER_OPEN
+} discord_ratelimit_breaker_state;
+
+/* context, new breaker state, invalid responses in the current window */
+typedef void (*discord_ratelimit_breaker_changed)(void *, discord_ratelimit_breaker_state, size_t);
+
+/*
+ * invalid responses over a sliding window kept as a ring of fixed-width
+ * slots -- locked, since clients on other threads may share one
+ */
+typedef struct discord_ratelimit_breaker {
+    mtx_t lock;
+
+    /* each slot is tagged with its period, so slots left over from an earlier lap read as empty */
+    uint32_t counts[DISCORD_RATELIMIT_INVALID_SLOTS];
+    uint64_t periods[DISCORD_RATELIMIT_INVALID_SLOTS];
+
+    /* lifetime totals by status */
+    size_t unauthorized;
+    size_t forbidden;
+    size_t ratelimited;
+
+    double last_sent;
+} discord_ratelimit_breaker;
+
+double ratelimit_get_time(void);
+
+discord_ratelimit *ratelimit_init(void);
+
+discord_ratelimit_bucket *ratelimit_get_bucket(discord_ratelimit *, const char *, snowflake);
+bool ratelimit_update(discord_ratelimit *, const char *, const char *, long, long, double);
+
+double ratelimit_get_delay(const discord_ratelimit_bucket *, double);
+void ratelimit_consume(discord_ratelimit_bucket *, double);
+void ratelimit_exhaust(discord_ratelimit_bucket *, double);
+
+void ratelimit_free(discord_ratelimit *);
+
+discord_ratelimit_global *ratelimit_global_init(const char *, unsigned);
+double ratelimit_global_get_delay(const discord_ratelimit_global *, double);
+bool ratelimit_global_acquire(discord_ratelimit_global *, double);
+void ratelimit_global_free(discord_ratelimit_global *);
+
+discord_ratelimit_breaker *ratelimit_breaker_init(void);
+void ratelimit_breaker_record(discord_ratelimit_breaker *, long, double);
+void ratelimit_breaker_sent(discord_ratelimit_breaker *, double);
+size_t ratelimit_breaker_get_count(discord_ratelimit_breaker *, double);
+discord_ratelimit_breaker_state ratelimit_breaker_get_state(discord_ratelimit_breaker *, double);
+double ratelimit_breaker_get_delay(discord_ratelimit_breaker *, double);
+void ratelimit_breaker_free(discord_ratelimit_breaker *);
+
+#endif
@@ -40,6 +40,8 @@ discord_reaction *reaction_init(discord_state *state, json_object *data){
         return NULL;
     }
 
+    reaction->state = state;
+
     json_object *obj = json_object_object_get(data, "count");
     reaction->count = json_object_get_int(obj);
 
@@ -47,9 +49,10 @@ discord_reaction *reaction_init(discord_state *state, json_object *data){
     reaction->me = json_object_get_boolean(obj);
 
     obj = json_object_object_get(data, "emoji");
-    reaction->emoji = state_set_emoji(state, obj);
 
-    if (!reaction->emoji){
+    const discord_emoji *emoji = state_set_emoji(state, obj);
+
+    if (!emoji || !state_hold_emoji(state, &reaction->emoji, emoji)){
         log_write(
             logger,
             LOG_ERROR,
@@ -80,5 +83,7 @@ void reaction_free(void *ptr){
         return;
     }
 
+    state_hold_emoji(reaction->state, &reaction->emoji, NULL);
+
     free(reaction);
 }
@@ -4,6 +4,8 @@
 #include "state.h"
 
 typedef struct discord_reaction {
+    discord_state *state;
+
     int count;
     bool me;
     const discord_emoji *emoji;
@@ -34,7 +34,11 @@ static bool construct_role(discord_role *role){
             success = snowflake_from_string(objstr, &role->id);
         }
         else if (!strcmp(key, "name")){
-            role->name = json_object_get_string(valueobj);
+            success = state_intern_string(
+                role->state,
+                &role->name,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "color")){
             role->color = json_object_get_int(valueobj);
@@ -52,7 +56,13 @@ static bool construct_role(discord_role *role){
             role->position = json_object_get_int(valueobj);
         }
         else if (!strcmp(key, "permissions")){
-            role->permissions = json_object_get_string(valueobj);
+            success = state_intern_string(
+                role->state,
+                &role->permissions,
+                json_object_get_string(valueobj)
+            );
+
+            success = success && permission_from_string(role->permissions, &role->permission_bits);
         }
         else if (!strcmp(key, "managed")){
             role->managed = json_object_get_boolean(valueobj);
@@ -170,6 +180,194 @@ discord_role *role_init(discord_state *state, json_object *data){
     return role;
 }
 
+bool role_update(discord_role *role, json_object *data){
+    if (!role){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] role_update() - role is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] role_update() - data is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!state_merge_object(role->state, &role->raw_object, data)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] role_update() - state_merge_object call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!construct_role(role)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] role_update() - construct_role call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return true;
+}
+
+int role_compare(const discord_role *a, const discord_role *b){
+    if (a->position != b->position){
+        return (a->position > b->position) - (a->position < b->position);
+    }
+
+    /* discord breaks position ties in favour of the older role */
+    return (a->id < b->id) - (a->id > b->id);
+}
+
+static bool is_ranked(const discord_role_hierarchy *hierarchy, const discord_role *role){
+    return role->rank < hierarchy->length && hierarchy->roles[role->rank] == role;
+}
+
+static void rerank_roles(discord_role_hierarchy *hierarchy, size_t from){
+    for (size_t index = from; index < hierarchy->length; ++index){
+        hierarchy->roles[index]->rank = index;
+    }
+}
+
+discord_role_hierarchy *role_hierarchy_init(void){
+    discord_role_hierarchy *hierarchy = calloc(1, sizeof(*hierarchy));
+
+    if (!hierarchy){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] role_hierarchy_init() - hierarchy alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    return hierarchy;
+}
+
+bool role_hierarchy_place(discord_role_hierarchy *hierarchy, discord_role *role){
+    if (!hierarchy){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] role_hierarchy_place() - hierarchy is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!role){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] role_hierarchy_place() - role is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    /* a moved role is taken out and inserted again at its new rank */
+    if (is_ranked(hierarchy, role)){
+        role_hierarchy_remove(hierarchy, role);
+    }
+
+    if (hierarchy->length == hierarchy->capacity){
+        size_t capacity = hierarchy->capacity ? hierarchy->capacity * 2 : 16;
+        discord_role **roles = realloc(hierarchy->roles, capacity * sizeof(*roles));
+
+        if (!roles){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] role_hierarchy_place() - roles realloc failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        hierarchy->roles = roles;
+        hierarchy->capacity = capacity;
+    }
+
+    size_t low = 0;
+    size_t high = hierarchy->length;
+
+    while (low < high){
+        size_t middle = low + (high - low) / 2;
+
+        if (role_compare(hierarchy->roles[middle], role) < 0){
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    memmove(
+        &hierarchy->roles[low + 1],
+        &hierarchy->roles[low],
+        (hierarchy->length - low) * sizeof(*hierarchy->roles)
+    );
+
+    hierarchy->roles[low] = role;
+    ++hierarchy->length;
+
+    rerank_roles(hierarchy, low);
+
+    return true;
+}
+
+bool role_hierarchy_remove(discord_role_hierarchy *hierarchy, discord_role *role){
+    if (!hierarchy || !role || !is_ranked(hierarchy, role)){
+        return false;
+    }
+
+    size_t rank = role->rank;
+
+    memmove(
+        &hierarchy->roles[rank],
+        &hierarchy->roles[rank + 1],
+        (hierarchy->length - rank - 1) * sizeof(*hierarchy->roles)
+    );
+
+    --hierarchy->length;
+
+    rerank_roles(hierarchy, rank);
+
+    return true;
+}
+
+void role_hierarchy_free(void *hierarchyptr){
+    discord_role_hierarchy *hierarchy = hierarchyptr;
+
+    if (!hierarchy){
+        return;
+    }
+
+    free(hierarchy->roles);
+    free(hierarchy);
+}
+
 void role_free(void *roleptr){
     discord_role *role = roleptr;
 
@@ -186,6 +384,9 @@ void role_free(void *roleptr){
 
     json_object_put(role->raw_object);
 
+    state_release_string(role->state, role->name);
+    state_release_string(role->state, role->permissions);
+
     free(role->tags);
     free(role);
 }
@@ -14,6 +14,7 @@ typedef struct discord_role {
     json_object *raw_object;
 
     snowflake id;
+    snowflake guild_id;
     const char *name;
     int color;
     bool hoist;
@@ -21,12 +22,34 @@ typedef struct discord_role {
     const char *unicode_emoji;
     int position;
     const char *permissions;
+    discord_permissions permission_bits;
     bool managed;
     bool mentionable;
     discord_role_tags *tags;
+
+    /* index in the guild's hierarchy -- a higher rank outranks a lower one */
+    size_t rank;
 } discord_role;
 
+/*
+ * a guild's roles sorted lowest to highest so comparing two roles is a
+ * comparison of their ranks -- kept up to date by the writer thread only
+ */
+typedef struct discord_role_hierarchy {
+    discord_role **roles;
+    size_t length;
+    size_t capacity;
+} discord_role_hierarchy;
+
 discord_role *role_init(discord_state *, json_object *);
+bool role_update(discord_role *, json_object *);
+
+int role_compare(const discord_role *, const discord_role *);
+
+discord_role_hierarchy *role_hierarchy_init(void);
+bool role_hierarchy_place(discord_role_hierarchy *, discord_role *);
+bool role_hierarchy_remove(discord_role_hierarchy *, discord_role *);
+void role_hierarchy_free(void *);
 
 void role_free(void *);
 
@@ -0,0 +1,498 @@
+#include "search.h"
+
+#include "log.h"
+#include "str.h"
+
+#include <ctype.h>
+
+static uint64_t hash_term(const char *term){
+    /* FNV-1a */
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (const unsigned char *curr = (const unsigned char *)term; *curr; ++curr){
+        hash ^= *curr;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/* anything outside ascii is kept as part of a word so non-latin text still indexes */
+static bool is_word_byte(unsigned char c){
+    return c >= 0x80 || isalnum(c);
+}
+
+/* lowercases the next word into term -- overlong words are truncated, not split */
+static size_t next_token(const char **cursor, char *term){
+    const unsigned char *curr = (const unsigned char *)*cursor;
+
+    while (*curr && !is_word_byte(*curr)){
+        ++curr;
+    }
+
+    size_t length = 0;
+
+    for (; *curr && is_word_byte(*curr); ++curr){
+        if (length < DISCORD_SEARCH_MAX_TERM_LENGTH - 1){
+            term[length++] = tolower(*curr);
+        }
+    }
+
+    term[length] = '\0';
+
+    *cursor = (const char *)curr;
+
+    return length;
+}
+
+static size_t find_posting(const discord_search_term *entry, snowflake id){
+    size_t low = 0;
+    size_t high = entry->length;
+
+    while (low < high){
+        size_t middle = low + (high - low) / 2;
+
+        if (entry->ids[middle] < id){
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+static bool has_posting(const discord_search_term *entry, snowflake id){
+    size_t position = find_posting(entry, id);
+
+    return position < entry->length && entry->ids[position] == id;
+}
+
+static bool resize_table(discord_search *search, size_t capacity){
+    discord_search_term *terms = calloc(capacity, sizeof(*terms));
+
+    if (!terms){
+        DLOG(
+            "[%s] resize_table() - terms alloc failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    size_t mask = capacity - 1;
+
+    for (size_t index = 0; index < search->capacity; ++index){
+        discord_search_term *entry = &search->terms[index];
+
+        if (!entry->term){
+            continue;
+        }
+
+        size_t slot = entry->hash & mask;
+
+        while (terms[slot].term){
+            slot = (slot + 1) & mask;
+        }
+
+        terms[slot] = *entry;
+    }
+
+    free(search->terms);
+
+    search->terms = terms;
+    search->capacity = capacity;
+
+    return true;
+}
+
+static discord_search_term *find_term(const discord_search *search, const char *term, uint64_t hash){
+    size_t mask = search->capacity - 1;
+
+    for (size_t slot = hash & mask; search->terms[slot].term; slot = (slot + 1) & mask){
+        discord_search_term *entry = &search->terms[slot];
+
+        if (entry->hash == hash && !strcmp(entry->term, term)){
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void remove_term(discord_search *search, size_t hole){
+    size_t mask = search->capacity - 1;
+
+    free(search->terms[hole].term);
+    free(search->terms[hole].ids);
+
+    /* backward shift deletion, as in the intern table */
+    for (size_t next = (hole + 1) & mask; search->terms[next].term; next = (next + 1) & mask){
+        size_t home = search->terms[next].hash & mask;
+        bool movable = false;
+
+        if (next > hole){
+            movable = home <= hole || home > next;
+        }
+        else {
+            movable = home <= hole && home > next;
+        }
+
+        if (movable){
+            search->terms[hole] = search->terms[next];
+
+            hole = next;
+        }
+    }
+
+    memset(&search->terms[hole], 0, sizeof(search->terms[hole]));
+
+    --search->length;
+}
+
+static discord_search_term *add_term(discord_search *search, const char *term, uint64_t hash){
+    if ((search->length + 1) * 10 >= search->capacity * 7){
+        if (!resize_table(search, search->capacity * 2)){
+            DLOG(
+                "[%s] add_term() - resize_table call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+    }
+
+    char *copy = string_duplicate(term);
+
+    if (!copy){
+        DLOG(
+            "[%s] add_term() - string_duplicate call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    size_t mask = search->capacity - 1;
+    size_t slot = hash & mask;
+
+    while (search->terms[slot].term){
+        slot = (slot + 1) & mask;
+    }
+
+    search->terms[slot].term = copy;
+    search->terms[slot].hash = hash;
+
+    ++search->length;
+
+    return &search->terms[slot];
+}
+
+static bool add_posting(discord_search *search, discord_search_term *entry, snowflake id){
+    size_t position = find_posting(entry, id);
+
+    /* repeated words only count once per message */
+    if (position < entry->length && entry->ids[position] == id){
+        return true;
+    }
+
+    if (entry->length == entry->capacity){
+        size_t capacity = entry->capacity ? entry->capacity * 2 : 4;
+        snowflake *ids = realloc(entry->ids, capacity * sizeof(*ids));
+
+        if (!ids){
+            DLOG(
+                "[%s] add_posting() - ids realloc failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        entry->ids = ids;
+        entry->capacity = capacity;
+    }
+
+    memmove(&entry->ids[position + 1], &entry->ids[position], (entry->length - position) * sizeof(*entry->ids));
+
+    entry->ids[position] = id;
+
+    ++entry->length;
+    ++search->postings;
+
+    return true;
+}
+
+discord_search *search_init(void){
+    discord_search *search = calloc(1, sizeof(*search));
+
+    if (!search){
+        DLOG(
+            "[%s] search_init() - search alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    if (!resize_table(search, DISCORD_SEARCH_INITIAL_CAPACITY)){
+        DLOG(
+            "[%s] search_init() - resize_table call failed\n",
+            __FILE__
+        );
+
+        search_free(search);
+
+        return NULL;
+    }
+
+    return search;
+}
+
+bool search_add(discord_search *search, snowflake id, const char *content){
+    if (!search){
+        DLOG(
+            "[%s] search_add() - search is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!content){
+        return true;
+    }
+
+    char term[DISCORD_SEARCH_MAX_TERM_LENGTH];
+    const char *cursor = content;
+
+    while (next_token(&cursor, term)){
+        uint64_t hash = hash_term(term);
+        discord_search_term *entry = find_term(search, term, hash);
+
+        if (!entry){
+            entry = add_term(search, term, hash);
+        }
+
+        if (!entry || !add_posting(search, entry, id)){
+            DLOG(
+                "[%s] search_add() - failed to index term %s\n",
+                __FILE__,
+                term
+            );
+
+            /* leave nothing half indexed behind */
+            search_remove(search, id, content);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void search_remove(discord_search *search, snowflake id, const char *content){
+    if (!search || !content){
+        return;
+    }
+
+    char term[DISCORD_SEARCH_MAX_TERM_LENGTH];
+    const char *cursor = content;
+
+    while (next_token(&cursor, term)){
+        discord_search_term *entry = find_term(search, term, hash_term(term));
+
+        if (!entry){
+            continue;
+        }
+
+        size_t position = find_posting(entry, id);
+
+        if (position == entry->length || entry->ids[position] != id){
+            continue;
+        }
+
+        --entry->length;
+        --search->postings;
+
+        memmove(&entry->ids[position], &entry->ids[position + 1], (entry->length - position) * sizeof(*entry->ids));
+
+        if (!entry->length){
+            remove_term(search, entry - search->terms);
+        }
+    }
+}
+
+bool search_parse_query(const char *string, discord_search_query *query){
+    if (!string || !query){
+        DLOG(
+            "[%s] search_parse_query() - string and query are required\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    memset(query, 0, sizeof(*query));
+
+    bool quoted = false;
+    size_t start = 0;
+
+    for (const char *curr = string; *curr;){
+        if (*curr == '"'){
+            if (quoted && query->termslen - start > 1){
+                query->phrases[query->phraseslen].start = start;
+                query->phrases[query->phraseslen].end = query->termslen;
+
+                ++query->phraseslen;
+            }
+
+            quoted = !quoted;
+            start = query->termslen;
+
+            ++curr;
+
+            continue;
+        }
+        else if (!is_word_byte(*curr)){
+            ++curr;
+
+            continue;
+        }
+
+        if (query->termslen == DISCORD_SEARCH_MAX_TERMS){
+            DLOG(
+                "[%s] search_parse_query() - more than %d terms\n",
+                __FILE__,
+                DISCORD_SEARCH_MAX_TERMS
+            );
+
+            return false;
+        }
+
+        next_token(&curr, query->terms[query->termslen++]);
+    }
+
+    /* an unterminated quote runs to the end */
+    if (quoted && query->termslen - start > 1){
+        query->phrases[query->phraseslen].start = start;
+        query->phrases[query->phraseslen].end = query->termslen;
+
+        ++query->phraseslen;
+    }
+
+    return query->termslen;
+}
+
+static bool match_phrase(const discord_search_query *query, const discord_search_phrase *phrase, const char *content){
+    char term[DISCORD_SEARCH_MAX_TERM_LENGTH];
+
+    for (const char *start = content; next_token(&start, term);){
+        if (strcmp(term, query->terms[phrase->start])){
+            continue;
+        }
+
+        const char *cursor = start;
+        size_t index = phrase->start + 1;
+
+        while (index < phrase->end && next_token(&cursor, term) && !strcmp(term, query->terms[index])){
+            ++index;
+        }
+
+        if (index == phrase->end){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* postings only say the words are present -- phrases are checked against the text */
+bool search_match_phrases(const discord_search_query *query, const char *content){
+    if (!query){
+        return false;
+    }
+
+    for (size_t index = 0; index < query->phraseslen; ++index){
+        if (!content || !match_phrase(query, &query->phrases[index], content)){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* hands match every id containing all the terms, newest first, below before (if nonzero) */
+size_t search_run(const discord_search *search, const discord_search_query *query, snowflake before, discord_search_match match, void *context){
+    if (!search || !query || !match){
+        DLOG(
+            "[%s] search_run() - search, query and match are required\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+
+    const discord_search_term *entries[DISCORD_SEARCH_MAX_TERMS] = {0};
+    size_t shortest = 0;
+
+    for (size_t index = 0; index < query->termslen; ++index){
+        entries[index] = find_term(search, query->terms[index], hash_term(query->terms[index]));
+
+        if (!entries[index]){
+            return 0;
+        }
+
+        if (entries[index]->length < entries[shortest]->length){
+            shortest = index;
+        }
+    }
+
+    if (!query->termslen){
+        return 0;
+    }
+
+    const discord_search_term *driver = entries[shortest];
+    size_t position = before ? find_posting(driver, before) : driver->length;
+    size_t matched = 0;
+
+    while (position--){
+        snowflake id = driver->ids[position];
+        bool found = true;
+
+        for (size_t index = 0; found && index < query->termslen; ++index){
+            found = index == shortest || has_posting(entries[index], id);
+        }
+
+        if (!found){
+            continue;
+        }
+
+        ++matched;
+
+        if (!match(context, id)){
+            break;
+        }
+    }
+
+    return matched;
+}
+
+void search_free(discord_search *search){
+    if (!search){
+        DLOG(
+            "[%s] search_free() - search is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    for (size_t index = 0; index < search->capacity; ++index){
+        free(search->terms[index].term);
+        free(search->terms[index].ids);
+    }
+
+    free(search->terms);
+    free(search);
+}
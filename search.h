@@ -0,0 +1,66 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "snowflake.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DISCORD_SEARCH_INITIAL_CAPACITY 1024
+#define DISCORD_SEARCH_MAX_TERMS 16
+#define DISCORD_SEARCH_MAX_TERM_LENGTH 64
+
+/* ids of the messages containing term, oldest first */
+typedef struct discord_search_term {
+    char *term;
+    uint64_t hash;
+
+    snowflake *ids;
+    size_t length;
+    size_t capacity;
+} discord_search_term;
+
+/*
+ * inverted index from lowercased words to the messages containing them
+ *
+ * writer thread only
+ */
+typedef struct discord_search {
+    discord_search_term *terms;
+    size_t capacity;
+    size_t length;
+
+    size_t postings;
+} discord_search;
+
+/* a phrase covers terms [start, end) and must match them back to back */
+typedef struct discord_search_phrase {
+    size_t start;
+    size_t end;
+} discord_search_phrase;
+
+/* whitespace separated words are ANDed, "quoted words" form a phrase */
+typedef struct discord_search_query {
+    char terms[DISCORD_SEARCH_MAX_TERMS][DISCORD_SEARCH_MAX_TERM_LENGTH];
+    size_t termslen;
+
+    discord_search_phrase phrases[DISCORD_SEARCH_MAX_TERMS];
+    size_t phraseslen;
+} discord_search_query;
+
+/* return false to stop the search */
+typedef bool (*discord_search_match)(void *, snowflake);
+
+discord_search *search_init(void);
+
+bool search_add(discord_search *, snowflake, const char *);
+void search_remove(discord_search *, snowflake, const char *);
+
+bool search_parse_query(const char *, discord_search_query *);
+bool search_match_phrases(const discord_search_query *, const char *);
+size_t search_run(const discord_search *, const discord_search_query *, snowflake, discord_search_match, void *);
+
+void search_free(discord_search *);
+
+#endif
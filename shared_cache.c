@@ -0,0 +1,558 @@
+/* ftruncate is posix-only under -std=c18 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "shared_cache.h"
+
+#include "log.h"
+#include "str.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHARED_CACHE_ALIGNMENT 64
+#define SHARED_CACHE_MIN_CAPACITY 64
+
+static const size_t slot_payloads[SHARED_TABLE_COUNT] = {
+    DISCORD_SHARED_CACHE_USER_SLOT,
+    DISCORD_SHARED_CACHE_GUILD_SLOT,
+    DISCORD_SHARED_CACHE_MEMBER_SLOT
+};
+
+static size_t hash_key(snowflake guildid, snowflake id){
+    /* murmur3 finalizer over both halves of the key */
+    uint64_t key = id ^ (guildid * 0x9e3779b97f4a7c15ULL);
+
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+
+    return key;
+}
+
+static size_t align_size(size_t size){
+    return (size + SHARED_CACHE_ALIGNMENT - 1) & ~(size_t)(SHARED_CACHE_ALIGNMENT - 1);
+}
+
+static size_t round_capacity(size_t capacity){
+    size_t rounded = SHARED_CACHE_MIN_CAPACITY;
+
+    while (rounded < capacity){
+        rounded *= 2;
+    }
+
+    return rounded;
+}
+
+static bool get_table_kind(discord_snapshot_kind kind, discord_shared_table_kind *table){
+    switch (kind){
+    case SNAPSHOT_USERS:
+        *table = SHARED_TABLE_USERS;
+
+        return true;
+    case SNAPSHOT_GUILDS:
+        *table = SHARED_TABLE_GUILDS;
+
+        return true;
+    case SNAPSHOT_MEMBERS:
+        *table = SHARED_TABLE_MEMBERS;
+
+        return true;
+    default:
+        return false;
+    }
+}
+
+static const discord_shared_table *get_table(const discord_shared_cache *cache, discord_snapshot_kind kind){
+    discord_shared_table_kind table = SHARED_TABLE_USERS;
+
+    if (!get_table_kind(kind, &table)){
+        return NULL;
+    }
+
+    const discord_shared_header *header = (const discord_shared_header *)cache->base;
+
+    return &header->tables[table];
+}
+
+static discord_shared_slot *get_slot(const discord_shared_cache *cache, const discord_shared_table *table, size_t index){
+    return (discord_shared_slot *)(cache->base + table->offset + index * table->slot_size);
+}
+
+static void begin_write(discord_shared_slot *slot){
+    atomic_fetch_add_explicit(&slot->sequence, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void end_write(discord_shared_slot *slot){
+    atomic_fetch_add_explicit(&slot->sequence, 1, memory_order_release);
+}
+
+/* owner only -- the matching slot, else the first reusable one on the probe path */
+static discord_shared_slot *find_write_slot(const discord_shared_cache *cache, const discord_shared_table *table, snowflake guildid, snowflake id, bool *found){
+    size_t mask = table->capacity - 1;
+    size_t index = hash_key(guildid, id) & mask;
+    discord_shared_slot *reusable = NULL;
+
+    *found = false;
+
+    for (size_t probes = 0; probes < table->capacity; ++probes, index = (index + 1) & mask){
+        discord_shared_slot *slot = get_slot(cache, table, index);
+
+        if (slot->status == SHARED_SLOT_EMPTY){
+            return reusable ? reusable : slot;
+        }
+        else if (slot->status == SHARED_SLOT_REMOVED){
+            if (!reusable){
+                reusable = slot;
+            }
+        }
+        else if (slot->id == id && slot->guild_id == guildid){
+            *found = true;
+
+            return slot;
+        }
+    }
+
+    return reusable;
+}
+
+static void clear_slot(discord_shared_slot *slot){
+    begin_write(slot);
+
+    /* a tombstone keeps later entries on the probe path reachable */
+    slot->status = SHARED_SLOT_REMOVED;
+    slot->length = 0;
+
+    end_write(slot);
+}
+
+discord_shared_cache *shared_cache_create(const char *name, size_t capacity){
+    if (!name){
+        DLOG(
+            "[%s] shared_cache_create() - name is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    discord_shared_cache *cache = calloc(1, sizeof(*cache));
+
+    if (!cache){
+        DLOG(
+            "[%s] shared_cache_create() - cache alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    cache->owner = true;
+    cache->name = string_duplicate(name);
+
+    if (!cache->name){
+        DLOG(
+            "[%s] shared_cache_create() - string_duplicate call failed\n",
+            __FILE__
+        );
+
+        shared_cache_close(cache);
+
+        return NULL;
+    }
+
+    /* guilds are far fewer than users and members */
+    size_t capacities[SHARED_TABLE_COUNT] = {
+        round_capacity(capacity),
+        round_capacity(capacity / 8),
+        round_capacity(capacity)
+    };
+
+    discord_shared_header header = {0};
+    size_t size = align_size(sizeof(header));
+
+    for (size_t index = 0; index < SHARED_TABLE_COUNT; ++index){
+        discord_shared_table *table = &header.tables[index];
+
+        table->offset = size;
+        table->capacity = capacities[index];
+        table->slot_size = sizeof(discord_shared_slot) + slot_payloads[index];
+
+        size = align_size(size + (size_t)table->capacity * table->slot_size);
+    }
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+    if (fd == -1){
+        DLOG(
+            "[%s] shared_cache_create() - shm_open call failed for %s\n",
+            __FILE__,
+            name
+        );
+
+        shared_cache_close(cache);
+
+        return NULL;
+    }
+
+    /* a fresh segment reads back as zeroes -- every slot starts out empty */
+    if (ftruncate(fd, size) == -1){
+        DLOG(
+            "[%s] shared_cache_create() - ftruncate call failed for %zu bytes\n",
+            __FILE__,
+            size
+        );
+
+        close(fd);
+        shm_unlink(name);
+        shared_cache_close(cache);
+
+        return NULL;
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (base == MAP_FAILED){
+        DLOG(
+            "[%s] shared_cache_create() - mmap call failed\n",
+            __FILE__
+        );
+
+        shm_unlink(name);
+        shared_cache_close(cache);
+
+        return NULL;
+    }
+
+    cache->base = base;
+    cache->size = size;
+
+    discord_shared_header *mapped = base;
+
+    mapped->version = DISCORD_SHARED_CACHE_VERSION;
+    mapped->size = size;
+
+    memcpy(mapped->tables, header.tables, sizeof(header.tables));
+
+    /* readers check the magic first -- it goes in last */
+    atomic_store_explicit(&mapped->magic, DISCORD_SHARED_CACHE_MAGIC, memory_order_release);
+
+    return cache;
+}
+
+discord_shared_cache *shared_cache_open(const char *name){
+    if (!name){
+        DLOG(
+            "[%s] shared_cache_open() - name is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+
+    if (fd == -1){
+        DLOG(
+            "[%s] shared_cache_open() - shm_open call failed for %s\n",
+            __FILE__,
+            name
+        );
+
+        return NULL;
+    }
+
+    struct stat info = {0};
+
+    if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(discord_shared_header)){
+        DLOG(
+            "[%s] shared_cache_open() - %s is not a shared cache\n",
+            __FILE__,
+            name
+        );
+
+        close(fd);
+
+        return NULL;
+    }
+
+    void *base = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (base == MAP_FAILED){
+        DLOG(
+            "[%s] shared_cache_open() - mmap call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const discord_shared_header *header = base;
+
+    if (atomic_load_explicit(&header->magic, memory_order_acquire) != DISCORD_SHARED_CACHE_MAGIC || header->version != DISCORD_SHARED_CACHE_VERSION || header->size > (size_t)info.st_size){
+        DLOG(
+            "[%s] shared_cache_open() - %s has an unknown layout\n",
+            __FILE__,
+            name
+        );
+
+        munmap(base, info.st_size);
+
+        return NULL;
+    }
+
+    discord_shared_cache *cache = calloc(1, sizeof(*cache));
+
+    if (!cache){
+        DLOG(
+            "[%s] shared_cache_open() - cache alloc failed\n",
+            __FILE__
+        );
+
+        munmap(base, info.st_size);
+
+        return NULL;
+    }
+
+    cache->base = base;
+    cache->size = info.st_size;
+
+    return cache;
+}
+
+bool shared_cache_put(discord_shared_cache *cache, discord_snapshot_kind kind, snowflake guildid, snowflake id, const void *entity){
+    if (!cache || !cache->owner){
+        DLOG(
+            "[%s] shared_cache_put() - cache is NULL or read-only\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    const discord_shared_table *table = get_table(cache, kind);
+
+    if (!table || !id){
+        return false;
+    }
+
+    cache->buffer.size = 0;
+
+    if (!snapshot_write_entity(&cache->buffer, kind, entity)){
+        DLOG(
+            "[%s] shared_cache_put() - snapshot_write_entity call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    /* an outgrown entry must not be left behind with its old contents */
+    if (cache->buffer.size > table->slot_size - sizeof(discord_shared_slot)){
+        DLOG(
+            "[%s] shared_cache_put() - %" PRIu64 " encodes to %zu bytes -- too large to share\n",
+            __FILE__,
+            id,
+            cache->buffer.size
+        );
+
+        shared_cache_remove(cache, kind, guildid, id);
+
+        return false;
+    }
+
+    bool found = false;
+    discord_shared_slot *slot = find_write_slot(cache, table, guildid, id, &found);
+
+    if (!slot){
+        DLOG(
+            "[%s] shared_cache_put() - table for kind %d is full\n",
+            __FILE__,
+            kind
+        );
+
+        return false;
+    }
+
+    begin_write(slot);
+
+    slot->status = SHARED_SLOT_USED;
+    slot->guild_id = guildid;
+    slot->id = id;
+    slot->length = cache->buffer.size;
+
+    memcpy(slot->data, cache->buffer.data, cache->buffer.size);
+
+    end_write(slot);
+
+    return true;
+}
+
+bool shared_cache_remove(discord_shared_cache *cache, discord_snapshot_kind kind, snowflake guildid, snowflake id){
+    if (!cache || !cache->owner){
+        return false;
+    }
+
+    const discord_shared_table *table = get_table(cache, kind);
+
+    if (!table){
+        return false;
+    }
+
+    bool found = false;
+    discord_shared_slot *slot = find_write_slot(cache, table, guildid, id, &found);
+
+    if (!found){
+        return false;
+    }
+
+    clear_slot(slot);
+
+    return true;
+}
+
+/* drops the guild and every member keyed under it */
+size_t shared_cache_remove_guild(discord_shared_cache *cache, snowflake guildid){
+    if (!cache || !cache->owner){
+        return 0;
+    }
+
+    size_t removed = shared_cache_remove(cache, SNAPSHOT_GUILDS, 0, guildid);
+    const discord_shared_table *table = get_table(cache, SNAPSHOT_MEMBERS);
+
+    for (size_t index = 0; index < table->capacity; ++index){
+        discord_shared_slot *slot = get_slot(cache, table, index);
+
+        if (slot->status == SHARED_SLOT_USED && slot->guild_id == guildid){
+            clear_slot(slot);
+
+            ++removed;
+        }
+    }
+
+    return removed;
+}
+
+/*
+ * copies the encoded entity into data when it fits and returns its length
+ * either way (0 if it isn't shared)
+ */
+size_t shared_cache_read(const discord_shared_cache *cache, discord_snapshot_kind kind, snowflake guildid, snowflake id, unsigned char *data, size_t size){
+    if (!cache || !id){
+        return 0;
+    }
+
+    const discord_shared_table *table = get_table(cache, kind);
+
+    if (!table){
+        return 0;
+    }
+
+    size_t payload = table->slot_size - sizeof(discord_shared_slot);
+    size_t mask = table->capacity - 1;
+    size_t index = hash_key(guildid, id) & mask;
+
+    for (size_t probes = 0; probes < table->capacity; ++probes, index = (index + 1) & mask){
+        const discord_shared_slot *slot = get_slot(cache, table, index);
+
+        uint32_t sequence = 0;
+        uint32_t status = SHARED_SLOT_EMPTY;
+        size_t length = 0;
+        bool match = false;
+
+        /* retry if the owner rewrote the slot while we were copying it */
+        do {
+            sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+            if (sequence & 1){
+                continue;
+            }
+
+            status = slot->status;
+            match = status == SHARED_SLOT_USED && slot->id == id && slot->guild_id == guildid;
+            length = match ? slot->length : 0;
+
+            if (match && data && length <= size && length <= payload){
+                memcpy(data, slot->data, length);
+            }
+
+            atomic_thread_fence(memory_order_acquire);
+        } while ((sequence & 1) || sequence != atomic_load_explicit(&slot->sequence, memory_order_relaxed));
+
+        if (match){
+            return length;
+        }
+        else if (status == SHARED_SLOT_EMPTY){
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+json_object *shared_cache_get(const discord_shared_cache *cache, discord_snapshot_kind kind, snowflake guildid, snowflake id){
+    unsigned char data[DISCORD_SHARED_CACHE_GUILD_SLOT];
+    size_t length = shared_cache_read(cache, kind, guildid, id, data, sizeof(data));
+
+    if (!length || length > sizeof(data)){
+        return NULL;
+    }
+
+    discord_snapshot_reader reader = {0};
+    reader.data = data;
+    reader.size = length;
+
+    return snapshot_read_entity(&reader, kind);
+}
+
+bool shared_cache_is_closed(const discord_shared_cache *cache){
+    if (!cache){
+        return true;
+    }
+
+    const discord_shared_header *header = (const discord_shared_header *)cache->base;
+
+    return atomic_load_explicit(&header->closed, memory_order_acquire);
+}
+
+void shared_cache_close(discord_shared_cache *cache){
+    if (!cache){
+        DLOG(
+            "[%s] shared_cache_close() - cache is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    if (cache->base){
+        if (cache->owner){
+            discord_shared_header *header = (discord_shared_header *)cache->base;
+
+            atomic_store_explicit(&header->closed, 1, memory_order_release);
+        }
+
+        munmap(cache->base, cache->size);
+    }
+
+    /* mapped readers keep the memory until they let go -- only the name goes */
+    if (cache->owner && cache->base){
+        shm_unlink(cache->name);
+    }
+
+    snapshot_buffer_free(&cache->buffer);
+
+    free(cache->name);
+    free(cache);
+}
@@ -0,0 +1,96 @@
+#ifndef SHARED_CACHE_H
+#define SHARED_CACHE_H
+
+#include "snapshot.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json-c/json.h>
+
+/* "DCSH" read as a little-endian integer */
+#define DISCORD_SHARED_CACHE_MAGIC 0x48534344
+#define DISCORD_SHARED_CACHE_VERSION 1
+
+/* inline payload room per slot -- entities that encode larger are left out */
+#define DISCORD_SHARED_CACHE_USER_SLOT 256
+#define DISCORD_SHARED_CACHE_GUILD_SLOT 2048
+#define DISCORD_SHARED_CACHE_MEMBER_SLOT 512
+
+typedef enum discord_shared_table_kind {
+    SHARED_TABLE_USERS,
+    SHARED_TABLE_GUILDS,
+    SHARED_TABLE_MEMBERS,
+
+    SHARED_TABLE_COUNT
+} discord_shared_table_kind;
+
+typedef enum discord_shared_slot_status {
+    SHARED_SLOT_EMPTY,
+    SHARED_SLOT_USED,
+    SHARED_SLOT_REMOVED
+} discord_shared_slot_status;
+
+/*
+ * slots are fixed-size so an update is rewritten in place -- the sequence is
+ * odd while the owner writes and readers retry until they see the same even
+ * value on both sides of their copy
+ */
+typedef struct discord_shared_slot {
+    _Atomic uint32_t sequence;
+    uint32_t status;
+    uint32_t length;
+    uint32_t reserved;
+
+    snowflake guild_id;
+    snowflake id;
+
+    unsigned char data[];
+} discord_shared_slot;
+
+/* offsets are from the start of the segment, so every process can map it anywhere */
+typedef struct discord_shared_table {
+    uint64_t offset;
+    uint32_t capacity;
+    uint32_t slot_size;
+} discord_shared_table;
+
+typedef struct discord_shared_header {
+    _Atomic uint32_t magic;
+    uint32_t version;
+    uint64_t size;
+
+    /* set when the owner goes away -- readers should reopen */
+    _Atomic uint32_t closed;
+    uint32_t reserved;
+
+    discord_shared_table tables[SHARED_TABLE_COUNT];
+} discord_shared_header;
+
+typedef struct discord_shared_cache {
+    char *name;
+    bool owner;
+
+    unsigned char *base;
+    size_t size;
+
+    /* scratch space the owner encodes entities into */
+    discord_snapshot_buffer buffer;
+} discord_shared_cache;
+
+discord_shared_cache *shared_cache_create(const char *, size_t);
+discord_shared_cache *shared_cache_open(const char *);
+
+bool shared_cache_put(discord_shared_cache *, discord_snapshot_kind, snowflake, snowflake, const void *);
+bool shared_cache_remove(discord_shared_cache *, discord_snapshot_kind, snowflake, snowflake);
+size_t shared_cache_remove_guild(discord_shared_cache *, snowflake);
+
+size_t shared_cache_read(const discord_shared_cache *, discord_snapshot_kind, snowflake, snowflake, unsigned char *, size_t);
+json_object *shared_cache_get(const discord_shared_cache *, discord_snapshot_kind, snowflake, snowflake);
+bool shared_cache_is_closed(const discord_shared_cache *);
+
+void shared_cache_close(discord_shared_cache *);
+
+#endif
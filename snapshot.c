@@ -0,0 +1,747 @@
+#include "snapshot.h"
+
+#include "state.h"
+
+#include <stddef.h>
+
+static const discord_snapshot_field user_fields[] = {
+    {"id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_user, id)},
+    {"username", SNAPSHOT_FIELD_STRING, offsetof(discord_user, username)},
+    {"discriminator", SNAPSHOT_FIELD_STRING, offsetof(discord_user, discriminator)},
+    {"avatar", SNAPSHOT_FIELD_STRING, offsetof(discord_user, avatar)},
+    {"bot", SNAPSHOT_FIELD_BOOL, offsetof(discord_user, bot)},
+    {"system", SNAPSHOT_FIELD_BOOL, offsetof(discord_user, system)},
+    {"mfa_enabled", SNAPSHOT_FIELD_BOOL, offsetof(discord_user, mfa_enabled)},
+    {"banner", SNAPSHOT_FIELD_STRING, offsetof(discord_user, banner)},
+    {"accent_color", SNAPSHOT_FIELD_INT, offsetof(discord_user, accent_color)},
+    {"locale", SNAPSHOT_FIELD_STRING, offsetof(discord_user, locale)},
+    {"verified", SNAPSHOT_FIELD_BOOL, offsetof(discord_user, verified)},
+    {"email", SNAPSHOT_FIELD_STRING, offsetof(discord_user, email)},
+    {"flags", SNAPSHOT_FIELD_INT, offsetof(discord_user, flags)},
+    {"premium_type", SNAPSHOT_FIELD_INT, offsetof(discord_user, premium_type)},
+    {"public_flags", SNAPSHOT_FIELD_INT, offsetof(discord_user, public_flags)}
+};
+
+static const discord_snapshot_field guild_fields[] = {
+    {"id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_guild, id)},
+    {"name", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, name)},
+    {"icon", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, icon)},
+    {"icon_hash", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, icon_hash)},
+    {"splash", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, splash)},
+    {"discovery_splash", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, discovery_splash)},
+    {"owner", SNAPSHOT_FIELD_BOOL, offsetof(discord_guild, owner)},
+    {"owner_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_guild, owner_id)},
+    {"permissions", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, permissions)},
+    {"afk_channel_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_guild, afk_channel_id)},
+    {"afk_timeout", SNAPSHOT_FIELD_INT, offsetof(discord_guild, afk_timeout)},
+    {"widget_enabled", SNAPSHOT_FIELD_BOOL, offsetof(discord_guild, widget_enabled)},
+    {"widget_channel_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_guild, widget_channel_id)},
+    {"verification_level", SNAPSHOT_FIELD_INT, offsetof(discord_guild, verification_level)},
+    {"default_message_notifications", SNAPSHOT_FIELD_INT, offsetof(discord_guild, default_message_notifications)},
+    {"explicit_content_filter", SNAPSHOT_FIELD_INT, offsetof(discord_guild, explicit_content_filter)},
+    {"features", SNAPSHOT_FIELD_STRING_LIST, offsetof(discord_guild, features)},
+    {"mfa_level", SNAPSHOT_FIELD_INT, offsetof(discord_guild, mfa_level)},
+    {"application_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_guild, application_id)},
+    {"system_channel_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_guild, system_channel_id)},
+    {"system_channel_flags", SNAPSHOT_FIELD_INT, offsetof(discord_guild, system_channel_flags)},
+    {"rules_channel_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_guild, rules_channel_id)},
+    {"joined_at", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, joined_at)},
+    {"large", SNAPSHOT_FIELD_BOOL, offsetof(discord_guild, large)},
+    {"unavailable", SNAPSHOT_FIELD_BOOL, offsetof(discord_guild, unavailable)},
+    {"member_count", SNAPSHOT_FIELD_INT, offsetof(discord_guild, member_count)},
+    {"max_presences", SNAPSHOT_FIELD_INT, offsetof(discord_guild, max_presences)},
+    {"max_members", SNAPSHOT_FIELD_INT, offsetof(discord_guild, max_members)},
+    {"vanity_url_code", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, vanity_url_code)},
+    {"description", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, description)},
+    {"banner", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, banner)},
+    {"premium_tier", SNAPSHOT_FIELD_INT, offsetof(discord_guild, premium_tier)},
+    {"premium_subscription_count", SNAPSHOT_FIELD_INT, offsetof(discord_guild, premium_subscription_count)},
+    {"preferred_locale", SNAPSHOT_FIELD_STRING, offsetof(discord_guild, preferred_locale)},
+    {"public_updates_channel_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_guild, public_updates_channel_id)},
+    {"max_video_channel_users", SNAPSHOT_FIELD_INT, offsetof(discord_guild, max_video_channel_users)},
+    {"nsfw_level", SNAPSHOT_FIELD_INT, offsetof(discord_guild, nsfw_level)},
+    {"premium_progress_bar_enabled", SNAPSHOT_FIELD_BOOL, offsetof(discord_guild, premium_progress_bar_enabled)}
+};
+
+static const discord_snapshot_field emoji_fields[] = {
+    {"id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_emoji, id)},
+    {"name", SNAPSHOT_FIELD_STRING, offsetof(discord_emoji, name)},
+    {"roles", SNAPSHOT_FIELD_SNOWFLAKE_LIST, offsetof(discord_emoji, roles)},
+    {"user", SNAPSHOT_FIELD_USER, offsetof(discord_emoji, user)},
+    {"require_colons", SNAPSHOT_FIELD_BOOL, offsetof(discord_emoji, require_colons)},
+    {"managed", SNAPSHOT_FIELD_BOOL, offsetof(discord_emoji, managed)},
+    {"animated", SNAPSHOT_FIELD_BOOL, offsetof(discord_emoji, animated)},
+    {"available", SNAPSHOT_FIELD_BOOL, offsetof(discord_emoji, available)}
+};
+
+static const discord_snapshot_field member_fields[] = {
+    {"guild_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_member, guild_id)},
+    {"user", SNAPSHOT_FIELD_USER, offsetof(discord_member, user)},
+    {"nick", SNAPSHOT_FIELD_STRING, offsetof(discord_member, nick)},
+    {"avatar", SNAPSHOT_FIELD_STRING, offsetof(discord_member, avatar)},
+    {"roles", SNAPSHOT_FIELD_SNOWFLAKE_SET, offsetof(discord_member, roles)},
+    {"joined_at", SNAPSHOT_FIELD_STRING, offsetof(discord_member, joined_at)},
+    {"premium_since", SNAPSHOT_FIELD_STRING, offsetof(discord_member, premium_since)},
+    {"deaf", SNAPSHOT_FIELD_BOOL, offsetof(discord_member, deaf)},
+    {"mute", SNAPSHOT_FIELD_BOOL, offsetof(discord_member, mute)},
+    {"pending", SNAPSHOT_FIELD_BOOL, offsetof(discord_member, pending)},
+    {"permissions", SNAPSHOT_FIELD_STRING, offsetof(discord_member, permissions)},
+    {"communication_disabled_until", SNAPSHOT_FIELD_STRING, offsetof(discord_member, communication_disabled_until)}
+};
+
+/* tags are left out -- nothing reads them back */
+static const discord_snapshot_field role_fields[] = {
+    {"id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_role, id)},
+    {"guild_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_role, guild_id)},
+    {"name", SNAPSHOT_FIELD_STRING, offsetof(discord_role, name)},
+    {"color", SNAPSHOT_FIELD_INT, offsetof(discord_role, color)},
+    {"hoist", SNAPSHOT_FIELD_BOOL, offsetof(discord_role, hoist)},
+    {"icon", SNAPSHOT_FIELD_STRING, offsetof(discord_role, icon)},
+    {"unicode_emoji", SNAPSHOT_FIELD_STRING, offsetof(discord_role, unicode_emoji)},
+    {"position", SNAPSHOT_FIELD_INT, offsetof(discord_role, position)},
+    {"permissions", SNAPSHOT_FIELD_STRING, offsetof(discord_role, permissions)},
+    {"managed", SNAPSHOT_FIELD_BOOL, offsetof(discord_role, managed)},
+    {"mentionable", SNAPSHOT_FIELD_BOOL, offsetof(discord_role, mentionable)}
+};
+
+static const discord_snapshot_field channel_fields[] = {
+    {"id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_channel, id)},
+    {"type", SNAPSHOT_FIELD_INT, offsetof(discord_channel, type)},
+    {"guild_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_channel, guild_id)},
+    {"position", SNAPSHOT_FIELD_INT, offsetof(discord_channel, position)},
+    {"permission_overwrites", SNAPSHOT_FIELD_OVERWRITE_LIST, offsetof(discord_channel, permission_overwrites)},
+    {"name", SNAPSHOT_FIELD_STRING, offsetof(discord_channel, name)},
+    {"topic", SNAPSHOT_FIELD_STRING, offsetof(discord_channel, topic)},
+    {"nsfw", SNAPSHOT_FIELD_BOOL, offsetof(discord_channel, nsfw)},
+    {"last_message_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_channel, last_message_id)},
+    {"bitrate", SNAPSHOT_FIELD_INT, offsetof(discord_channel, bitrate)},
+    {"user_limit", SNAPSHOT_FIELD_INT, offsetof(discord_channel, user_limit)},
+    {"rate_limit_per_user", SNAPSHOT_FIELD_INT, offsetof(discord_channel, rate_limit_per_user)},
+    {"icon", SNAPSHOT_FIELD_STRING, offsetof(discord_channel, icon)},
+    {"owner_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_channel, owner_id)},
+    {"application_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_channel, application_id)},
+    {"parent_id", SNAPSHOT_FIELD_SNOWFLAKE, offsetof(discord_channel, parent_id)},
+    {"last_pin_timestamp", SNAPSHOT_FIELD_STRING, offsetof(discord_channel, last_pin_timestamp)},
+    {"rtc_region", SNAPSHOT_FIELD_STRING, offsetof(discord_channel, rtc_region)},
+    {"video_quality_mode", SNAPSHOT_FIELD_INT, offsetof(discord_channel, video_quality_mode)},
+    {"default_auto_archive_duration", SNAPSHOT_FIELD_INT, offsetof(discord_channel, default_auto_archive_duration)},
+    {"permissions", SNAPSHOT_FIELD_STRING, offsetof(discord_channel, permissions)},
+    {"flags", SNAPSHOT_FIELD_INT, offsetof(discord_channel, flags)}
+};
+
+static const discord_snapshot_field *get_fields(discord_snapshot_kind kind, size_t *count){
+    switch (kind){
+    case SNAPSHOT_USERS:
+        *count = sizeof(user_fields) / sizeof(*user_fields);
+
+        return user_fields;
+    case SNAPSHOT_GUILDS:
+        *count = sizeof(guild_fields) / sizeof(*guild_fields);
+
+        return guild_fields;
+    case SNAPSHOT_EMOJIS:
+        *count = sizeof(emoji_fields) / sizeof(*emoji_fields);
+
+        return emoji_fields;
+    case SNAPSHOT_MEMBERS:
+        *count = sizeof(member_fields) / sizeof(*member_fields);
+
+        return member_fields;
+    case SNAPSHOT_ROLES:
+        *count = sizeof(role_fields) / sizeof(*role_fields);
+
+        return role_fields;
+    case SNAPSHOT_CHANNELS:
+        *count = sizeof(channel_fields) / sizeof(*channel_fields);
+
+        return channel_fields;
+    default:
+        *count = 0;
+
+        return NULL;
+    }
+}
+
+static bool reserve_buffer(discord_snapshot_buffer *buffer, size_t size){
+    if (buffer->size + size <= buffer->capacity){
+        return true;
+    }
+
+    size_t capacity = buffer->capacity ? buffer->capacity : DISCORD_SNAPSHOT_INITIAL_CAPACITY;
+
+    while (capacity < buffer->size + size){
+        capacity *= 2;
+    }
+
+    unsigned char *data = realloc(buffer->data, capacity);
+
+    if (!data){
+        DLOG(
+            "[%s] reserve_buffer() - data realloc failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    buffer->data = data;
+    buffer->capacity = capacity;
+
+    return true;
+}
+
+/* integers are stored little-endian regardless of the host */
+static bool write_bytes(discord_snapshot_buffer *buffer, uint64_t value, size_t width){
+    if (!reserve_buffer(buffer, width)){
+        return false;
+    }
+
+    for (size_t index = 0; index < width; ++index){
+        buffer->data[buffer->size++] = (value >> (index * 8)) & 0xff;
+    }
+
+    return true;
+}
+
+static bool read_bytes(discord_snapshot_reader *reader, uint64_t *value, size_t width){
+    if (reader->size - reader->offset < width){
+        DLOG(
+            "[%s] read_bytes() - snapshot truncated at offset %zu\n",
+            __FILE__,
+            reader->offset
+        );
+
+        return false;
+    }
+
+    *value = 0;
+
+    for (size_t index = 0; index < width; ++index){
+        *value |= (uint64_t)reader->data[reader->offset++] << (index * 8);
+    }
+
+    return true;
+}
+
+bool snapshot_write_u8(discord_snapshot_buffer *buffer, uint8_t value){
+    return write_bytes(buffer, value, sizeof(value));
+}
+
+bool snapshot_write_u32(discord_snapshot_buffer *buffer, uint32_t value){
+    return write_bytes(buffer, value, sizeof(value));
+}
+
+bool snapshot_write_u64(discord_snapshot_buffer *buffer, uint64_t value){
+    return write_bytes(buffer, value, sizeof(value));
+}
+
+bool snapshot_write_string(discord_snapshot_buffer *buffer, const char *value){
+    if (!value){
+        return snapshot_write_u32(buffer, DISCORD_SNAPSHOT_NULL_STRING);
+    }
+
+    size_t length = strlen(value);
+
+    if (length >= DISCORD_SNAPSHOT_NULL_STRING){
+        DLOG(
+            "[%s] snapshot_write_string() - string too long (%zu bytes)\n",
+            __FILE__,
+            length
+        );
+
+        return false;
+    }
+
+    if (!snapshot_write_u32(buffer, length) || !reserve_buffer(buffer, length)){
+        return false;
+    }
+
+    memcpy(buffer->data + buffer->size, value, length);
+
+    buffer->size += length;
+
+    return true;
+}
+
+static bool write_overwrite(discord_snapshot_buffer *buffer, const discord_overwrite *overwrite){
+    return snapshot_write_u64(buffer, overwrite->id) &&
+           snapshot_write_u8(buffer, overwrite->type) &&
+           snapshot_write_u64(buffer, overwrite->allow) &&
+           snapshot_write_u64(buffer, overwrite->deny);
+}
+
+static bool write_field(discord_snapshot_buffer *buffer, const discord_snapshot_field *field, const unsigned char *base){
+    const void *ptr = base + field->offset;
+
+    snowflake id = 0;
+    const char *string = NULL;
+    const list *items = NULL;
+    const snowflake_set *set = NULL;
+    const discord_user *user = NULL;
+    bool boolean = false;
+    int integer = 0;
+
+    size_t length = 0;
+
+    switch (field->type){
+    case SNAPSHOT_FIELD_SNOWFLAKE:
+        memcpy(&id, ptr, sizeof(id));
+
+        return snapshot_write_u64(buffer, id);
+    case SNAPSHOT_FIELD_STRING:
+        memcpy(&string, ptr, sizeof(string));
+
+        return snapshot_write_string(buffer, string);
+    case SNAPSHOT_FIELD_BOOL:
+        memcpy(&boolean, ptr, sizeof(boolean));
+
+        return snapshot_write_u8(buffer, boolean);
+    case SNAPSHOT_FIELD_INT:
+        memcpy(&integer, ptr, sizeof(integer));
+
+        return snapshot_write_u32(buffer, (uint32_t)integer);
+    case SNAPSHOT_FIELD_SNOWFLAKE_LIST:
+        memcpy(&items, ptr, sizeof(items));
+
+        length = list_get_length(items);
+
+        if (!snapshot_write_u32(buffer, length)){
+            return false;
+        }
+
+        for (size_t index = 0; index < length; ++index){
+            if (!snapshot_write_u64(buffer, list_get_uint(items, index))){
+                return false;
+            }
+        }
+
+        return true;
+    case SNAPSHOT_FIELD_STRING_LIST:
+        memcpy(&items, ptr, sizeof(items));
+
+        length = list_get_length(items);
+
+        if (!snapshot_write_u32(buffer, length)){
+            return false;
+        }
+
+        for (size_t index = 0; index < length; ++index){
+            if (!snapshot_write_string(buffer, list_get_string(items, index))){
+                return false;
+            }
+        }
+
+        return true;
+    case SNAPSHOT_FIELD_SNOWFLAKE_SET:
+        memcpy(&set, ptr, sizeof(set));
+
+        length = snowflake_set_get_length(set);
+
+        /* same encoding as a snowflake list */
+        if (!snapshot_write_u32(buffer, length)){
+            return false;
+        }
+
+        for (size_t index = 0; index < length; ++index){
+            if (!snapshot_write_u64(buffer, set->ids[index])){
+                return false;
+            }
+        }
+
+        return true;
+    case SNAPSHOT_FIELD_USER:
+        memcpy(&user, ptr, sizeof(user));
+
+        return snapshot_write_u64(buffer, user ? user->id : 0);
+    case SNAPSHOT_FIELD_OVERWRITE_LIST:
+        memcpy(&items, ptr, sizeof(items));
+
+        length = list_get_length(items);
+
+        if (!snapshot_write_u32(buffer, length)){
+            return false;
+        }
+
+        for (size_t index = 0; index < length; ++index){
+            if (!write_overwrite(buffer, list_get_generic(items, index))){
+                return false;
+            }
+        }
+
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool snapshot_write_entity(discord_snapshot_buffer *buffer, discord_snapshot_kind kind, const void *entity){
+    if (!buffer || !entity){
+        DLOG(
+            "[%s] snapshot_write_entity() - buffer and entity are required\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    size_t count = 0;
+    const discord_snapshot_field *fields = get_fields(kind, &count);
+
+    if (!fields){
+        DLOG(
+            "[%s] snapshot_write_entity() - unknown kind %d\n",
+            __FILE__,
+            kind
+        );
+
+        return false;
+    }
+
+    for (size_t index = 0; index < count; ++index){
+        if (!write_field(buffer, &fields[index], entity)){
+            DLOG(
+                "[%s] snapshot_write_entity() - failed to write field %s\n",
+                __FILE__,
+                fields[index].key
+            );
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool snapshot_read_u8(discord_snapshot_reader *reader, uint8_t *value){
+    uint64_t tmp = 0;
+
+    if (!read_bytes(reader, &tmp, sizeof(*value))){
+        return false;
+    }
+
+    *value = tmp;
+
+    return true;
+}
+
+bool snapshot_read_u32(discord_snapshot_reader *reader, uint32_t *value){
+    uint64_t tmp = 0;
+
+    if (!read_bytes(reader, &tmp, sizeof(*value))){
+        return false;
+    }
+
+    *value = tmp;
+
+    return true;
+}
+
+bool snapshot_read_u64(discord_snapshot_reader *reader, uint64_t *value){
+    return read_bytes(reader, value, sizeof(*value));
+}
+
+/* the returned string points into the snapshot and is not NUL terminated */
+bool snapshot_read_string(discord_snapshot_reader *reader, const char **value, size_t *length){
+    uint32_t tmp = 0;
+
+    if (!snapshot_read_u32(reader, &tmp)){
+        return false;
+    }
+
+    if (tmp == DISCORD_SNAPSHOT_NULL_STRING){
+        *value = NULL;
+        *length = 0;
+
+        return true;
+    }
+
+    if (reader->size - reader->offset < tmp){
+        DLOG(
+            "[%s] snapshot_read_string() - snapshot truncated at offset %zu\n",
+            __FILE__,
+            reader->offset
+        );
+
+        return false;
+    }
+
+    *value = (const char *)reader->data + reader->offset;
+    *length = tmp;
+
+    reader->offset += tmp;
+
+    return true;
+}
+
+static json_object *new_snowflake_object(snowflake id){
+    char idstr[21] = {0};
+
+    snprintf(idstr, sizeof(idstr), "%" PRIu64, id);
+
+    return json_object_new_string(idstr);
+}
+
+static json_object *new_string_object(discord_snapshot_reader *reader, bool *success){
+    const char *string = NULL;
+    size_t length = 0;
+
+    *success = snapshot_read_string(reader, &string, &length);
+
+    if (!*success || !string){
+        return NULL;
+    }
+
+    json_object *obj = json_object_new_string_len(string, length);
+
+    *success = obj;
+
+    return obj;
+}
+
+static json_object *new_permission_object(discord_permissions permissions){
+    char permstr[21] = {0};
+
+    snprintf(permstr, sizeof(permstr), "%" PRIu64, permissions);
+
+    return json_object_new_string(permstr);
+}
+
+/* shaped like a gateway overwrite so overwrite_from_json reads it back */
+static json_object *read_overwrite(discord_snapshot_reader *reader, bool *success){
+    snowflake id = 0;
+    uint8_t type = 0;
+    discord_permissions allow = 0;
+    discord_permissions deny = 0;
+
+    *success = snapshot_read_u64(reader, &id) &&
+               snapshot_read_u8(reader, &type) &&
+               snapshot_read_u64(reader, &allow) &&
+               snapshot_read_u64(reader, &deny);
+
+    if (!*success){
+        return NULL;
+    }
+
+    json_object *obj = json_object_new_object();
+
+    *success = obj &&
+               !json_object_object_add(obj, "id", new_snowflake_object(id)) &&
+               !json_object_object_add(obj, "type", json_object_new_int(type)) &&
+               !json_object_object_add(obj, "allow", new_permission_object(allow)) &&
+               !json_object_object_add(obj, "deny", new_permission_object(deny));
+
+    if (!*success){
+        json_object_put(obj);
+
+        return NULL;
+    }
+
+    return obj;
+}
+
+/* fewest bytes one element of a list can take up */
+static size_t get_element_width(discord_snapshot_type type){
+    switch (type){
+    case SNAPSHOT_FIELD_SNOWFLAKE_LIST:
+    case SNAPSHOT_FIELD_SNOWFLAKE_SET:
+        return sizeof(uint64_t);
+    case SNAPSHOT_FIELD_OVERWRITE_LIST:
+        return 3 * sizeof(uint64_t) + sizeof(uint8_t);
+    default:
+        /* a string's length prefix */
+        return sizeof(uint32_t);
+    }
+}
+
+static json_object *read_list(discord_snapshot_reader *reader, discord_snapshot_type type, bool *success){
+    uint32_t length = 0;
+
+    *success = snapshot_read_u32(reader, &length);
+
+    if (!*success){
+        return NULL;
+    }
+
+    /* a count the rest of the file can't hold is corrupt -- don't size an array by it */
+    if (length > (reader->size - reader->offset) / get_element_width(type)){
+        DLOG(
+            "[%s] read_list() - %" PRIu32 " element list overruns snapshot at offset %zu\n",
+            __FILE__,
+            length,
+            reader->offset
+        );
+
+        *success = false;
+
+        return NULL;
+    }
+
+    json_object *array = json_object_new_array_ext(length);
+
+    if (!array){
+        *success = false;
+
+        return NULL;
+    }
+
+    for (uint32_t index = 0; index < length && *success; ++index){
+        json_object *obj = NULL;
+        snowflake id = 0;
+
+        if (type == SNAPSHOT_FIELD_SNOWFLAKE_LIST || type == SNAPSHOT_FIELD_SNOWFLAKE_SET){
+            *success = snapshot_read_u64(reader, &id) && (obj = new_snowflake_object(id));
+        }
+        else if (type == SNAPSHOT_FIELD_OVERWRITE_LIST){
+            obj = read_overwrite(reader, success);
+        }
+        else {
+            obj = new_string_object(reader, success);
+        }
+
+        if (*success && json_object_array_add(array, obj)){
+            json_object_put(obj);
+
+            *success = false;
+        }
+    }
+
+    if (!*success){
+        json_object_put(array);
+
+        return NULL;
+    }
+
+    return array;
+}
+
+static bool read_field(discord_snapshot_reader *reader, const discord_snapshot_field *field, json_object *object){
+    json_object *obj = NULL;
+    bool success = true;
+
+    snowflake id = 0;
+    uint8_t boolean = 0;
+    uint32_t integer = 0;
+
+    switch (field->type){
+    case SNAPSHOT_FIELD_SNOWFLAKE:
+        success = snapshot_read_u64(reader, &id);
+
+        if (success && id){
+            success = (obj = new_snowflake_object(id));
+        }
+
+        break;
+    case SNAPSHOT_FIELD_STRING:
+        obj = new_string_object(reader, &success);
+
+        break;
+    case SNAPSHOT_FIELD_BOOL:
+        success = snapshot_read_u8(reader, &boolean) && (obj = json_object_new_boolean(boolean));
+
+        break;
+    case SNAPSHOT_FIELD_INT:
+        success = snapshot_read_u32(reader, &integer) && (obj = json_object_new_int((int32_t)integer));
+
+        break;
+    case SNAPSHOT_FIELD_SNOWFLAKE_LIST:
+    case SNAPSHOT_FIELD_STRING_LIST:
+    case SNAPSHOT_FIELD_SNOWFLAKE_SET:
+    case SNAPSHOT_FIELD_OVERWRITE_LIST:
+        obj = read_list(reader, field->type, &success);
+
+        break;
+    case SNAPSHOT_FIELD_USER:
+        success = snapshot_read_u64(reader, &id);
+
+        if (success && id){
+            /* users are restored first -- a bare id resolves to the cached one */
+            success = (obj = json_object_new_object()) && !json_object_object_add(
+                obj,
+                "id",
+                new_snowflake_object(id)
+            );
+        }
+
+        break;
+    default:
+        success = false;
+    }
+
+    if (!success){
+        json_object_put(obj);
+
+        return false;
+    }
+
+    /* absent snowflakes, strings and users are left out like in gateway payloads */
+    if (obj && json_object_object_add(object, field->key, obj)){
+        json_object_put(obj);
+
+        return false;
+    }
+
+    return true;
+}
+
+json_object *snapshot_read_entity(discord_snapshot_reader *reader, discord_snapshot_kind kind){
+    if (!reader){
+        DLOG(
+            "[%s] snapshot_read_entity() - reader is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    size_t count = 0;
+    const discord_snapshot_field *fields = get_fields(kind, &count);
+
+    if (!fields){
+        DLOG(
+            "[%s] snapshot_read_entity() - unknown kind %d\n",
+            __FILE__,
+            kind
+        );
+
+        return NULL;
+    }
+
+    json_object *object = json_object_new_object();
+
+    if (!object){
+        DLOG(
+            "[%s] snapshot_read_entity() - object initialization failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    for (size_t index = 0; index < count; ++index){
+        if (!read_field(reader, &fields[index], object)){
+            DLOG(
+                "[%s] snapshot_read_entity() - failed to read field %s\n",
+                __FILE__,
+                fields[index].key
+            );
+
+            json_object_put(object);
+
+            return NULL;
+        }
+    }
+
+    return object;
+}
+
+void snapshot_buffer_free(discord_snapshot_buffer *buffer){
+    if (!buffer){
+        return;
+    }
+
+    free(buffer->data);
+
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
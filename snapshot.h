@@ -0,0 +1,79 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "snowflake.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json-c/json.h>
+
+/* "DCSN" read as a little-endian integer */
+#define DISCORD_SNAPSHOT_MAGIC 0x4e534344
+#define DISCORD_SNAPSHOT_VERSION 2
+#define DISCORD_SNAPSHOT_INITIAL_CAPACITY 4096
+
+/* marks a NULL string -- distinct from an empty one */
+#define DISCORD_SNAPSHOT_NULL_STRING UINT32_MAX
+
+typedef enum discord_snapshot_kind {
+    SNAPSHOT_END,
+    SNAPSHOT_USERS,
+    SNAPSHOT_GUILDS,
+    SNAPSHOT_EMOJIS,
+    SNAPSHOT_MEMBERS,
+    SNAPSHOT_ROLES,
+    SNAPSHOT_CHANNELS
+} discord_snapshot_kind;
+
+typedef enum discord_snapshot_type {
+    SNAPSHOT_FIELD_SNOWFLAKE,
+    SNAPSHOT_FIELD_STRING,
+    SNAPSHOT_FIELD_BOOL,
+    SNAPSHOT_FIELD_INT,
+    SNAPSHOT_FIELD_SNOWFLAKE_LIST,
+    SNAPSHOT_FIELD_STRING_LIST,
+    SNAPSHOT_FIELD_SNOWFLAKE_SET,
+    SNAPSHOT_FIELD_USER,
+    SNAPSHOT_FIELD_OVERWRITE_LIST
+} discord_snapshot_type;
+
+/*
+ * entities are written field by field from these tables and read back into
+ * json objects shaped like the gateway payloads, so restoring goes through
+ * the regular state_set_* constructors
+ */
+typedef struct discord_snapshot_field {
+    const char *key;
+    discord_snapshot_type type;
+    size_t offset;
+} discord_snapshot_field;
+
+typedef struct discord_snapshot_buffer {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} discord_snapshot_buffer;
+
+typedef struct discord_snapshot_reader {
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+} discord_snapshot_reader;
+
+bool snapshot_write_u8(discord_snapshot_buffer *, uint8_t);
+bool snapshot_write_u32(discord_snapshot_buffer *, uint32_t);
+bool snapshot_write_u64(discord_snapshot_buffer *, uint64_t);
+bool snapshot_write_string(discord_snapshot_buffer *, const char *);
+bool snapshot_write_entity(discord_snapshot_buffer *, discord_snapshot_kind, const void *);
+
+bool snapshot_read_u8(discord_snapshot_reader *, uint8_t *);
+bool snapshot_read_u32(discord_snapshot_reader *, uint32_t *);
+bool snapshot_read_u64(discord_snapshot_reader *, uint64_t *);
+bool snapshot_read_string(discord_snapshot_reader *, const char **, size_t *);
+json_object *snapshot_read_entity(discord_snapshot_reader *, discord_snapshot_kind);
+
+void snapshot_buffer_free(discord_snapshot_buffer *);
+
+#endif
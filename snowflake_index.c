@@ -0,0 +1,353 @@
+#include "snowflake_index.h"
+
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void release_bucket(void *ptr){
+    snowflake_index_bucket *bucket = ptr;
+
+    free(bucket->entries);
+    free(bucket);
+}
+
+static void free_bucket(void *ptr){
+    snowflake_index_bucket *bucket = ptr;
+
+    if (!bucket){
+        return;
+    }
+
+    const snowflake_index *index = bucket->index;
+
+    if (index->retire){
+        index->retire(index->context, bucket, release_bucket);
+    }
+    else {
+        release_bucket(bucket);
+    }
+}
+
+static snowflake_index_bucket *copy_bucket(const snowflake_index *index, const snowflake_index_bucket *bucket, size_t capacity){
+    snowflake_index_bucket *copy = calloc(1, sizeof(*copy));
+
+    if (!copy){
+        return NULL;
+    }
+
+    copy->index = index;
+    copy->entries = malloc(capacity * sizeof(*copy->entries));
+
+    if (!copy->entries){
+        free(copy);
+
+        return NULL;
+    }
+
+    copy->capacity = capacity;
+
+    if (bucket){
+        memcpy(copy->entries, bucket->entries, bucket->length * sizeof(*bucket->entries));
+
+        copy->length = bucket->length;
+    }
+
+    return copy;
+}
+
+/* first position whose id is not less than id */
+static size_t find_position(const snowflake_index_bucket *bucket, snowflake id){
+    size_t low = 0;
+    size_t high = bucket->length;
+
+    while (low < high){
+        size_t middle = low + (high - low) / 2;
+
+        if (bucket->entries[middle].id < id){
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/* the caller makes room first */
+static void insert_entry(snowflake_index_bucket *bucket, size_t position, snowflake id, void *value){
+    /* snowflakes grow with time, so this is almost always an append */
+    memmove(
+        &bucket->entries[position + 1],
+        &bucket->entries[position],
+        (bucket->length - position) * sizeof(*bucket->entries)
+    );
+
+    bucket->entries[position].id = id;
+    bucket->entries[position].value = value;
+
+    ++bucket->length;
+}
+
+static void remove_entry(snowflake_index_bucket *bucket, size_t position){
+    --bucket->length;
+
+    memmove(
+        &bucket->entries[position],
+        &bucket->entries[position + 1],
+        (bucket->length - position) * sizeof(*bucket->entries)
+    );
+}
+
+/* builds the changed bucket aside and swaps it in -- the map retires the old one */
+static bool replace_bucket(snowflake_index *index, snowflake key, const snowflake_index_bucket *bucket, size_t position, snowflake id, void *value, bool removing){
+    bool exists = bucket && position < bucket->length && bucket->entries[position].id == id;
+    size_t length = bucket ? bucket->length : 0;
+    snowflake_index_bucket *copy = NULL;
+
+    if (!removing){
+        copy = copy_bucket(index, bucket, exists ? length : length + 1);
+    }
+    else if (length > 1){
+        copy = copy_bucket(index, bucket, length);
+    }
+    else {
+        return snowflake_map_remove(index->buckets, key);
+    }
+
+    if (!copy){
+        DLOG(
+            "[%s] replace_bucket() - copy_bucket call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (removing){
+        remove_entry(copy, position);
+    }
+    else if (exists){
+        copy->entries[position].value = value;
+    }
+    else {
+        insert_entry(copy, position, id, value);
+    }
+
+    if (!snowflake_map_set(index->buckets, key, copy)){
+        DLOG(
+            "[%s] replace_bucket() - snowflake_map_set call failed\n",
+            __FILE__
+        );
+
+        release_bucket(copy);
+
+        return false;
+    }
+
+    return true;
+}
+
+snowflake_index *snowflake_index_init(void){
+    snowflake_index *index = calloc(1, sizeof(*index));
+
+    if (!index){
+        DLOG(
+            "[%s] snowflake_index_init() - index alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    index->buckets = snowflake_map_init(free_bucket);
+
+    if (!index->buckets){
+        DLOG(
+            "[%s] snowflake_index_init() - buckets map initialization failed\n",
+            __FILE__
+        );
+
+        free(index);
+
+        return NULL;
+    }
+
+    return index;
+}
+
+bool snowflake_index_insert(snowflake_index *index, snowflake key, snowflake id, void *value){
+    if (!index){
+        DLOG(
+            "[%s] snowflake_index_insert() - index is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!key || !id){
+        DLOG(
+            "[%s] snowflake_index_insert() - key and id must be nonzero\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    snowflake_index_bucket *bucket = snowflake_map_get(index->buckets, key);
+
+    if (index->retire){
+        return replace_bucket(index, key, bucket, bucket ? find_position(bucket, id) : 0, id, value, false);
+    }
+
+    if (!bucket){
+        bucket = calloc(1, sizeof(*bucket));
+
+        if (!bucket){
+            DLOG(
+                "[%s] snowflake_index_insert() - bucket alloc failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        bucket->index = index;
+
+        if (!snowflake_map_set(index->buckets, key, bucket)){
+            DLOG(
+                "[%s] snowflake_index_insert() - snowflake_map_set call failed\n",
+                __FILE__
+            );
+
+            free(bucket);
+
+            return false;
+        }
+    }
+
+    size_t position = find_position(bucket, id);
+
+    if (position < bucket->length && bucket->entries[position].id == id){
+        bucket->entries[position].value = value;
+
+        return true;
+    }
+
+    if (bucket->length == bucket->capacity){
+        size_t capacity = bucket->capacity ? bucket->capacity * 2 : SNOWFLAKE_INDEX_INITIAL_CAPACITY;
+        snowflake_index_entry *entries = realloc(bucket->entries, capacity * sizeof(*entries));
+
+        if (!entries){
+            DLOG(
+                "[%s] snowflake_index_insert() - entries realloc failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        bucket->entries = entries;
+        bucket->capacity = capacity;
+    }
+
+    insert_entry(bucket, position, id, value);
+
+    return true;
+}
+
+bool snowflake_index_remove(snowflake_index *index, snowflake key, snowflake id){
+    if (!index){
+        return false;
+    }
+
+    snowflake_index_bucket *bucket = snowflake_map_get(index->buckets, key);
+
+    if (!bucket){
+        return false;
+    }
+
+    size_t position = find_position(bucket, id);
+
+    if (position == bucket->length || bucket->entries[position].id != id){
+        return false;
+    }
+
+    if (index->retire){
+        return replace_bucket(index, key, bucket, position, id, NULL, true);
+    }
+
+    remove_entry(bucket, position);
+
+    if (!bucket->length){
+        snowflake_map_remove(index->buckets, key);
+    }
+
+    return true;
+}
+
+size_t snowflake_index_get_length(const snowflake_index *index, snowflake key){
+    if (!index){
+        return 0;
+    }
+
+    const snowflake_index_bucket *bucket = snowflake_map_get(index->buckets, key);
+
+    return bucket ? bucket->length : 0;
+}
+
+/*
+ * points entries at the ids strictly between after and before (0 leaves that
+ * side open) and returns how many there are -- valid until the next change,
+ * or until the bucket is retired when retire is set
+ */
+size_t snowflake_index_get_range(const snowflake_index *index, snowflake key, snowflake after, snowflake before, const snowflake_index_entry **entries){
+    if (!index || !entries){
+        DLOG(
+            "[%s] snowflake_index_get_range() - index and entries are required\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+
+    *entries = NULL;
+
+    const snowflake_index_bucket *bucket = snowflake_map_get(index->buckets, key);
+
+    if (!bucket){
+        return 0;
+    }
+
+    size_t first = after ? find_position(bucket, after) : 0;
+
+    if (after && first < bucket->length && bucket->entries[first].id == after){
+        ++first;
+    }
+
+    size_t last = before ? find_position(bucket, before) : bucket->length;
+
+    if (last <= first){
+        return 0;
+    }
+
+    *entries = &bucket->entries[first];
+
+    return last - first;
+}
+
+void snowflake_index_free(snowflake_index *index){
+    if (!index){
+        DLOG(
+            "[%s] snowflake_index_free() - index is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    snowflake_map_free(index->buckets);
+
+    free(index);
+}
@@ -0,0 +1,52 @@
+#ifndef SNOWFLAKE_INDEX_H
+#define SNOWFLAKE_INDEX_H
+
+#include "snowflake_map.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SNOWFLAKE_INDEX_INITIAL_CAPACITY 8
+
+typedef struct snowflake_index_entry {
+    snowflake id;
+    void *value;
+} snowflake_index_entry;
+
+struct snowflake_index;
+
+/* entries are kept in ascending id order -- i.e. oldest first */
+typedef struct snowflake_index_bucket {
+    const struct snowflake_index *index;
+
+    snowflake_index_entry *entries;
+    size_t length;
+    size_t capacity;
+} snowflake_index_bucket;
+
+/*
+ * groups values under a secondary key (a channel, an author) so they can be
+ * walked in id order without touching anything outside the group
+ *
+ * buckets are changed in place unless retire is set -- then every change
+ * copies the bucket, swaps it into a concurrent map and hands the old one to
+ * retire so readers walking it are never cut short
+ */
+typedef struct snowflake_index {
+    snowflake_map *buckets;
+
+    void (*retire)(void *, void *, void (*)(void *));
+    void *context;
+} snowflake_index;
+
+snowflake_index *snowflake_index_init(void);
+
+bool snowflake_index_insert(snowflake_index *, snowflake, snowflake, void *);
+bool snowflake_index_remove(snowflake_index *, snowflake, snowflake);
+
+size_t snowflake_index_get_length(const snowflake_index *, snowflake);
+size_t snowflake_index_get_range(const snowflake_index *, snowflake, snowflake, snowflake, const snowflake_index_entry **);
+
+void snowflake_index_free(snowflake_index *);
+
+#endif
@@ -0,0 +1,378 @@
+#include "snowflake_map.h"
+
+#include "log.h"
+
+#include <stdlib.h>
+
+static size_t hash_snowflake(snowflake key){
+    /* murmur3 finalizer -- snowflakes share their high (timestamp) bits */
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+
+    return key;
+}
+
+static void begin_write(snowflake_map *map){
+    atomic_fetch_add_explicit(&map->sequence, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void end_write(snowflake_map *map){
+    atomic_fetch_add_explicit(&map->sequence, 1, memory_order_release);
+}
+
+static bool resize_map(snowflake_map *map, size_t capacity){
+    snowflake_map_table *table = calloc(1, sizeof(*table) + capacity * sizeof(*table->entries));
+
+    if (!table){
+        DLOG(
+            "[%s] resize_map() - table alloc failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    table->capacity = capacity;
+
+    size_t mask = capacity - 1;
+    snowflake_map_table *curr = map->table;
+
+    for (size_t index = 0; curr && index < curr->capacity; ++index){
+        snowflake_map_entry *entry = &curr->entries[index];
+        snowflake key = entry->key;
+
+        if (!key){
+            continue;
+        }
+
+        size_t slot = hash_snowflake(key) & mask;
+
+        while (table->entries[slot].key){
+            slot = (slot + 1) & mask;
+        }
+
+        table->entries[slot].value = entry->value;
+        table->entries[slot].key = key;
+    }
+
+    /* readers may still be probing the old table */
+    if (curr && map->concurrent){
+        table->retired = curr;
+    }
+    else {
+        free(curr);
+    }
+
+    map->table = table;
+
+    return true;
+}
+
+static snowflake_map_entry *find_entry(const snowflake_map_table *table, snowflake key){
+    size_t mask = table->capacity - 1;
+
+    for (size_t slot = hash_snowflake(key) & mask; table->entries[slot].key; slot = (slot + 1) & mask){
+        if (table->entries[slot].key == key){
+            return (snowflake_map_entry *)&table->entries[slot];
+        }
+    }
+
+    return NULL;
+}
+
+static void remove_entry(snowflake_map *map, size_t hole){
+    snowflake_map_table *table = map->table;
+    size_t mask = table->capacity - 1;
+
+    /* backward shift deletion keeps probe sequences intact without tombstones */
+    for (size_t next = (hole + 1) & mask; table->entries[next].key; next = (next + 1) & mask){
+        size_t home = hash_snowflake(table->entries[next].key) & mask;
+        bool movable = false;
+
+        if (next > hole){
+            movable = home <= hole || home > next;
+        }
+        else {
+            movable = home <= hole && home > next;
+        }
+
+        if (movable){
+            table->entries[hole].value = table->entries[next].value;
+            table->entries[hole].key = table->entries[next].key;
+
+            hole = next;
+        }
+    }
+
+    table->entries[hole].key = 0;
+    table->entries[hole].value = NULL;
+
+    --map->length;
+}
+
+snowflake_map *snowflake_map_init(void (*value_free)(void *)){
+    snowflake_map *map = calloc(1, sizeof(*map));
+
+    if (!map){
+        DLOG(
+            "[%s] snowflake_map_init() - map alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    map->value_free = value_free;
+
+    if (!resize_map(map, SNOWFLAKE_MAP_INITIAL_CAPACITY)){
+        DLOG(
+            "[%s] snowflake_map_init() - resize_map call failed\n",
+            __FILE__
+        );
+
+        snowflake_map_free(map);
+
+        return NULL;
+    }
+
+    return map;
+}
+
+void *snowflake_map_get(const snowflake_map *map, snowflake key){
+    if (!map || !key){
+        return NULL;
+    }
+
+    void *value = NULL;
+    size_t sequence = 0;
+
+    /* retry if the writer touched the map while we were probing */
+    do {
+        sequence = atomic_load_explicit(&map->sequence, memory_order_acquire);
+
+        if (sequence & 1){
+            continue;
+        }
+
+        snowflake_map_entry *entry = find_entry(map->table, key);
+
+        value = entry ? entry->value : NULL;
+
+        atomic_thread_fence(memory_order_acquire);
+    } while ((sequence & 1) || sequence != atomic_load_explicit(&map->sequence, memory_order_relaxed));
+
+    return value;
+}
+
+bool snowflake_map_set(snowflake_map *map, snowflake key, void *value){
+    if (!map){
+        DLOG(
+            "[%s] snowflake_map_set() - map is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!key){
+        DLOG(
+            "[%s] snowflake_map_set() - key is 0\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    snowflake_map_entry *entry = find_entry(map->table, key);
+
+    if (entry){
+        void *prev = entry->value;
+
+        begin_write(map);
+
+        entry->value = value;
+
+        end_write(map);
+
+        if (prev != value && map->value_free){
+            map->value_free(prev);
+        }
+
+        return true;
+    }
+
+    begin_write(map);
+
+    if ((map->length + 1) * 10 >= map->table->capacity * 7){
+        if (!resize_map(map, map->table->capacity * 2)){
+            DLOG(
+                "[%s] snowflake_map_set() - resize_map call failed\n",
+                __FILE__
+            );
+
+            end_write(map);
+
+            return false;
+        }
+    }
+
+    snowflake_map_table *table = map->table;
+    size_t mask = table->capacity - 1;
+    size_t slot = hash_snowflake(key) & mask;
+
+    while (table->entries[slot].key){
+        slot = (slot + 1) & mask;
+    }
+
+    table->entries[slot].value = value;
+    table->entries[slot].key = key;
+
+    ++map->length;
+
+    end_write(map);
+
+    return true;
+}
+
+void *snowflake_map_pop(snowflake_map *map, snowflake key){
+    if (!map || !key){
+        return NULL;
+    }
+
+    snowflake_map_entry *entry = find_entry(map->table, key);
+
+    if (!entry){
+        return NULL;
+    }
+
+    void *value = entry->value;
+
+    begin_write(map);
+
+    remove_entry(map, entry - map->table->entries);
+
+    end_write(map);
+
+    return value;
+}
+
+bool snowflake_map_remove(snowflake_map *map, snowflake key){
+    if (!map || !key){
+        return false;
+    }
+
+    snowflake_map_entry *entry = find_entry(map->table, key);
+
+    if (!entry){
+        return false;
+    }
+
+    void *value = entry->value;
+
+    begin_write(map);
+
+    remove_entry(map, entry - map->table->entries);
+
+    end_write(map);
+
+    /* freed after unlinking so a value_free that defers reclamation is safe */
+    if (map->value_free){
+        map->value_free(value);
+    }
+
+    return true;
+}
+
+size_t snowflake_map_get_length(const snowflake_map *map){
+    return map ? map->length : 0;
+}
+
+/* writer thread only -- the map must not be modified while iterating */
+bool snowflake_map_next(const snowflake_map *map, size_t *index, snowflake *key, void **value){
+    if (!map || !index){
+        return false;
+    }
+
+    snowflake_map_table *table = map->table;
+
+    for (; *index < table->capacity; ++*index){
+        snowflake_map_entry *entry = &table->entries[*index];
+
+        if (!entry->key){
+            continue;
+        }
+
+        if (key){
+            *key = entry->key;
+        }
+
+        if (value){
+            *value = entry->value;
+        }
+
+        ++*index;
+
+        return true;
+    }
+
+    return false;
+}
+
+void snowflake_map_empty(snowflake_map *map){
+    if (!map || !map->table){
+        return;
+    }
+
+    snowflake_map_table *table = map->table;
+
+    for (size_t index = 0; index < table->capacity; ++index){
+        snowflake_map_entry *entry = &table->entries[index];
+        snowflake key = entry->key;
+        void *value = entry->value;
+
+        if (!key){
+            continue;
+        }
+
+        begin_write(map);
+
+        entry->key = 0;
+        entry->value = NULL;
+
+        end_write(map);
+
+        if (map->value_free){
+            map->value_free(value);
+        }
+    }
+
+    map->length = 0;
+}
+
+void snowflake_map_free(snowflake_map *map){
+    if (!map){
+        DLOG(
+            "[%s] snowflake_map_free() - map is NULL\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    snowflake_map_empty(map);
+
+    snowflake_map_table *table = map->table;
+
+    while (table){
+        snowflake_map_table *retired = table->retired;
+
+        free(table);
+
+        table = retired;
+    }
+
+    free(map);
+}
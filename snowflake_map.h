@@ -0,0 +1,54 @@
+#ifndef SNOWFLAKE_MAP_H
+#define SNOWFLAKE_MAP_H
+
+#include "snowflake.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define SNOWFLAKE_MAP_INITIAL_CAPACITY 64
+
+/* key 0 marks an empty slot -- 0 is never a valid snowflake */
+typedef struct snowflake_map_entry {
+    _Atomic snowflake key;
+    void *_Atomic value;
+} snowflake_map_entry;
+
+typedef struct snowflake_map_table {
+    size_t capacity;
+
+    /* tables outgrown by a concurrent map, kept until the map is freed */
+    struct snowflake_map_table *retired;
+
+    snowflake_map_entry entries[];
+} snowflake_map_table;
+
+/*
+ * a single writer may modify the map while other threads call
+ * snowflake_map_get -- lookups retry around the writer's sequence counter
+ * instead of taking a lock
+ */
+typedef struct snowflake_map {
+    snowflake_map_table *_Atomic table;
+    size_t length;
+
+    atomic_size_t sequence;
+    bool concurrent;
+
+    void (*value_free)(void *);
+} snowflake_map;
+
+snowflake_map *snowflake_map_init(void (*)(void *));
+
+void *snowflake_map_get(const snowflake_map *, snowflake);
+bool snowflake_map_set(snowflake_map *, snowflake, void *);
+void *snowflake_map_pop(snowflake_map *, snowflake);
+bool snowflake_map_remove(snowflake_map *, snowflake);
+
+size_t snowflake_map_get_length(const snowflake_map *);
+bool snowflake_map_next(const snowflake_map *, size_t *, snowflake *, void **);
+
+void snowflake_map_empty(snowflake_map *);
+void snowflake_map_free(snowflake_map *);
+
+#endif
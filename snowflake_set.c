@@ -0,0 +1,138 @@
+#include "snowflake_set.h"
+
+#include "log.h"
+
+#include <stdlib.h>
+
+static int compare_snowflakes(const void *a, const void *b){
+    snowflake left = *(const snowflake *)a;
+    snowflake right = *(const snowflake *)b;
+
+    return (left > right) - (left < right);
+}
+
+snowflake_set *snowflake_set_from_json(json_object *array){
+    size_t length = json_object_array_length(array);
+    snowflake_set *set = malloc(sizeof(*set) + length * sizeof(*set->ids));
+
+    if (!set){
+        DLOG(
+            "[%s] snowflake_set_from_json() - set alloc failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    for (size_t index = 0; index < length; ++index){
+        const char *objstr = json_object_get_string(
+            json_object_array_get_idx(array, index)
+        );
+
+        if (!snowflake_from_string(objstr, &set->ids[index])){
+            DLOG(
+                "[%s] snowflake_set_from_json() - snowflake_from_string call failed for %s\n",
+                __FILE__,
+                objstr ? objstr : "(null)"
+            );
+
+            free(set);
+
+            return NULL;
+        }
+    }
+
+    qsort(set->ids, length, sizeof(*set->ids), compare_snowflakes);
+
+    set->length = 0;
+
+    for (size_t index = 0; index < length; ++index){
+        if (!set->length || set->ids[set->length - 1] != set->ids[index]){
+            set->ids[set->length++] = set->ids[index];
+        }
+    }
+
+    return set;
+}
+
+bool snowflake_set_contains(const snowflake_set *set, snowflake id){
+    if (!set){
+        return false;
+    }
+
+    size_t low = 0;
+    size_t high = set->length;
+
+    while (low < high){
+        size_t middle = low + (high - low) / 2;
+
+        if (set->ids[middle] == id){
+            return true;
+        }
+        else if (set->ids[middle] < id){
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return false;
+}
+
+bool snowflake_set_equal(const snowflake_set *a, const snowflake_set *b){
+    size_t length = snowflake_set_get_length(a);
+
+    if (length != snowflake_set_get_length(b)){
+        return false;
+    }
+
+    for (size_t index = 0; index < length; ++index){
+        if (a->ids[index] != b->ids[index]){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* writes up to limit common ids to out (which may be NULL) and returns the full count */
+size_t snowflake_set_intersect(const snowflake_set *a, const snowflake_set *b, snowflake *out, size_t limit){
+    size_t count = 0;
+    size_t left = 0;
+    size_t right = 0;
+    size_t alength = snowflake_set_get_length(a);
+    size_t blength = snowflake_set_get_length(b);
+
+    while (left < alength && right < blength){
+        if (a->ids[left] < b->ids[right]){
+            ++left;
+        }
+        else if (a->ids[left] > b->ids[right]){
+            ++right;
+        }
+        else {
+            if (out && count < limit){
+                out[count] = a->ids[left];
+            }
+
+            ++count;
+            ++left;
+            ++right;
+        }
+    }
+
+    return count;
+}
+
+size_t snowflake_set_get_length(const snowflake_set *set){
+    return set ? set->length : 0;
+}
+
+size_t snowflake_set_get_size(const snowflake_set *set){
+    return set ? sizeof(*set) + set->length * sizeof(*set->ids) : 0;
+}
+
+void snowflake_set_free(snowflake_set *set){
+    free(set);
+}
@@ -0,0 +1,31 @@
+#ifndef SNOWFLAKE_SET_H
+#define SNOWFLAKE_SET_H
+
+#include "snowflake.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <json-c/json.h>
+
+/*
+ * an immutable, ascending and duplicate-free run of ids in one allocation --
+ * membership is a binary search and set operations are a single merge
+ */
+typedef struct snowflake_set {
+    size_t length;
+    snowflake ids[];
+} snowflake_set;
+
+snowflake_set *snowflake_set_from_json(json_object *);
+
+bool snowflake_set_contains(const snowflake_set *, snowflake);
+bool snowflake_set_equal(const snowflake_set *, const snowflake_set *);
+size_t snowflake_set_intersect(const snowflake_set *, const snowflake_set *, snowflake *, size_t);
+
+size_t snowflake_set_get_length(const snowflake_set *);
+size_t snowflake_set_get_size(const snowflake_set *);
+
+void snowflake_set_free(snowflake_set *);
+
+#endif
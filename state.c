@@ -1,5 +1,11 @@
 #include "state.h"
 
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 static const logctx *logger = NULL;
 
 static const char *statuses[] = {
@@ -12,6 +18,275 @@ static const char *statuses[] = {
     NULL
 };
 
+static void free_guild_map(void *entities){
+    snowflake_map_free(entities);
+}
+
+static void free_list(void *ptr){
+    list_free(ptr);
+}
+
+static void put_object(void *object){
+    json_object_put(object);
+}
+
+/*
+ * map and list entries are unlinked from the cache right away so the writer
+ * never evicts them twice -- the memory itself waits out the grace period
+ */
+static void retire_user(void *ptr){
+    discord_user *user = ptr;
+
+    cache_unlink(&user->state->cache, &user->cache);
+
+    state_retire(user->state, user, user_free);
+}
+
+static void retire_emoji(void *ptr){
+    discord_emoji *emoji = ptr;
+
+    cache_unlink(&emoji->state->cache, &emoji->cache);
+
+    state_retire(emoji->state, emoji, emoji_free);
+}
+
+static void retire_guild(void *ptr){
+    discord_guild *guild = ptr;
+
+    state_retire(guild->state, guild, guild_free);
+}
+
+static void retire_member(void *ptr){
+    discord_member *member = ptr;
+
+    cache_unlink(&member->state->cache, &member->cache);
+
+    state_retire(member->state, member, member_free);
+}
+
+static snowflake get_author_id(const discord_message *message){
+    return message->author ? message->author->id : 0;
+}
+
+static void index_message(discord_state *state, discord_message *message){
+    if (message->channel_id && !snowflake_index_insert(state->channel_messages, message->channel_id, message->id, message)){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] index_message() - snowflake_index_insert call failed for channel of %" PRIu64 "\n",
+            __FILE__,
+            message->id
+        );
+    }
+
+    if (state->search && !search_add(state->search, message->id, message->content)){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] index_message() - search_add call failed for %" PRIu64 "\n",
+            __FILE__,
+            message->id
+        );
+    }
+
+    snowflake authorid = get_author_id(message);
+
+    if (authorid && !snowflake_index_insert(state->author_messages, authorid, message->id, message)){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] index_message() - snowflake_index_insert call failed for author of %" PRIu64 "\n",
+            __FILE__,
+            message->id
+        );
+    }
+}
+
+static void unindex_message(discord_state *state, snowflake channelid, snowflake authorid, snowflake id){
+    snowflake_index_remove(state->channel_messages, channelid, id);
+    snowflake_index_remove(state->author_messages, authorid, id);
+}
+
+static void retire_message(void *ptr){
+    discord_message *message = ptr;
+
+    /* the indexes are about to be freed whole */
+    if (!message->state->closing){
+        unindex_message(message->state, message->channel_id, get_author_id(message), message->id);
+
+        search_remove(message->state->search, message->id, message->content);
+    }
+
+    snowflake_map_pop(message->state->message_ids, message->id);
+    cache_unlink(&message->state->cache, &message->cache);
+
+    state_retire(message->state, message, message_free);
+}
+
+static void retire_guild_map(discord_state *state, snowflake_map *guilds, snowflake guildid){
+    snowflake_map *entities = snowflake_map_pop(guilds, guildid);
+
+    if (!entities){
+        return;
+    }
+
+    /* the entities retire themselves -- only the emptied map is left to wait */
+    snowflake_map_empty(entities);
+
+    state_retire(state, entities, free_guild_map);
+}
+
+static void retire_role(void *ptr){
+    discord_role *role = ptr;
+
+    state_retire(role->state, role, role_free);
+}
+
+static void retire_channel(void *ptr){
+    discord_channel *channel = ptr;
+
+    state_retire(channel->state, channel, channel_free);
+}
+
+/* every memoized permission for the guild's members goes stale at once */
+static void invalidate_permissions(discord_state *state, snowflake guildid){
+    discord_guild *guild = snowflake_map_get(state->guilds, guildid);
+
+    if (guild){
+        guild->permission_generation = ++state->permission_generation;
+    }
+}
+
+static void remove_guild_channels(discord_state *state, snowflake guildid){
+    size_t length = snowflake_map_get_length(state->channels);
+
+    if (!length){
+        return;
+    }
+
+    /* the map can't be modified mid-iteration -- collect first */
+    snowflake *ids = malloc(length * sizeof(*ids));
+
+    if (!ids){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] remove_guild_channels() - ids alloc failed\n",
+            __FILE__
+        );
+
+        return;
+    }
+
+    size_t count = 0;
+    size_t index = 0;
+    snowflake id = 0;
+    void *value = NULL;
+
+    while (snowflake_map_next(state->channels, &index, &id, &value)){
+        const discord_channel *channel = value;
+
+        if (channel->guild_id == guildid){
+            ids[count++] = id;
+        }
+    }
+
+    for (size_t curr = 0; curr < count; ++curr){
+        snowflake_map_remove(state->channels, ids[curr]);
+    }
+
+    free(ids);
+}
+
+static void retire_string(void *context, char *string){
+    state_retire(context, string, free);
+}
+
+static void retire_bucket(void *context, void *bucket, void (*release)(void *)){
+    state_retire(context, bucket, release);
+}
+
+/* reader threads can't relink the lru list -- they leave a mark for state_trim */
+static void touch_node(discord_state *state, discord_cache_node *node){
+    if (state->epoch){
+        atomic_store_explicit(&node->accessed, true, memory_order_relaxed);
+    }
+    else {
+        cache_touch(&state->cache, node);
+    }
+}
+
+static void notify_diff(discord_state *state, discord_state_entity entity, const void *object, int changes){
+    if (!changes || !state->on_diff){
+        return;
+    }
+
+    state->on_diff(state->event_context, entity, object, changes);
+}
+
+static bool get_entity_key(discord_snapshot_kind kind, const void *entity, snowflake *guildid, snowflake *id){
+    const discord_member *member = entity;
+
+    *guildid = 0;
+
+    switch (kind){
+    case SNAPSHOT_USERS:
+        *id = ((const discord_user *)entity)->id;
+
+        return true;
+    case SNAPSHOT_GUILDS:
+        *id = ((const discord_guild *)entity)->id;
+
+        return true;
+    case SNAPSHOT_MEMBERS:
+        *guildid = member->guild_id;
+        *id = member->user ? member->user->id : 0;
+
+        return *id;
+    default:
+        return false;
+    }
+}
+
+/* hands a mutation to whichever mirrors are enabled -- the journal and the shared segment */
+static void publish_entity(discord_state *state, discord_journal_op op, discord_snapshot_kind kind, const void *entity){
+    if (state->journal && !journal_write_entity(state->journal, op, kind, entity)){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] publish_entity() - journal_write_entity call failed for kind %d\n",
+            __FILE__,
+            kind
+        );
+    }
+
+    snowflake guildid = 0;
+    snowflake id = 0;
+
+    if (state->shared && get_entity_key(kind, entity, &guildid, &id)){
+        shared_cache_put(state->shared, kind, guildid, id, entity);
+    }
+}
+
+static void publish_delete(discord_state *state, discord_snapshot_kind kind, snowflake guildid, snowflake id){
+    if (state->journal && !journal_write_delete(state->journal, kind, guildid, id)){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] publish_delete() - journal_write_delete call failed for %" PRIu64 "\n",
+            __FILE__,
+            id
+        );
+    }
+
+    if (kind == SNAPSHOT_GUILDS){
+        shared_cache_remove_guild(state->shared, id);
+    }
+    else {
+        shared_cache_remove(state->shared, kind, guildid, id);
+    }
+}
+
 discord_state *state_init(const char *token, const discord_state_options *opts){
     if (!token){
         log_write(
@@ -44,6 +319,33 @@ discord_state *state_init(const char *token, const discord_state_options *opts){
         state->intent = opts->intent;
 
         state->max_messages = opts->max_messages;
+
+        state->compact = opts->compact;
+
+        state->on_diff = opts->on_diff;
+
+        state->cache.budget = opts->cache_budget;
+        state->cache.ttl = opts->cache_ttl;
+
+        state->revalidate_after = opts->revalidate_after;
+        state->on_fetch = opts->on_fetch;
+    }
+
+    if (opts && opts->concurrent_reads){
+        state->epoch = epoch_init();
+
+        if (!state->epoch){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_init() - epoch initialization failed\n",
+                __FILE__
+            );
+
+            state_free(state);
+
+            return NULL;
+        }
     }
 
     state->user_pointer = NULL;
@@ -78,7 +380,17 @@ discord_state *state_init(const char *token, const discord_state_options *opts){
         return NULL;
     }
 
-    state->http = http_init(state->token, NULL);
+    discord_http_options hopts = {0};
+    hopts.log = state->log;
+
+    if (opts){
+        hopts.global_limiter = opts->global_limiter;
+        hopts.global_rate = opts->global_rate;
+        hopts.on_breaker = opts->on_breaker;
+        hopts.http2 = opts->http2;
+    }
+
+    state->http = http_init(state->token, &hopts);
 
     if (!state->http){
         log_write(
@@ -108,13 +420,13 @@ discord_state *state_init(const char *token, const discord_state_options *opts){
         return NULL;
     }
 
-    state->emojis = map_init();
+    state->message_ids = snowflake_map_init(NULL);
 
-    if (!state->emojis){
+    if (!state->message_ids){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] state_init() - emojis map initialization failed\n",
+            "[%s] state_init() - message ids map initialization failed\n",
             __FILE__
         );
 
@@ -123,13 +435,13 @@ discord_state *state_init(const char *token, const discord_state_options *opts){
         return NULL;
     }
 
-    state->users = map_init();
+    state->channel_messages = snowflake_index_init();
 
-    if (!state->users){
+    if (!state->channel_messages){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] state_init() - users map initialization failed\n",
+            "[%s] state_init() - channel messages index initialization failed\n",
             __FILE__
         );
 
@@ -138,101 +450,390 @@ discord_state *state_init(const char *token, const discord_state_options *opts){
         return NULL;
     }
 
-    return state;
-}
+    state->author_messages = snowflake_index_init();
 
-json_object *state_get_presence(discord_state *state){
-    if (!state){
+    if (!state->author_messages){
         log_write(
             logger,
-            LOG_WARNING,
-            "[%s] state_get_presence() - state is NULL\n",
+            LOG_ERROR,
+            "[%s] state_init() - author messages index initialization failed\n",
             __FILE__
         );
 
+        state_free(state);
+
         return NULL;
     }
 
-    return state->presence;
-}
+    if (opts && opts->read_through){
+        state->fetching = snowflake_map_init(NULL);
 
-const char *state_get_presence_string(discord_state *state){
-    if (!state){
-        log_write(
-            logger,
-            LOG_WARNING,
-            "[%s] state_get_presence_string() - state is NULL\n",
-            __FILE__
-        );
+        if (!state->fetching){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_init() - fetching map initialization failed\n",
+                __FILE__
+            );
 
-        return NULL;
-    }
+            state_free(state);
 
-    return state->presence ? json_object_to_json_string(state->presence) : "null";
-}
+            return NULL;
+        }
 
-bool state_set_presence(discord_state *state, const discord_presence *presence){
-    if (!state){
-        log_write(
-            logger,
-            LOG_WARNING,
-            "[%s] state_set_presence() - state is NULL\n",
-            __FILE__
-        );
+        /*
+         * the worker's client spends the same global and invalid request budget
+         * as ours -- breaker transitions it causes are reported by ours, on this thread
+         */
+        discord_http_options fopts = {0};
+        fopts.log = state->log;
+        fopts.global = state->http->global;
+        fopts.breaker = state->http->breaker;
+        fopts.http2 = state->http->http2;
 
-        return false;
-    }
-    else if (!presence){
-        json_object *obj = json_object_new_object();
+        state->fetcher = fetch_init(state->token, &fopts);
 
-        if (!obj){
+        if (!state->fetcher){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] state_set_presence() - presence object initialization failed\n",
+                "[%s] state_init() - fetcher initialization failed\n",
                 __FILE__
             );
 
-            return false;
+            state_free(state);
+
+            return NULL;
         }
+    }
 
-        json_object_put(state->presence);
+    if (opts && opts->presences){
+        state->presences = presence_store_init(opts->presence_activities);
 
-        state->presence = obj;
+        if (!state->presences){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_init() - presence store initialization failed\n",
+                __FILE__
+            );
 
-        return true;
+            state_free(state);
+
+            return NULL;
+        }
     }
-    else if (presence->raw_object){
-        if (!json_merge_objects(presence->raw_object, state->presence)){
+
+    if (opts && opts->on_journal){
+        state->journal = journal_init();
+
+        if (!state->journal){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] state_set_presence() - json_merge_objects call failed\n",
+                "[%s] state_init() - journal initialization failed\n",
                 __FILE__
             );
 
-            return false;
+            state_free(state);
+
+            return NULL;
         }
 
-        return true;
+        state->on_journal = opts->on_journal;
     }
 
-    bool success = state_set_presence_since(state, presence->since);
+    if (opts && opts->shared_cache){
+        state->shared = shared_cache_create(opts->shared_cache, opts->shared_capacity);
 
-    if (!success){
-        return false;
-    }
+        if (!state->shared){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_init() - shared cache initialization failed for %s\n",
+                __FILE__,
+                opts->shared_cache
+            );
 
-    success = state_set_presence_activities(state, presence->activities);
+            state_free(state);
 
-    if (!success){
-        return false;
+            return NULL;
+        }
     }
 
-    success = state_set_presence_status(state, presence->status);
+    if (opts && opts->search){
+        state->search = search_init();
 
-    if (!success){
-        return false;
+        if (!state->search){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_init() - search index initialization failed\n",
+                __FILE__
+            );
+
+            state_free(state);
+
+            return NULL;
+        }
+    }
+
+    state->emojis = snowflake_map_init(retire_emoji);
+
+    if (!state->emojis){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_init() - emojis map initialization failed\n",
+            __FILE__
+        );
+
+        state_free(state);
+
+        return NULL;
+    }
+
+    state->guilds = snowflake_map_init(retire_guild);
+
+    if (!state->guilds){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_init() - guilds map initialization failed\n",
+            __FILE__
+        );
+
+        state_free(state);
+
+        return NULL;
+    }
+
+    state->members = snowflake_map_init(free_guild_map);
+
+    if (!state->members){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_init() - members map initialization failed\n",
+            __FILE__
+        );
+
+        state_free(state);
+
+        return NULL;
+    }
+
+    state->users = snowflake_map_init(retire_user);
+
+    if (!state->users){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_init() - users map initialization failed\n",
+            __FILE__
+        );
+
+        state_free(state);
+
+        return NULL;
+    }
+
+    state->roles = snowflake_map_init(free_guild_map);
+
+    if (!state->roles){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_init() - roles map initialization failed\n",
+            __FILE__
+        );
+
+        state_free(state);
+
+        return NULL;
+    }
+
+    state->hierarchies = snowflake_map_init(role_hierarchy_free);
+
+    if (!state->hierarchies){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_init() - hierarchies map initialization failed\n",
+            __FILE__
+        );
+
+        state_free(state);
+
+        return NULL;
+    }
+
+    state->channels = snowflake_map_init(retire_channel);
+
+    if (!state->channels){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_init() - channels map initialization failed\n",
+            __FILE__
+        );
+
+        state_free(state);
+
+        return NULL;
+    }
+
+    state->permissions = permission_memo_init();
+
+    if (!state->permissions){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_init() - permission memo initialization failed\n",
+            __FILE__
+        );
+
+        state_free(state);
+
+        return NULL;
+    }
+
+    if (opts && opts->intern){
+        state->strings = intern_init();
+
+        if (!state->strings){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_init() - string intern table initialization failed\n",
+                __FILE__
+            );
+
+            state_free(state);
+
+            return NULL;
+        }
+
+        if (state->epoch){
+            state->strings->string_free = retire_string;
+            state->strings->context = state;
+        }
+    }
+
+    if (state->epoch){
+        state->message_ids->concurrent = true;
+        state->emojis->concurrent = true;
+        state->guilds->concurrent = true;
+        state->members->concurrent = true;
+        state->users->concurrent = true;
+        state->roles->concurrent = true;
+        state->channels->concurrent = true;
+
+        /* message getters walk index buckets, so those are swapped rather than edited */
+        state->channel_messages->buckets->concurrent = true;
+        state->channel_messages->retire = retire_bucket;
+        state->channel_messages->context = state;
+
+        state->author_messages->buckets->concurrent = true;
+        state->author_messages->retire = retire_bucket;
+        state->author_messages->context = state;
+    }
+
+    return state;
+}
+
+json_object *state_get_presence(discord_state *state){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_presence() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    return state->presence;
+}
+
+const char *state_get_presence_string(discord_state *state){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_presence_string() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    return state->presence ? json_object_to_json_string(state->presence) : "null";
+}
+
+bool state_set_presence(discord_state *state, const discord_presence *presence){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_presence() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!presence){
+        json_object *obj = json_object_new_object();
+
+        if (!obj){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_presence() - presence object initialization failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        json_object_put(state->presence);
+
+        state->presence = obj;
+
+        return true;
+    }
+    else if (presence->raw_object){
+        if (!json_merge_objects(presence->raw_object, state->presence)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_presence() - json_merge_objects call failed\n",
+                __FILE__
+            );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool success = state_set_presence_since(state, presence->since);
+
+    if (!success){
+        return false;
+    }
+
+    success = state_set_presence_activities(state, presence->activities);
+
+    if (!success){
+        return false;
+    }
+
+    success = state_set_presence_status(state, presence->status);
+
+    if (!success){
+        return false;
     }
 
     success = state_set_presence_afk(state, presence->afk);
@@ -447,299 +1048,2698 @@ bool state_set_presence_afk(discord_state *state, bool afk){
     return true;
 }
 
-const discord_message *state_set_message(discord_state *state, json_object *data, bool update){
+bool state_intern_string(discord_state *state, const char **field, const char *value){
     if (!state){
         log_write(
             logger,
             LOG_WARNING,
-            "[%s] state_set_message() - state is NULL\n",
+            "[%s] state_intern_string() - state is NULL\n",
             __FILE__
         );
 
-        return NULL;
+        return false;
     }
-    else if (!data){
+    else if (!field){
         log_write(
             logger,
             LOG_WARNING,
-            "[%s] state_set_message() - data is NULL\n",
+            "[%s] state_intern_string() - field is NULL\n",
             __FILE__
         );
 
-        return NULL;
+        return false;
     }
 
-    const char *idstr = json_object_get_string(
-        json_object_object_get(data, "id")
-    );
-
-    if (!idstr){
-        log_write(
-            logger,
-            LOG_WARNING,
-            "[%s] state_set_message() - failed to get id from data: %s\n",
-            __FILE__,
-            json_object_to_json_string(data)
-        );
+    if (!state->strings){
+        *field = value;
 
-        return 0;
+        return true;
     }
 
-    snowflake id = 0;
-    bool success = snowflake_from_string(idstr, &id);
+    const char *interned = intern_acquire(state->strings, value);
 
-    if (!success){
+    if (value && !interned){
         log_write(
             logger,
-            LOG_WARNING,
-            "[%s] state_set_message() - snowflake_from_string call failed for id: %s\n",
-            __FILE__,
-            idstr
+            LOG_ERROR,
+            "[%s] state_intern_string() - intern_acquire call failed\n",
+            __FILE__
         );
 
-        return 0;
+        return false;
     }
 
-    discord_message *cached = NULL;
+    intern_release(state->strings, *field);
 
-    size_t messageslen = list_get_length(state->messages);
+    *field = interned;
+
+    return true;
+}
+
+void state_release_string(discord_state *state, const char *value){
+    if (!state || !state->strings){
+        return;
+    }
+
+    intern_release(state->strings, value);
+}
+
+void state_retire(discord_state *state, void *ptr, void (*release)(void *)){
+    if (!ptr || !release){
+        return;
+    }
+
+    if (!state || !state->epoch || state->closing){
+        release(ptr);
+
+        return;
+    }
+
+    if (!epoch_retire(state->epoch, ptr, release)){
+        /* leaking is the only safe option while readers may hold it */
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_retire() - epoch_retire call failed -- leaking %p\n",
+            __FILE__,
+            ptr
+        );
+    }
+}
+
+void state_retire_list(discord_state *state, list *retired){
+    state_retire(state, retired, free_list);
+}
+
+void state_retire_object(discord_state *state, json_object *object){
+    state_retire(state, object, put_object);
+}
+
+bool state_merge_object(discord_state *state, json_object **raw, json_object *data){
+    if (!raw){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_merge_object() - raw is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_merge_object() - data is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!*raw){
+        /* compacted -- construct from the update and keep the rest in the arena */
+        *raw = json_object_get(data);
+
+        return true;
+    }
+    else if (!state || !state->epoch){
+        return json_merge_objects(data, *raw);
+    }
+
+    /*
+     * entity strings point into the DOM, so readers may be walking the old
+     * one -- merge into a copy and let the constructor repoint every field
+     */
+    json_object *copy = NULL;
+
+    if (json_object_deep_copy(*raw, &copy, NULL)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_merge_object() - json_object_deep_copy call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!json_merge_objects(data, copy)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_merge_object() - json_merge_objects call failed\n",
+            __FILE__
+        );
+
+        json_object_put(copy);
+
+        return false;
+    }
+
+    state_retire_object(state, *raw);
+
+    *raw = copy;
+
+    return true;
+}
+
+size_t state_reclaim(discord_state *state){
+    if (!state || !state->epoch){
+        return 0;
+    }
+
+    return epoch_collect(state->epoch);
+}
+
+int state_reader_register(discord_state *state){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_reader_register() - state is NULL\n",
+            __FILE__
+        );
+
+        return -1;
+    }
+    else if (!state->epoch){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_reader_register() - concurrent reads are disabled\n",
+            __FILE__
+        );
+
+        return -1;
+    }
+
+    return epoch_register(state->epoch);
+}
+
+void state_reader_unregister(discord_state *state, int reader){
+    if (!state){
+        return;
+    }
+
+    epoch_unregister(state->epoch, reader);
+}
+
+void state_read_begin(discord_state *state, int reader){
+    if (!state){
+        return;
+    }
+
+    epoch_enter(state->epoch, reader);
+}
+
+void state_read_end(discord_state *state, int reader){
+    if (!state){
+        return;
+    }
+
+    epoch_exit(state->epoch, reader);
+}
+
+static discord_message *find_message(const discord_state *state, snowflake id, size_t *position){
+    discord_message *message = snowflake_map_get(state->message_ids, id);
+
+    if (!message || !position){
+        return message;
+    }
+
+    /* only removal needs the list position */
+    size_t messageslen = list_get_length(state->messages);
 
     for (size_t index = 0; index < messageslen; ++index){
-        discord_message *tmp = list_get_generic(state->messages, index);
+        if (list_get_generic(state->messages, index) == message){
+            *position = index;
+
+            return message;
+        }
+    }
+
+    return NULL;
+}
+
+static void hold_node(discord_cache_node *curr, discord_cache_node *next){
+    if (next){
+        ++next->refs;
+    }
+
+    if (curr && curr->refs){
+        --curr->refs;
+    }
+}
+
+bool state_hold_user(discord_state *state, const discord_user **field, const discord_user *user){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_hold_user() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!field){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_hold_user() - field is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    /* everything is being released -- the held objects may already be gone */
+    if (!state->closing){
+        discord_user *curr = *field ? snowflake_map_get(state->users, (*field)->id) : NULL;
+        discord_user *next = user ? snowflake_map_get(state->users, user->id) : NULL;
+
+        hold_node(curr ? &curr->cache : NULL, next ? &next->cache : NULL);
+    }
+
+    *field = user;
+
+    return true;
+}
+
+bool state_hold_emoji(discord_state *state, const discord_emoji **field, const discord_emoji *emoji){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_hold_emoji() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!field){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_hold_emoji() - field is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!state->closing){
+        discord_emoji *curr = *field ? snowflake_map_get(state->emojis, (*field)->id) : NULL;
+        discord_emoji *next = emoji ? snowflake_map_get(state->emojis, emoji->id) : NULL;
+
+        hold_node(curr ? &curr->cache : NULL, next ? &next->cache : NULL);
+    }
+
+    *field = emoji;
+
+    return true;
+}
+
+bool state_hold_message(discord_state *state, const discord_message **field, const discord_message *message){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_hold_message() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!field){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_hold_message() - field is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!state->closing){
+        discord_message *curr = *field ? find_message(state, (*field)->id, NULL) : NULL;
+        discord_message *next = message ? find_message(state, message->id, NULL) : NULL;
+
+        hold_node(curr ? &curr->cache : NULL, next ? &next->cache : NULL);
+    }
+
+    *field = message;
+
+    return true;
+}
+
+/* leaves the journal and shared cache alone -- callers publish real deletes */
+static bool remove_member(discord_state *state, snowflake guildid, snowflake userid){
+    snowflake_map *members = snowflake_map_get(state->members, guildid);
+
+    if (!snowflake_map_remove(members, userid)){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] remove_member() - member %" PRIu64 " not found in guild %" PRIu64 "\n",
+            __FILE__,
+            userid,
+            guildid
+        );
+
+        return false;
+    }
+
+    invalidate_permissions(state, guildid);
+
+    if (!snowflake_map_get_length(members)){
+        retire_guild_map(state, state->members, guildid);
+    }
+
+    return true;
+}
+
+static bool evict_node(discord_state *state, discord_cache_node *node){
+    size_t index = 0;
+
+    switch (node->kind){
+    case CACHE_USER:
+        shared_cache_remove(state->shared, SNAPSHOT_USERS, 0, node->key);
+
+        return snowflake_map_remove(state->users, node->key);
+    case CACHE_EMOJI:
+        return snowflake_map_remove(state->emojis, node->key);
+    case CACHE_MEMBER:
+        /* an evicted member still exists -- it just isn't cached here */
+        return remove_member(state, node->parent, node->key);
+    case CACHE_MESSAGE:
+        if (!find_message(state, node->key, &index)){
+            return false;
+        }
+
+        list_remove(state->messages, index);
+
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t state_trim(discord_state *state){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_trim() - state is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+
+    size_t evicted = 0;
+    time_t now = time(NULL);
+
+    /* bounded so busy readers can't keep the writer here forever */
+    size_t chances = 0;
+    size_t maxchances = state->epoch ? state->cache.counts[CACHE_USER] + state->cache.counts[CACHE_EMOJI] + state->cache.counts[CACHE_MEMBER] + state->cache.counts[CACHE_MESSAGE] : 0;
+
+    discord_cache_node *node = NULL;
+    discord_cache_node *resume = NULL;
+
+    while ((node = cache_get_victim(&state->cache, resume, now))){
+        /* everything past node was held or fresh -- evicting or moving node leaves its prev in place */
+        resume = node->prev;
+
+        if (chances < maxchances && atomic_exchange_explicit(&node->accessed, false, memory_order_relaxed)){
+            /* read since the last trim -- move it up as if it were touched */
+            cache_touch(&state->cache, node);
+
+            ++chances;
+
+            continue;
+        }
+
+        if (!evict_node(state, node)){
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] state_trim() - cached entity %" PRIu64 " missing from its table\n",
+                __FILE__,
+                node->key
+            );
+
+            cache_unlink(&state->cache, node);
+
+            continue;
+        }
+
+        ++evicted;
+    }
+
+    state->cache.evictions += evicted;
+
+    if (evicted){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_trim() - evicted %zu entities -- %zu bytes cached\n",
+            __FILE__,
+            evicted,
+            state->cache.used
+        );
+    }
+
+    return evicted;
+}
+
+bool state_get_cache_usage(const discord_state *state, discord_cache_usage *usage){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_cache_usage() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!usage){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_cache_usage() - usage is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    usage->used = state->cache.used;
+    usage->budget = state->cache.budget;
+
+    memcpy(usage->bytes, state->cache.bytes, sizeof(usage->bytes));
+    memcpy(usage->counts, state->cache.counts, sizeof(usage->counts));
+
+    usage->strings = state->strings ? state->strings->bytes : 0;
+    usage->compact_saved = state->compact_saved;
+    usage->evictions = state->cache.evictions;
+
+    return true;
+}
+
+static bool snapshot_section(discord_snapshot_buffer *buffer, discord_snapshot_kind kind, const snowflake_map *entities){
+    if (!snapshot_write_u8(buffer, kind) || !snapshot_write_u32(buffer, snowflake_map_get_length(entities))){
+        return false;
+    }
+
+    size_t index = 0;
+    void *entity = NULL;
+
+    while (snowflake_map_next(entities, &index, NULL, &entity)){
+        if (!snapshot_write_entity(buffer, kind, entity)){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* for maps of guild id -> entity id -> entity, written as one flat section */
+static bool snapshot_guild_section(discord_snapshot_buffer *buffer, discord_snapshot_kind kind, const snowflake_map *guilds){
+    size_t count = 0;
+    size_t index = 0;
+    void *entities = NULL;
+
+    while (snowflake_map_next(guilds, &index, NULL, &entities)){
+        count += snowflake_map_get_length(entities);
+    }
+
+    if (!snapshot_write_u8(buffer, kind) || !snapshot_write_u32(buffer, count)){
+        return false;
+    }
+
+    index = 0;
+
+    while (snowflake_map_next(guilds, &index, NULL, &entities)){
+        size_t entityindex = 0;
+        void *entity = NULL;
+
+        while (snowflake_map_next(entities, &entityindex, NULL, &entity)){
+            if (!snapshot_write_entity(buffer, kind, entity)){
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool state_snapshot(discord_state *state, const char *path, const char *sessionid, int sequence){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_snapshot() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!path){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_snapshot() - path is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    discord_snapshot_buffer buffer = {0};
+
+    /*
+     * users first -- the other sections refer to them by id. roles and
+     * channels are only ever sent in GUILD_CREATE, which a RESUME doesn't
+     * replay, so they have to come back from here
+     */
+    bool success = snapshot_write_u32(&buffer, DISCORD_SNAPSHOT_MAGIC) &&
+                   snapshot_write_u32(&buffer, DISCORD_SNAPSHOT_VERSION) &&
+                   snapshot_write_string(&buffer, sessionid) &&
+                   snapshot_write_u32(&buffer, (uint32_t)sequence) &&
+                   snapshot_section(&buffer, SNAPSHOT_USERS, state->users) &&
+                   snapshot_section(&buffer, SNAPSHOT_GUILDS, state->guilds) &&
+                   snapshot_section(&buffer, SNAPSHOT_EMOJIS, state->emojis) &&
+                   snapshot_guild_section(&buffer, SNAPSHOT_MEMBERS, state->members) &&
+                   snapshot_guild_section(&buffer, SNAPSHOT_ROLES, state->roles) &&
+                   snapshot_section(&buffer, SNAPSHOT_CHANNELS, state->channels) &&
+                   snapshot_write_u8(&buffer, SNAPSHOT_END);
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_snapshot() - failed to encode cache\n",
+            __FILE__
+        );
+
+        snapshot_buffer_free(&buffer);
+
+        return false;
+    }
+
+    char *tmppath = string_create("%s.tmp", path);
+
+    if (!tmppath){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_snapshot() - string_create call failed for temporary path\n",
+            __FILE__
+        );
+
+        snapshot_buffer_free(&buffer);
+
+        return false;
+    }
+
+    /* written beside the target and renamed so a crash never leaves a torn snapshot */
+    int fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+    if (fd == -1){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_snapshot() - failed to open %s\n",
+            __FILE__,
+            tmppath
+        );
+
+        free(tmppath);
+        snapshot_buffer_free(&buffer);
+
+        return false;
+    }
+
+    size_t written = 0;
+
+    while (written < buffer.size){
+        ssize_t ret = write(fd, buffer.data + written, buffer.size - written);
+
+        if (ret == -1){
+            break;
+        }
+
+        written += ret;
+    }
+
+    success = written == buffer.size;
+    success = !fsync(fd) && success;
+    success = !close(fd) && success;
+
+    if (success && rename(tmppath, path)){
+        success = false;
+    }
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_snapshot() - failed to write %s\n",
+            __FILE__,
+            path
+        );
+
+        remove(tmppath);
+    }
+    else {
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_snapshot() - wrote %zu byte snapshot to %s\n",
+            __FILE__,
+            buffer.size,
+            path
+        );
+    }
+
+    free(tmppath);
+    snapshot_buffer_free(&buffer);
+
+    return success;
+}
+
+static bool restore_entity(discord_state *state, discord_snapshot_kind kind, json_object *data){
+    snowflake guildid = 0;
+    json_object *guildobj = json_object_object_get(data, "guild_id");
+
+    switch (kind){
+    case SNAPSHOT_USERS:
+        return state_set_user(state, data);
+    case SNAPSHOT_GUILDS:
+        return state_set_guild(state, data);
+    case SNAPSHOT_EMOJIS:
+        return state_set_emoji(state, data);
+    case SNAPSHOT_MEMBERS:
+        if (!snowflake_from_string(json_object_get_string(guildobj), &guildid)){
+            return false;
+        }
+
+        return state_set_member(state, guildid, data);
+    case SNAPSHOT_ROLES:
+        if (!snowflake_from_string(json_object_get_string(guildobj), &guildid)){
+            return false;
+        }
+
+        return state_set_role(state, guildid, data);
+    case SNAPSHOT_CHANNELS:
+        /* dm channels have no guild */
+        if (guildobj && !snowflake_from_string(json_object_get_string(guildobj), &guildid)){
+            return false;
+        }
+
+        return state_set_channel(state, guildid, data);
+    default:
+        return false;
+    }
+}
+
+static bool restore_sections(discord_state *state, discord_snapshot_reader *reader){
+    uint8_t kind = SNAPSHOT_END;
+
+    while (snapshot_read_u8(reader, &kind)){
+        if (kind == SNAPSHOT_END){
+            return true;
+        }
+
+        uint32_t count = 0;
+
+        if (!snapshot_read_u32(reader, &count)){
+            return false;
+        }
+
+        for (uint32_t index = 0; index < count; ++index){
+            json_object *data = snapshot_read_entity(reader, kind);
+
+            if (!data){
+                return false;
+            }
+
+            bool success = restore_entity(state, kind, data);
+
+            json_object_put(data);
+
+            if (!success){
+                log_write(
+                    logger,
+                    LOG_ERROR,
+                    "[%s] restore_sections() - failed to restore entity of kind %d\n",
+                    __FILE__,
+                    kind
+                );
+
+                return false;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool state_restore(discord_state *state, const char *path, char *sessionid, size_t sessionsize, int *sequence){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_restore() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!path){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_restore() - path is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_restore() - failed to open %s\n",
+            __FILE__,
+            path
+        );
+
+        return false;
+    }
+
+    struct stat st = {0};
+
+    if (fstat(fd, &st) || !st.st_size){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_restore() - %s is empty or unreadable\n",
+            __FILE__,
+            path
+        );
+
+        close(fd);
+
+        return false;
+    }
+
+    void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (mapped == MAP_FAILED){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_restore() - mmap call failed for %s\n",
+            __FILE__,
+            path
+        );
+
+        return false;
+    }
+
+    discord_snapshot_reader reader = {0};
+    reader.data = mapped;
+    reader.size = st.st_size;
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+
+    bool success = snapshot_read_u32(&reader, &magic) && snapshot_read_u32(&reader, &version);
+
+    if (!success || magic != DISCORD_SNAPSHOT_MAGIC || version != DISCORD_SNAPSHOT_VERSION){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_restore() - %s is not a version %d snapshot\n",
+            __FILE__,
+            path,
+            DISCORD_SNAPSHOT_VERSION
+        );
+
+        munmap(mapped, st.st_size);
+
+        return false;
+    }
+
+    const char *session = NULL;
+    size_t sessionlen = 0;
+    uint32_t seq = 0;
+
+    success = snapshot_read_string(&reader, &session, &sessionlen) && snapshot_read_u32(&reader, &seq);
+
+    if (success && sessionid && sessionsize){
+        size_t length = session && sessionlen < sessionsize ? sessionlen : 0;
+
+        if (length){
+            memcpy(sessionid, session, length);
+        }
+
+        sessionid[length] = '\0';
+    }
+
+    if (success && sequence){
+        *sequence = (int)seq;
+    }
+
+    success = success && restore_sections(state, &reader);
+
+    munmap(mapped, st.st_size);
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_restore() - failed to restore %s -- cache may be partially filled\n",
+            __FILE__,
+            path
+        );
+
+        return false;
+    }
+
+    log_write(
+        logger,
+        LOG_DEBUG,
+        "[%s] state_restore() - restored %zu users, %zu guilds and %zu emojis from %s\n",
+        __FILE__,
+        snowflake_map_get_length(state->users),
+        snowflake_map_get_length(state->guilds),
+        snowflake_map_get_length(state->emojis),
+        path
+    );
+
+    return true;
+}
+
+size_t state_flush_journal(discord_state *state){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_flush_journal() - state is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+    else if (!state->journal || !state->journal->buffer.size){
+        return 0;
+    }
+
+    size_t size = state->journal->buffer.size;
+
+    state->on_journal(state->event_context, state->journal->buffer.data, size);
+
+    journal_reset(state->journal);
+
+    return size;
+}
+
+static bool apply_delete(discord_state *state, const discord_journal_record *record){
+    switch (record->kind){
+    case SNAPSHOT_GUILDS:
+        return state_remove_guild(state, record->id);
+    case SNAPSHOT_MEMBERS:
+        return state_remove_member(state, record->guild_id, record->id);
+    default:
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] apply_delete() - deletes of kind %d are not replicated\n",
+            __FILE__,
+            record->kind
+        );
+
+        return false;
+    }
+}
+
+/*
+ * replays whole records from data and returns how many bytes were used -- the
+ * caller keeps the rest for when more arrives. sequence is the last record
+ * applied and is advanced as records are replayed
+ */
+size_t state_apply_journal(discord_state *state, const unsigned char *data, size_t size, uint64_t *sequence){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_apply_journal() - state is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+    else if (!data || !sequence){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_apply_journal() - data and sequence are required\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+
+    size_t offset = 0;
+
+    while (offset < size){
+        discord_journal_record record = {0};
+        bool success = true;
+        size_t length = journal_read_record(data + offset, size - offset, &record, &success);
+
+        if (!success){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_apply_journal() - malformed record after sequence %" PRIu64 "\n",
+                __FILE__,
+                *sequence
+            );
+
+            break;
+        }
+        else if (!length){
+            break;
+        }
+
+        offset += length;
+
+        /* replayed twice after a reconnect -- already applied */
+        if (record.sequence <= *sequence){
+            journal_record_release(&record);
+
+            continue;
+        }
+        else if (*sequence && record.sequence != *sequence + 1){
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] state_apply_journal() - records %" PRIu64 " to %" PRIu64 " are missing\n",
+                __FILE__,
+                *sequence + 1,
+                record.sequence - 1
+            );
+        }
+
+        if (record.op == JOURNAL_DELETE){
+            apply_delete(state, &record);
+        }
+        else if (!restore_entity(state, record.kind, record.data)){
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] state_apply_journal() - failed to apply record %" PRIu64 "\n",
+                __FILE__,
+                record.sequence
+            );
+        }
+
+        *sequence = record.sequence;
+
+        journal_record_release(&record);
+    }
+
+    return offset;
+}
+
+const discord_message *state_set_message(discord_state *state, json_object *data, bool update){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_message() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_message() - data is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const char *idstr = json_object_get_string(
+        json_object_object_get(data, "id")
+    );
+
+    if (!idstr){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_message() - failed to get id from data: %s\n",
+            __FILE__,
+            json_object_to_json_string(data)
+        );
+
+        return 0;
+    }
+
+    snowflake id = 0;
+    bool success = snowflake_from_string(idstr, &id);
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_message() - snowflake_from_string call failed for id: %s\n",
+            __FILE__,
+            idstr
+        );
+
+        return 0;
+    }
+
+    discord_message *cached = find_message(state, id, NULL);
+    discord_message *message = NULL;
+
+    if (cached){
+        if (update){
+            snowflake channelid = cached->channel_id;
+            snowflake authorid = get_author_id(cached);
+
+            /* the old text may not outlive the merge -- unindex it while it's here */
+            bool reindex = state->search && json_object_object_get(data, "content");
+
+            if (reindex){
+                search_remove(state->search, cached->id, cached->content);
+            }
+
+            if (!message_update(cached, data)){
+                log_write(
+                    logger,
+                    LOG_ERROR,
+                    "[%s] state_set_message() - message_update call failed\n",
+                    __FILE__
+                );
+
+                /* the message stays cached half-updated -- keep the indexes pointing at it */
+                if (channelid != cached->channel_id || authorid != get_author_id(cached)){
+                    unindex_message(state, channelid, authorid, cached->id);
+                    index_message(state, cached);
+                }
+                else if (reindex && !search_add(state->search, cached->id, cached->content)){
+                    log_write(
+                        logger,
+                        LOG_WARNING,
+                        "[%s] state_set_message() - search_add call failed for %" PRIu64 "\n",
+                        __FILE__,
+                        cached->id
+                    );
+                }
+
+                return NULL;
+            }
+
+            cache_resize(&state->cache, &cached->cache, message_get_size(cached));
+
+            if (channelid != cached->channel_id || authorid != get_author_id(cached)){
+                unindex_message(state, channelid, authorid, cached->id);
+                index_message(state, cached);
+            }
+            else if (reindex && !search_add(state->search, cached->id, cached->content)){
+                log_write(
+                    logger,
+                    LOG_WARNING,
+                    "[%s] state_set_message() - search_add call failed for %" PRIu64 "\n",
+                    __FILE__,
+                    cached->id
+                );
+            }
+        }
+
+        cache_touch(&state->cache, &cached->cache);
+
+        message = cached;
+    }
+    else {
+        message = message_init(state, data);
+
+        if (!message){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_message() - message initialization failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+
+        list_item item = {0};
+        item.type = L_TYPE_GENERIC;
+        item.size = sizeof(*message);
+        item.data = message;
+        item.generic_free = retire_message;
+
+        if (!snowflake_map_set(state->message_ids, message->id, message)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_message() - snowflake_map_set call for message ids failed\n",
+                __FILE__
+            );
+
+            message_free(message);
+
+            return NULL;
+        }
+
+        if (!list_append(state->messages, &item)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_message() - list_append call failed\n",
+                __FILE__
+            );
+
+            snowflake_map_pop(state->message_ids, message->id);
+            message_free(message);
+
+            return NULL;
+        }
+
+        cache_link(&state->cache, &message->cache, CACHE_MESSAGE, message->id, 0, message_get_size(message));
+
+        index_message(state, message);
+
+        /* drop the oldest messages nothing else is pointing at until back under the cap */
+        size_t index = 0;
+
+        while (state->max_messages && list_get_length(state->messages) >= state->max_messages && index < list_get_length(state->messages)){
+            const discord_message *oldest = list_get_generic(state->messages, index);
+
+            if (oldest->cache.refs || oldest == message){
+                ++index;
+
+                continue;
+            }
+
+            list_remove(state->messages, index);
+        }
+    }
+
+    return message;
+}
+
+const discord_message *state_get_message(discord_state *state, snowflake id){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_message() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    discord_message *message = find_message(state, id, NULL);
+
+    if (message){
+        touch_node(state, &message->cache);
+    }
+    else {
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_get_message() - message %" PRIu64 " not found in cache\n",
+            __FILE__,
+            id
+        );
+    }
+
+    return message;
+}
+
+bool state_remove_message(discord_state *state, snowflake id){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_remove_message() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    size_t index = 0;
+
+    if (!find_message(state, id, &index)){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_remove_message() - message %" PRIu64 " not found in cache\n",
+            __FILE__,
+            id
+        );
+
+        return false;
+    }
+
+    list_remove(state->messages, index);
+
+    return true;
+}
+
+static bool is_message_in_channel(const discord_message *message, snowflake channelid){
+    return message->channel_id == channelid;
+}
+
+static bool is_message_by_author(const discord_message *message, snowflake authorid){
+    return get_author_id(message) == authorid;
+}
+
+/* newest first, stopping at limit -- before (if nonzero) excludes it and anything newer */
+static size_t collect_messages(const snowflake_index *index, snowflake key, snowflake before, bool (*match)(const discord_message *, snowflake), snowflake matchid, const discord_message **messages, size_t limit){
+    const snowflake_index_entry *entries = NULL;
+    size_t length = snowflake_index_get_range(index, key, 0, before, &entries);
+    size_t count = 0;
+
+    for (size_t position = length; position && count < limit; --position){
+        const discord_message *message = entries[position - 1].value;
+
+        if (match && !match(message, matchid)){
+            continue;
+        }
+
+        messages[count++] = message;
+    }
+
+    return count;
+}
+
+size_t state_get_channel_messages(discord_state *state, snowflake channelid, snowflake before, const discord_message **messages, size_t limit){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_channel_messages() - state is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+    else if (!messages){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_channel_messages() - messages is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+
+    return collect_messages(state->channel_messages, channelid, before, NULL, 0, messages, limit);
+}
+
+size_t state_get_author_messages(discord_state *state, snowflake authorid, snowflake channelid, snowflake before, const discord_message **messages, size_t limit){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_author_messages() - state is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+    else if (!messages){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_author_messages() - messages is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+
+    if (!channelid){
+        return collect_messages(state->author_messages, authorid, before, NULL, 0, messages, limit);
+    }
+
+    /* walk whichever side is smaller when narrowing to one channel */
+    if (snowflake_index_get_length(state->channel_messages, channelid) < snowflake_index_get_length(state->author_messages, authorid)){
+        return collect_messages(state->channel_messages, channelid, before, is_message_by_author, authorid, messages, limit);
+    }
+
+    return collect_messages(state->author_messages, authorid, before, is_message_in_channel, channelid, messages, limit);
+}
+
+typedef struct search_results {
+    discord_state *state;
+    const discord_search_query *query;
+
+    snowflake guild_id;
+    snowflake channel_id;
+
+    const discord_message **messages;
+    size_t limit;
+    size_t count;
+} search_results;
+
+static bool collect_search_result(void *context, snowflake id){
+    search_results *results = context;
+    const discord_message *message = snowflake_map_get(results->state->message_ids, id);
+
+    if (!message){
+        return true;
+    }
+    else if (results->guild_id && message->guild_id != results->guild_id){
+        return true;
+    }
+    else if (results->channel_id && message->channel_id != results->channel_id){
+        return true;
+    }
+    else if (!search_match_phrases(results->query, message->content)){
+        return true;
+    }
+
+    results->messages[results->count++] = message;
+
+    return results->count < results->limit;
+}
+
+size_t state_search_messages(discord_state *state, const char *query, snowflake guildid, snowflake channelid, const discord_message **messages, size_t limit){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_search_messages() - state is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+    else if (!state->search){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_search_messages() - search index is disabled\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+    else if (!messages || !limit){
+        return 0;
+    }
+
+    discord_search_query parsed = {0};
+
+    if (!search_parse_query(query, &parsed)){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_search_messages() - search_parse_query call failed for %s\n",
+            __FILE__,
+            query
+        );
+
+        return 0;
+    }
+
+    search_results results = {0};
+    results.state = state;
+    results.query = &parsed;
+    results.guild_id = guildid;
+    results.channel_id = channelid;
+    results.messages = messages;
+    results.limit = limit;
+
+    search_run(state->search, &parsed, 0, collect_search_result, &results);
+
+    return results.count;
+}
+
+const discord_emoji *state_set_emoji(discord_state *state, json_object *data){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_emoji() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_emoji() - data is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const char *idstr = json_object_get_string(
+        json_object_object_get(data, "id")
+    );
+
+    if (!idstr){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_emoji() - failed to get id from data: %s\n",
+            __FILE__,
+            json_object_to_json_string(data)
+        );
+
+        return NULL;
+    }
+
+    snowflake id = 0;
+    bool success = snowflake_from_string(idstr, &id);
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_emoji() - snowflake_from_string call failed for id: %s\n",
+            __FILE__,
+            idstr
+        );
+
+        return NULL;
+    }
+
+    discord_emoji *cached = snowflake_map_get(state->emojis, id);
+
+    if (cached){
+        cache_touch(&state->cache, &cached->cache);
+
+        return cached;
+    }
+
+    discord_emoji *emoji = emoji_init(state, data);
+
+    if (!emoji){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_emoji() - emoji initialization failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!snowflake_map_set(state->emojis, emoji->id, emoji)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_emoji() - snowflake_map_set call for emojis failed\n",
+            __FILE__
+        );
+
+        emoji_free(emoji);
+
+        return NULL;
+    }
+
+    cache_link(&state->cache, &emoji->cache, CACHE_EMOJI, emoji->id, 0, emoji_get_size(emoji));
+
+    publish_entity(state, JOURNAL_INSERT, SNAPSHOT_EMOJIS, emoji);
+
+    return emoji;
+}
+
+const discord_emoji *state_get_emoji(discord_state *state, snowflake id){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_emoji() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    discord_emoji *emoji = snowflake_map_get(state->emojis, id);
+
+    if (emoji){
+        touch_node(state, &emoji->cache);
+    }
+    else {
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_get_emoji() - emoji %" PRIu64 " not found\n",
+            __FILE__,
+            id
+        );
+    }
+
+    return emoji;
+}
+
+const discord_guild *state_set_guild(discord_state *state, json_object *data){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_guild() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_guild() - data is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const char *idstr = json_object_get_string(
+        json_object_object_get(data, "id")
+    );
+
+    if (!idstr){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_guild() - failed to get id from data: %s\n",
+            __FILE__,
+            json_object_to_json_string(data)
+        );
+
+        return NULL;
+    }
+
+    snowflake id = 0;
+    bool success = snowflake_from_string(idstr, &id);
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_guild() - snowflake_from_string call failed for id: %s\n",
+            __FILE__,
+            idstr
+        );
+
+        return NULL;
+    }
+
+    discord_guild *cached = snowflake_map_get(state->guilds, id);
+
+    if (cached){
+        if (!guild_update(cached, data)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_guild() - guild_update call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+
+        /* ownership may have moved */
+        invalidate_permissions(state, id);
+
+        publish_entity(state, JOURNAL_UPDATE, SNAPSHOT_GUILDS, cached);
+
+        return cached;
+    }
+
+    discord_guild *guild = guild_init(state, data);
+
+    if (!guild){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_guild() - guild initialization failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    /* drawn from the state-wide counter so a rejoined guild never matches old memo entries */
+    guild->permission_generation = ++state->permission_generation;
+
+    if (!snowflake_map_set(state->guilds, guild->id, guild)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_guild() - snowflake_map_set call for guilds failed\n",
+            __FILE__
+        );
+
+        guild_free(guild);
+
+        return NULL;
+    }
+
+    publish_entity(state, JOURNAL_INSERT, SNAPSHOT_GUILDS, guild);
+
+    return guild;
+}
+
+const discord_guild *state_get_guild(discord_state *state, snowflake id){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_guild() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const discord_guild *guild = snowflake_map_get(state->guilds, id);
+
+    if (!guild){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_get_guild() - guild %" PRIu64 " not found\n",
+            __FILE__,
+            id
+        );
+    }
+
+    return guild;
+}
+
+bool state_remove_guild(discord_state *state, snowflake id){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_remove_guild() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    /* members, roles and channels are keyed by guild -- they go with it */
+    retire_guild_map(state, state->members, id);
+    snowflake_map_remove(state->hierarchies, id);
+    retire_guild_map(state, state->roles, id);
+    remove_guild_channels(state, id);
+    presence_remove_guild(state->presences, id);
+
+    if (!snowflake_map_remove(state->guilds, id)){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_remove_guild() - guild %" PRIu64 " not found\n",
+            __FILE__,
+            id
+        );
+
+        return false;
+    }
+
+    publish_delete(state, SNAPSHOT_GUILDS, 0, id);
+
+    return true;
+}
+
+const discord_member *state_set_member(discord_state *state, snowflake guildid, json_object *data){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_member() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!guildid){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_member() - guild id is 0\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_member() - data is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const char *idstr = json_object_get_string(
+        json_object_object_get(
+            json_object_object_get(data, "user"),
+            "id"
+        )
+    );
+
+    if (!idstr){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_member() - failed to get user id from data: %s\n",
+            __FILE__,
+            json_object_to_json_string(data)
+        );
+
+        return NULL;
+    }
+
+    snowflake id = 0;
+    bool success = snowflake_from_string(idstr, &id);
+
+    if (!success){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_member() - snowflake_from_string call failed for id: %s\n",
+            __FILE__,
+            idstr
+        );
+
+        return NULL;
+    }
+
+    snowflake_map *members = snowflake_map_get(state->members, guildid);
+
+    if (!members){
+        members = snowflake_map_init(retire_member);
+
+        if (!members){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_member() - guild members map initialization failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+
+        members->concurrent = state->members->concurrent;
+
+        if (!snowflake_map_set(state->members, guildid, members)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_member() - snowflake_map_set call for members failed\n",
+                __FILE__
+            );
+
+            snowflake_map_free(members);
+
+            return NULL;
+        }
+    }
+
+    discord_member *cached = snowflake_map_get(members, id);
+
+    if (cached){
+        int changes = 0;
+
+        if (!member_update(cached, data, &changes)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_member() - member_update call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+
+        cache_resize(&state->cache, &cached->cache, member_get_size(cached));
+        cache_touch(&state->cache, &cached->cache);
+
+        if (changes & MEMBER_FIELD_ROLES){
+            invalidate_permissions(state, guildid);
+        }
+
+        if (changes){
+            publish_entity(state, JOURNAL_UPDATE, SNAPSHOT_MEMBERS, cached);
+        }
+
+        notify_diff(state, STATE_ENTITY_MEMBER, cached, changes);
+
+        return cached;
+    }
+
+    discord_member *member = member_init(state, data);
+
+    if (!member){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_member() - member initialization failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    member->guild_id = guildid;
+
+    if (!snowflake_map_set(members, id, member)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_member() - snowflake_map_set call for guild members failed\n",
+            __FILE__
+        );
+
+        member_free(member);
+
+        return NULL;
+    }
+
+    cache_link(&state->cache, &member->cache, CACHE_MEMBER, id, guildid, member_get_size(member));
+
+    publish_entity(state, JOURNAL_INSERT, SNAPSHOT_MEMBERS, member);
+
+    return member;
+}
+
+const discord_member *state_get_member(discord_state *state, snowflake guildid, snowflake userid){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_member() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    discord_member *member = snowflake_map_get(
+        snowflake_map_get(state->members, guildid),
+        userid
+    );
+
+    if (member){
+        touch_node(state, &member->cache);
+    }
+    else {
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_get_member() - member %" PRIu64 " not found in guild %" PRIu64 "\n",
+            __FILE__,
+            userid,
+            guildid
+        );
+    }
+
+    return member;
+}
+
+bool state_remove_member(discord_state *state, snowflake guildid, snowflake userid){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_remove_member() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!remove_member(state, guildid, userid)){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_remove_member() - remove_member call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    publish_delete(state, SNAPSHOT_MEMBERS, guildid, userid);
+
+    return true;
+}
+
+bool state_set_member_presence(discord_state *state, snowflake guildid, json_object *data, discord_presence_event *event){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_member_presence() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!state->presences){
+        /* nothing is stored, but the event still goes out */
+        return !event || presence_read_event(guildid, data, event);
+    }
+
+    if (!presence_update(state->presences, guildid, data, event)){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_member_presence() - presence_update call failed for %s\n",
+            __FILE__,
+            json_object_to_json_string(data)
+        );
+
+        return false;
+    }
+
+    return true;
+}
+
+discord_status state_get_member_status(discord_state *state, snowflake guildid, snowflake userid){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_member_status() - state is NULL\n",
+            __FILE__
+        );
+
+        return STATUS_OFFLINE;
+    }
+
+    return presence_get_status(state->presences, guildid, userid);
+}
+
+size_t state_get_status_count(discord_state *state, snowflake guildid, discord_status status){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_status_count() - state is NULL\n",
+            __FILE__
+        );
+
+        return 0;
+    }
+
+    return presence_get_count(state->presences, guildid, status);
+}
+
+static bool get_data_id(json_object *data, const char *func, snowflake *id){
+    const char *idstr = json_object_get_string(
+        json_object_object_get(data, "id")
+    );
+
+    if (!idstr){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] %s() - failed to get id from data: %s\n",
+            __FILE__,
+            func,
+            json_object_to_json_string(data)
+        );
+
+        return false;
+    }
+
+    if (!snowflake_from_string(idstr, id)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] %s() - snowflake_from_string call failed for id: %s\n",
+            __FILE__,
+            func,
+            idstr
+        );
+
+        return false;
+    }
 
-        if (tmp->id == id){
-            cached = tmp;
+    return true;
+}
 
-            break;
-        }
+const discord_role *state_set_role(discord_state *state, snowflake guildid, json_object *data){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_role() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
     }
+    else if (!guildid){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_role() - guild id is 0\n",
+            __FILE__
+        );
 
-    discord_message *message = NULL;
+        return NULL;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_role() - data is NULL\n",
+            __FILE__
+        );
 
-    if (cached){
-        if (update){
-            if (!message_update(cached, data)){
-                log_write(
-                    logger,
-                    LOG_ERROR,
-                    "[%s] state_set_message() - message_update call failed\n",
-                    __FILE__
-                );
+        return NULL;
+    }
 
-                message_free(message);
+    snowflake id = 0;
 
-                return NULL;
-            }
+    if (!get_data_id(data, "state_set_role", &id)){
+        return NULL;
+    }
+
+    snowflake_map *roles = snowflake_map_get(state->roles, guildid);
+
+    if (!roles){
+        roles = snowflake_map_init(retire_role);
+
+        if (!roles){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_role() - guild roles map initialization failed\n",
+                __FILE__
+            );
+
+            return NULL;
         }
 
-        message = cached;
+        roles->concurrent = state->roles->concurrent;
+
+        if (!snowflake_map_set(state->roles, guildid, roles)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_role() - snowflake_map_set call for roles failed\n",
+                __FILE__
+            );
+
+            snowflake_map_free(roles);
+
+            return NULL;
+        }
+    }
+
+    discord_role *role = snowflake_map_get(roles, id);
+
+    if (role){
+        if (!role_update(role, data)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_role() - role_update call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
     }
     else {
-        message = message_init(state, data);
+        role = role_init(state, data);
 
-        if (!message){
+        if (!role){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] state_set_message() - message initialization failed\n",
+                "[%s] state_set_role() - role initialization failed\n",
                 __FILE__
             );
 
             return NULL;
         }
 
-        list_item item = {0};
-        item.type = L_TYPE_GENERIC;
-        item.size = sizeof(*message);
-        item.data = message;
-        item.generic_free = message_free;
+        role->guild_id = guildid;
 
-        if (!list_append(state->messages, &item)){
+        if (!snowflake_map_set(roles, id, role)){
             log_write(
                 logger,
                 LOG_ERROR,
-                "[%s] state_set_message() - list_append call failed\n",
+                "[%s] state_set_role() - snowflake_map_set call for guild roles failed\n",
                 __FILE__
             );
 
-            message_free(message);
+            role_free(role);
+
+            return NULL;
+        }
+    }
+
+    discord_role_hierarchy *hierarchy = snowflake_map_get(state->hierarchies, guildid);
+
+    if (!hierarchy){
+        hierarchy = role_hierarchy_init();
+
+        if (!hierarchy || !snowflake_map_set(state->hierarchies, guildid, hierarchy)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_role() - guild hierarchy initialization failed\n",
+                __FILE__
+            );
+
+            role_hierarchy_free(hierarchy);
+
+            return NULL;
+        }
+    }
+
+    /* positions may have moved -- rank the role again */
+    if (!role_hierarchy_place(hierarchy, role)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] state_set_role() - role_hierarchy_place call failed\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    invalidate_permissions(state, guildid);
+
+    return role;
+}
+
+const discord_role *state_get_role(discord_state *state, snowflake guildid, snowflake roleid){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_role() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const discord_role *role = snowflake_map_get(
+        snowflake_map_get(state->roles, guildid),
+        roleid
+    );
+
+    if (!role){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_get_role() - role %" PRIu64 " not found in guild %" PRIu64 "\n",
+            __FILE__,
+            roleid,
+            guildid
+        );
+    }
+
+    return role;
+}
+
+bool state_remove_role(discord_state *state, snowflake guildid, snowflake roleid){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_remove_role() - state is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    snowflake_map *roles = snowflake_map_get(state->roles, guildid);
+    discord_role_hierarchy *hierarchy = snowflake_map_get(state->hierarchies, guildid);
+
+    role_hierarchy_remove(hierarchy, snowflake_map_get(roles, roleid));
+
+    if (!snowflake_map_remove(roles, roleid)){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_remove_role() - role %" PRIu64 " not found in guild %" PRIu64 "\n",
+            __FILE__,
+            roleid,
+            guildid
+        );
+
+        return false;
+    }
+
+    invalidate_permissions(state, guildid);
+
+    if (!snowflake_map_get_length(roles)){
+        snowflake_map_remove(state->hierarchies, guildid);
+        retire_guild_map(state, state->roles, guildid);
+    }
+
+    return true;
+}
+
+const discord_channel *state_set_channel(discord_state *state, snowflake guildid, json_object *data){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_channel() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_set_channel() - data is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    snowflake id = 0;
+
+    if (!get_data_id(data, "state_set_channel", &id)){
+        return NULL;
+    }
+
+    discord_channel *channel = snowflake_map_get(state->channels, id);
+
+    if (channel){
+        if (!channel_update(channel, data)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_channel() - channel_update call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+    }
+    else {
+        channel = channel_init(state, data);
+
+        if (!channel){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_channel() - channel initialization failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+
+        if (!snowflake_map_set(state->channels, id, channel)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_channel() - snowflake_map_set call for channels failed\n",
+                __FILE__
+            );
+
+            channel_free(channel);
 
             return NULL;
         }
+    }
+
+    /* channels nested in GUILD_CREATE leave out their guild_id */
+    if (!channel->guild_id){
+        channel->guild_id = guildid;
+    }
+
+    invalidate_permissions(state, channel->guild_id);
+
+    return channel;
+}
+
+const discord_channel *state_get_channel(discord_state *state, snowflake id){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_get_channel() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+
+    const discord_channel *channel = snowflake_map_get(state->channels, id);
+
+    if (!channel){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_get_channel() - channel %" PRIu64 " not found\n",
+            __FILE__,
+            id
+        );
+    }
+
+    return channel;
+}
+
+bool state_remove_channel(discord_state *state, snowflake id){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_remove_channel() - state is NULL\n",
+            __FILE__
+        );
 
-        if (state->max_messages && list_get_length(state->messages) == state->max_messages){
-            list_remove(state->messages, 0);
-        }
+        return false;
     }
 
-    return message;
-}
+    const discord_channel *channel = snowflake_map_get(state->channels, id);
 
-const discord_message *state_get_message(discord_state *state, snowflake id){
-    if (!state){
+    if (!channel){
         log_write(
             logger,
-            LOG_WARNING,
-            "[%s] state_get_message() - state is NULL\n",
-            __FILE__
+            LOG_DEBUG,
+            "[%s] state_remove_channel() - channel %" PRIu64 " not found\n",
+            __FILE__,
+            id
         );
 
-        return NULL;
+        return false;
     }
 
-    const discord_message *message = NULL;
+    invalidate_permissions(state, channel->guild_id);
 
-    size_t messageslen = list_get_length(state->messages);
+    return snowflake_map_remove(state->channels, id);
+}
 
-    for (size_t index = 0; index < messageslen; ++index){
-        const discord_message *tmp = list_get_generic(state->messages, index);
+static discord_permissions compute_base_permissions(discord_state *state, const discord_guild *guild, const discord_member *member){
+    snowflake_map *roles = snowflake_map_get(state->roles, guild->id);
 
-        if (tmp->id == id){
-            message = tmp;
+    /* @everyone shares its id with the guild */
+    const discord_role *everyone = snowflake_map_get(roles, guild->id);
+    discord_permissions permissions = everyone ? everyone->permission_bits : 0;
 
-            break;
+    for (size_t index = 0; index < snowflake_set_get_length(member->roles); ++index){
+        const discord_role *role = snowflake_map_get(roles, member->roles->ids[index]);
+
+        if (role){
+            permissions |= role->permission_bits;
         }
     }
 
-    if (!message){
-        log_write(
-            logger,
-            LOG_DEBUG,
-            "[%s] state_get_message() - message %" PRIu64 " not found in cache\n",
-            __FILE__,
-            id
-        );
+    return permissions;
+}
+
+static discord_permissions compute_overwrites(const discord_channel *channel, const discord_member *member, discord_permissions permissions){
+    const discord_overwrite *everyone = NULL;
+    const discord_overwrite *own = NULL;
+    discord_overwrite roles = {0};
+
+    for (size_t index = 0; index < list_get_length(channel->permission_overwrites); ++index){
+        const discord_overwrite *overwrite = list_get_generic(channel->permission_overwrites, index);
+
+        if (overwrite->type == OVERWRITE_MEMBER){
+            if (overwrite->id == member->user->id){
+                own = overwrite;
+            }
+        }
+        else if (overwrite->id == channel->guild_id){
+            everyone = overwrite;
+        }
+        else if (snowflake_set_contains(member->roles, overwrite->id)){
+            roles.allow |= overwrite->allow;
+            roles.deny |= overwrite->deny;
+        }
     }
 
-    return message;
+    /* the order is fixed by discord: @everyone, then the member's roles together, then the member */
+    if (everyone){
+        permissions = permission_apply_overwrite(permissions, everyone);
+    }
+
+    permissions = permission_apply_overwrite(permissions, &roles);
+
+    if (own){
+        permissions = permission_apply_overwrite(permissions, own);
+    }
+
+    return permissions;
 }
 
-const discord_emoji *state_set_emoji(discord_state *state, json_object *data){
+bool state_get_permissions(discord_state *state, snowflake guildid, snowflake channelid, snowflake userid, discord_permissions *permissions){
     if (!state){
         log_write(
             logger,
             LOG_WARNING,
-            "[%s] state_set_emoji() - state is NULL\n",
+            "[%s] state_get_permissions() - state is NULL\n",
             __FILE__
         );
 
-        return NULL;
+        return false;
     }
-    else if (!data){
+    else if (!permissions){
         log_write(
             logger,
             LOG_WARNING,
-            "[%s] state_set_emoji() - data is NULL\n",
+            "[%s] state_get_permissions() - permissions is NULL\n",
             __FILE__
         );
 
-        return NULL;
+        return false;
     }
 
-    const char *idstr = json_object_get_string(
-        json_object_object_get(data, "id")
-    );
+    const discord_channel *channel = NULL;
 
-    if (!idstr){
+    if (channelid){
+        channel = snowflake_map_get(state->channels, channelid);
+
+        if (!channel){
+            log_write(
+                logger,
+                LOG_DEBUG,
+                "[%s] state_get_permissions() - channel %" PRIu64 " not found\n",
+                __FILE__,
+                channelid
+            );
+
+            return false;
+        }
+
+        if (!guildid){
+            guildid = channel->guild_id;
+        }
+    }
+
+    const discord_guild *guild = snowflake_map_get(state->guilds, guildid);
+
+    if (!guild){
         log_write(
             logger,
-            LOG_WARNING,
-            "[%s] state_set_emoji() - failed to get id from data: %s\n",
+            LOG_DEBUG,
+            "[%s] state_get_permissions() - guild %" PRIu64 " not found\n",
             __FILE__,
-            json_object_to_json_string(data)
+            guildid
         );
 
-        return NULL;
+        return false;
     }
 
-    snowflake id = 0;
-    bool success = snowflake_from_string(idstr, &id);
+    /* guild-level permissions are memoized with no channel */
+    if (permission_memo_get(state->permissions, guildid, channelid, userid, guild->permission_generation, permissions)){
+        return true;
+    }
 
-    if (!success){
+    const discord_member *member = snowflake_map_get(
+        snowflake_map_get(state->members, guildid),
+        userid
+    );
+
+    if (!member || !member->user){
         log_write(
             logger,
-            LOG_ERROR,
-            "[%s] state_set_emoji() - snowflake_from_string call failed for id: %s\n",
+            LOG_DEBUG,
+            "[%s] state_get_permissions() - member %" PRIu64 " not found in guild %" PRIu64 "\n",
             __FILE__,
-            idstr
+            userid,
+            guildid
         );
 
-        return NULL;
+        return false;
     }
 
-    const discord_emoji *cached = state_get_emoji(state, id);
+    discord_permissions computed = PERMISSION_ALL;
 
-    if (cached){
-        return cached;
+    if (guild->owner_id != userid){
+        computed = compute_base_permissions(state, guild, member);
+
+        if (computed & PERMISSION_ADMINISTRATOR){
+            computed = PERMISSION_ALL;
+        }
+        else if (channel){
+            computed = compute_overwrites(channel, member, computed);
+        }
     }
 
-    discord_emoji *emoji = emoji_init(state, data);
+    permission_memo_set(state->permissions, guildid, channelid, userid, guild->permission_generation, computed);
 
-    if (!emoji){
+    *permissions = computed;
+
+    return true;
+}
+
+/* NULL when the member holds nothing above @everyone */
+static const discord_role *get_highest_role(discord_state *state, snowflake guildid, const discord_member *member){
+    snowflake_map *roles = snowflake_map_get(state->roles, guildid);
+    const discord_role *highest = NULL;
+
+    for (size_t index = 0; index < snowflake_set_get_length(member->roles); ++index){
+        const discord_role *role = snowflake_map_get(roles, member->roles->ids[index]);
+
+        if (role && (!highest || role->rank > highest->rank)){
+            highest = role;
+        }
+    }
+
+    return highest;
+}
+
+const discord_role *state_get_highest_role(discord_state *state, snowflake guildid, snowflake userid){
+    if (!state){
         log_write(
             logger,
-            LOG_ERROR,
-            "[%s] state_set_emoji() - emoji initialization failed\n",
+            LOG_WARNING,
+            "[%s] state_get_highest_role() - state is NULL\n",
             __FILE__
         );
 
-        return false;
+        return NULL;
     }
 
-    map_item k = {0};
-    k.type = M_TYPE_UINT;
-    k.size = sizeof(emoji->id);
-    k.data_copy = &emoji->id;
-
-    map_item v = {0};
-    v.type = M_TYPE_GENERIC;
-    v.size = sizeof(emoji);
-    v.data = emoji;
-    v.generic_free = emoji_free;
+    const discord_member *member = snowflake_map_get(
+        snowflake_map_get(state->members, guildid),
+        userid
+    );
 
-    if (!map_set(state->emojis, &k, &v)){
+    if (!member){
         log_write(
             logger,
-            LOG_ERROR,
-            "[%s] state_set_emoji() - map_set call for emojis failed\n",
-            __FILE__
+            LOG_DEBUG,
+            "[%s] state_get_highest_role() - member %" PRIu64 " not found in guild %" PRIu64 "\n",
+            __FILE__,
+            userid,
+            guildid
         );
 
-        emoji_free(emoji);
-
         return NULL;
     }
 
-    return emoji;
+    const discord_role *highest = get_highest_role(state, guildid, member);
+
+    return highest ? highest : snowflake_map_get(snowflake_map_get(state->roles, guildid), guildid);
 }
 
-const discord_emoji *state_get_emoji(discord_state *state, snowflake id){
+bool state_can_moderate(discord_state *state, snowflake guildid, snowflake actorid, snowflake targetid){
     if (!state){
         log_write(
             logger,
             LOG_WARNING,
-            "[%s] state_get_emoji() - state is NULL\n",
+            "[%s] state_can_moderate() - state is NULL\n",
             __FILE__
         );
 
-        return NULL;
+        return false;
     }
 
-    size_t idsize = sizeof(id);
+    const discord_guild *guild = snowflake_map_get(state->guilds, guildid);
 
-    if (!map_contains(state->emojis, idsize, &id)){
+    if (!guild){
         log_write(
             logger,
             LOG_DEBUG,
-            "[%s] state_get_emoji() - emoji %" PRIu64 " not found\n",
+            "[%s] state_can_moderate() - guild %" PRIu64 " not found\n",
             __FILE__,
-            id
+            guildid
         );
 
-        return NULL;
+        return false;
+    }
+    else if (actorid == targetid || targetid == guild->owner_id){
+        return false;
+    }
+    else if (actorid == guild->owner_id){
+        return true;
+    }
+
+    snowflake_map *members = snowflake_map_get(state->members, guildid);
+    const discord_member *actor = snowflake_map_get(members, actorid);
+    const discord_member *target = snowflake_map_get(members, targetid);
+
+    if (!actor || !target){
+        log_write(
+            logger,
+            LOG_DEBUG,
+            "[%s] state_can_moderate() - member not found in guild %" PRIu64 "\n",
+            __FILE__,
+            guildid
+        );
+
+        return false;
+    }
+
+    const discord_role *actorrole = get_highest_role(state, guildid, actor);
+    const discord_role *targetrole = get_highest_role(state, guildid, target);
+
+    if (!actorrole){
+        return false;
     }
 
-    return map_get_generic(state->emojis, idsize, &id);
+    return !targetrole || actorrole->rank > targetrole->rank;
 }
 
 const discord_user *state_set_user(discord_state *state, json_object *data){
@@ -795,9 +3795,31 @@ const discord_user *state_set_user(discord_state *state, json_object *data){
         return NULL;
     }
 
-    const discord_user *cached = state_get_user(state, id);
+    discord_user *cached = snowflake_map_get(state->users, id);
 
     if (cached){
+        int changes = 0;
+
+        if (!user_update(cached, data, &changes)){
+            log_write(
+                logger,
+                LOG_ERROR,
+                "[%s] state_set_user() - user_update call failed\n",
+                __FILE__
+            );
+
+            return NULL;
+        }
+
+        cache_resize(&state->cache, &cached->cache, user_get_size(cached));
+        cache_touch(&state->cache, &cached->cache);
+
+        if (changes){
+            publish_entity(state, JOURNAL_UPDATE, SNAPSHOT_USERS, cached);
+        }
+
+        notify_diff(state, STATE_ENTITY_USER, cached, changes);
+
         return cached;
     }
 
@@ -814,22 +3836,11 @@ const discord_user *state_set_user(discord_state *state, json_object *data){
         return false;
     }
 
-    map_item k = {0};
-    k.type = M_TYPE_UINT;
-    k.size = sizeof(user->id);
-    k.data_copy = &user->id;
-
-    map_item v = {0};
-    v.type = M_TYPE_GENERIC;
-    v.size = sizeof(user);
-    v.data = user;
-    v.generic_free = user_free;
-
-    if (!map_set(state->users, &k, &v)){
+    if (!snowflake_map_set(state->users, user->id, user)){
         log_write(
             logger,
             LOG_ERROR,
-            "[%s] state_set_user() - map_set call for users failed\n",
+            "[%s] state_set_user() - snowflake_map_set call for users failed\n",
             __FILE__
         );
 
@@ -838,6 +3849,10 @@ const discord_user *state_set_user(discord_state *state, json_object *data){
         return NULL;
     }
 
+    cache_link(&state->cache, &user->cache, CACHE_USER, user->id, 0, user_get_size(user));
+
+    publish_entity(state, JOURNAL_INSERT, SNAPSHOT_USERS, user);
+
     return user;
 }
 
@@ -853,9 +3868,12 @@ const discord_user *state_get_user(discord_state *state, snowflake id){
         return NULL;
     }
 
-    size_t idsize = sizeof(id);
+    discord_user *user = snowflake_map_get(state->users, id);
 
-    if (!map_contains(state->users, idsize, &id)){
+    if (user){
+        touch_node(state, &user->cache);
+    }
+    else {
         log_write(
             logger,
             LOG_DEBUG,
@@ -863,11 +3881,121 @@ const discord_user *state_get_user(discord_state *state, snowflake id){
             __FILE__,
             id
         );
+    }
+
+    return user;
+}
+
+/* one request per id in flight -- later misses ride along with it */
+static bool queue_fetch(discord_state *state, discord_fetch_kind kind, snowflake id){
+    if (!state->fetcher){
+        return false;
+    }
+    else if (snowflake_map_get(state->fetching, id)){
+        return true;
+    }
+
+    if (!snowflake_map_set(state->fetching, id, state)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] queue_fetch() - snowflake_map_set call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!fetch_submit(state->fetcher, kind, id)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] queue_fetch() - fetch_submit call failed\n",
+            __FILE__
+        );
+
+        snowflake_map_pop(state->fetching, id);
+
+        return false;
+    }
+
+    return true;
+}
+
+const discord_user *state_fetch_user(discord_state *state, snowflake id){
+    if (!state){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] state_fetch_user() - state is NULL\n",
+            __FILE__
+        );
+
+        return NULL;
+    }
+    else if (!state->fetcher){
+        return state_get_user(state, id);
+    }
+
+    discord_user *user = snowflake_map_get(state->users, id);
+
+    if (!user){
+        queue_fetch(state, FETCH_USER, id);
 
         return NULL;
     }
 
-    return map_get_generic(state->users, idsize, &id);
+    touch_node(state, &user->cache);
+
+    /* stale entries are still served -- the refreshed copy lands in place */
+    if (state->revalidate_after && time(NULL) - user->cache.refreshed >= state->revalidate_after){
+        queue_fetch(state, FETCH_USER, id);
+    }
+
+    return user;
+}
+
+/* applies finished background fetches -- call from the thread that owns the state */
+size_t state_process_fetches(discord_state *state){
+    if (!state || !state->fetcher){
+        return 0;
+    }
+
+    size_t processed = 0;
+    discord_fetch_request *request = fetch_take_completed(state->fetcher);
+
+    while (request){
+        discord_fetch_request *next = request->next;
+        const void *object = NULL;
+
+        snowflake_map_pop(state->fetching, request->id);
+
+        if (request->data && request->status == 200){
+            object = state_set_user(state, request->data);
+        }
+        else {
+            log_write(
+                logger,
+                LOG_WARNING,
+                "[%s] state_process_fetches() - fetch for %" PRIu64 " failed with status %ld\n",
+                __FILE__,
+                request->id,
+                request->status
+            );
+        }
+
+        if (state->on_fetch){
+            state->on_fetch(state->event_context, STATE_ENTITY_USER, request->id, object);
+        }
+
+        fetch_request_free(request);
+
+        request = next;
+
+        ++processed;
+    }
+
+    return processed;
 }
 
 void state_free(discord_state *state){
@@ -882,13 +4010,63 @@ void state_free(discord_state *state){
         return;
     }
 
+    /* cross-entity holds are dropped wholesale rather than one by one */
+    state->closing = true;
+
+    if (state->fetcher){
+        fetch_free(state->fetcher);
+    }
+
+    snowflake_map_free(state->fetching);
+
+    /* readers must be gone by now -- anything still retired goes first */
+    if (state->epoch){
+        epoch_free(state->epoch);
+
+        state->epoch = NULL;
+    }
+
     http_free(state->http);
 
     json_object_put(state->presence);
 
     list_free(state->messages);
-    map_free(state->emojis);
-    map_free(state->users);
+    snowflake_map_free(state->message_ids);
+    snowflake_index_free(state->channel_messages);
+    snowflake_index_free(state->author_messages);
+
+    if (state->search){
+        search_free(state->search);
+    }
+
+    if (state->presences){
+        presence_store_free(state->presences);
+    }
+
+    if (state->journal){
+        journal_free(state->journal);
+    }
+
+    if (state->shared){
+        shared_cache_close(state->shared);
+    }
+
+    snowflake_map_free(state->emojis);
+    snowflake_map_free(state->hierarchies);
+    snowflake_map_free(state->roles);
+    snowflake_map_free(state->channels);
+    snowflake_map_free(state->guilds);
+
+    if (state->permissions){
+        permission_memo_free(state->permissions);
+    }
+
+    /* members reference users -- release them first */
+    snowflake_map_free(state->members);
+    snowflake_map_free(state->users);
+
+    /* cached objects release their strings on free */
+    intern_free(state->strings);
 
     free(state->token);
     free(state);
@@ -8,30 +8,50 @@
 #include "str.h"
 
 #include "snowflake.h"
+#include "snowflake_index.h"
+#include "snowflake_map.h"
+#include "snowflake_set.h"
 
 typedef struct discord_activity discord_activity;
 typedef struct discord_application discord_application;
 typedef struct discord_channel discord_channel;
 typedef struct discord_embed discord_embed;
 typedef struct discord_emoji discord_emoji;
+typedef struct discord_guild discord_guild;
 typedef struct discord_http discord_http;
 typedef struct discord_member discord_member;
 typedef struct discord_message discord_message;
 typedef struct discord_message_reply discord_message_reply;
+typedef struct discord_role discord_role;
 typedef struct discord_state discord_state;
 typedef struct discord_team discord_team;
 typedef struct discord_user discord_user;
 
+#include "cache.h"
+#include "compact.h"
+#include "epoch.h"
+#include "fetch.h"
+#include "intern.h"
+#include "journal.h"
+#include "permission.h"
+#include "presence.h"
+#include "ratelimit.h"
+#include "search.h"
+#include "shared_cache.h"
+#include "snapshot.h"
+
 #include "activity.h"
 #include "application.h"
 #include "attachment.h"
 #include "channel.h"
 #include "embed.h"
 #include "emoji.h"
+#include "guild.h"
 #include "http.h"
 #include "member.h"
 #include "message.h"
 #include "reaction.h"
+#include "role.h"
 #include "team.h"
 #include "user.h"
 
@@ -84,11 +104,76 @@ typedef struct discord_presence {
     bool afk;
 } discord_presence;
 
+typedef enum discord_state_entity {
+    STATE_ENTITY_USER,
+    STATE_ENTITY_MEMBER
+} discord_state_entity;
+
+/* context, entity kind, updated entity, mask of discord_*_fields that changed */
+typedef void (*discord_state_diff)(void *, discord_state_entity, const void *, int);
+
+/* context, entity kind, requested id, cached entity (NULL if the fetch failed) */
+typedef void (*discord_state_fetched)(void *, discord_state_entity, snowflake, const void *);
+
+/* context, a batch of whole mutation log records and its size in bytes */
+typedef void (*discord_state_journaled)(void *, const unsigned char *, size_t);
+
 typedef struct discord_state_options {
     const logctx *log;
     discord_gateway_intents intent;
 
     size_t max_messages;
+
+    /* copy cached strings into per-object arenas and drop the json-c DOM */
+    bool compact;
+
+    /* share repeated strings (names, hashes, permissions) through one table */
+    bool intern;
+
+    /* called after a cached user or member is updated in place */
+    discord_state_diff on_diff;
+
+    /* bytes the cached entities may use before unreferenced ones are evicted (0 = unbounded) */
+    size_t cache_budget;
+
+    /* seconds an unused, unreferenced entity stays cached (0 = forever) */
+    time_t cache_ttl;
+
+    /* let other threads call state_get_* -- replaced objects are freed a grace period later */
+    bool concurrent_reads;
+
+    /* keep a word index over cached message content for state_search_messages */
+    bool search;
+
+    /* fetch state_fetch_* misses on a background thread instead of failing */
+    bool read_through;
+
+    /* seconds after which a cached entity served by state_fetch_* is refetched (0 = never) */
+    time_t revalidate_after;
+
+    /* called once a background fetch has been applied to the cache */
+    discord_state_fetched on_fetch;
+
+    /* track member statuses from PRESENCE_UPDATE, optionally with their activities */
+    bool presences;
+    bool presence_activities;
+
+    /* log every cache mutation and hand the records over after each event (for replicas) */
+    discord_state_journaled on_journal;
+
+    /* mirror users, guilds and members into this shm_open segment for other processes */
+    const char *shared_cache;
+    size_t shared_capacity;
+
+    /* shm_open segment holding the global rate limiter shared by processes on this token */
+    const char *global_limiter;
+    unsigned global_rate;
+
+    /* invalid request breaker changed state -- gets event_context */
+    discord_ratelimit_breaker_changed on_breaker;
+
+    /* send REST requests over http/2, multiplexed on one connection */
+    bool http2;
 } discord_state_options;
 
 typedef struct discord_state {
@@ -104,10 +189,48 @@ typedef struct discord_state {
     json_object *presence;
 
     list *messages;
+    snowflake_map *message_ids;
+    snowflake_index *channel_messages;
+    snowflake_index *author_messages;
+    discord_search *search;
+
+    discord_presence_store *presences;
     size_t max_messages;
 
-    map *emojis;
-    map *users;
+    bool compact;
+    size_t compact_saved;
+
+    discord_intern_table *strings;
+
+    discord_state_diff on_diff;
+
+    discord_cache cache;
+    bool closing;
+
+    discord_epoch *epoch;
+
+    discord_fetcher *fetcher;
+    snowflake_map *fetching;
+    time_t revalidate_after;
+    discord_state_fetched on_fetch;
+
+    snowflake_map *emojis;
+    snowflake_map *guilds;
+    snowflake_map *members;
+    snowflake_map *users;
+
+    /* guild id -> role id -> role */
+    snowflake_map *roles;
+    snowflake_map *hierarchies;
+    snowflake_map *channels;
+
+    discord_permission_memo *permissions;
+    uint64_t permission_generation;
+
+    discord_journal *journal;
+    discord_state_journaled on_journal;
+
+    discord_shared_cache *shared;
 } discord_state;
 
 discord_state *state_init(const char *, const discord_state_options *);
@@ -121,14 +244,73 @@ bool state_set_presence_activities(discord_state *, const list *);
 bool state_set_presence_status(discord_state *, const char *);
 bool state_set_presence_afk(discord_state *, bool);
 
+bool state_intern_string(discord_state *, const char **, const char *);
+void state_release_string(discord_state *, const char *);
+
+bool state_hold_user(discord_state *, const discord_user **, const discord_user *);
+bool state_hold_emoji(discord_state *, const discord_emoji **, const discord_emoji *);
+bool state_hold_message(discord_state *, const discord_message **, const discord_message *);
+
+void state_retire(discord_state *, void *, void (*)(void *));
+void state_retire_list(discord_state *, list *);
+void state_retire_object(discord_state *, json_object *);
+bool state_merge_object(discord_state *, json_object **, json_object *);
+size_t state_reclaim(discord_state *);
+
+int state_reader_register(discord_state *);
+void state_reader_unregister(discord_state *, int);
+void state_read_begin(discord_state *, int);
+void state_read_end(discord_state *, int);
+
+size_t state_trim(discord_state *);
+bool state_get_cache_usage(const discord_state *, discord_cache_usage *);
+
+bool state_snapshot(discord_state *, const char *, const char *, int);
+bool state_restore(discord_state *, const char *, char *, size_t, int *);
+
+size_t state_flush_journal(discord_state *);
+size_t state_apply_journal(discord_state *, const unsigned char *, size_t, uint64_t *);
+
 const discord_message *state_set_message(discord_state *, json_object *, bool);
 const discord_message *state_get_message(discord_state *, snowflake);
+bool state_remove_message(discord_state *, snowflake);
+size_t state_get_channel_messages(discord_state *, snowflake, snowflake, const discord_message **, size_t);
+size_t state_get_author_messages(discord_state *, snowflake, snowflake, snowflake, const discord_message **, size_t);
+size_t state_search_messages(discord_state *, const char *, snowflake, snowflake, const discord_message **, size_t);
 
 const discord_emoji *state_set_emoji(discord_state *, json_object *);
 const discord_emoji *state_get_emoji(discord_state *, snowflake);
 
+const discord_guild *state_set_guild(discord_state *, json_object *);
+const discord_guild *state_get_guild(discord_state *, snowflake);
+bool state_remove_guild(discord_state *, snowflake);
+
+const discord_member *state_set_member(discord_state *, snowflake, json_object *);
+const discord_member *state_get_member(discord_state *, snowflake, snowflake);
+bool state_remove_member(discord_state *, snowflake, snowflake);
+
+const discord_role *state_set_role(discord_state *, snowflake, json_object *);
+const discord_role *state_get_role(discord_state *, snowflake, snowflake);
+bool state_remove_role(discord_state *, snowflake, snowflake);
+
+const discord_channel *state_set_channel(discord_state *, snowflake, json_object *);
+const discord_channel *state_get_channel(discord_state *, snowflake);
+bool state_remove_channel(discord_state *, snowflake);
+
+bool state_get_permissions(discord_state *, snowflake, snowflake, snowflake, discord_permissions *);
+
+const discord_role *state_get_highest_role(discord_state *, snowflake, snowflake);
+bool state_can_moderate(discord_state *, snowflake, snowflake, snowflake);
+
+bool state_set_member_presence(discord_state *, snowflake, json_object *, discord_presence_event *);
+discord_status state_get_member_status(discord_state *, snowflake, snowflake);
+size_t state_get_status_count(discord_state *, snowflake, discord_status);
+
 const discord_user *state_set_user(discord_state *, json_object *);
 const discord_user *state_get_user(discord_state *, snowflake);
+const discord_user *state_fetch_user(discord_state *, snowflake);
+
+size_t state_process_fetches(discord_state *);
 
 void state_free(discord_state *);
 
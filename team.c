@@ -42,9 +42,9 @@ static bool construct_team_member(discord_state *state, discord_team_member *mem
             success = snowflake_from_string(objstr, &member->team_id);
         }
         else if (!strcmp(key, "user")){
-            member->user = state_set_user(state, valueobj);
+            const discord_user *user = state_set_user(state, valueobj);
 
-            success = member->user;
+            success = user && state_hold_user(state, &member->user, user);
         }
 
         if (!success){
@@ -90,7 +90,7 @@ static bool construct_team_members(discord_team *team, json_object *data){
     for (size_t index = 0; index < json_object_array_length(data); ++index){
         json_object *obj = json_object_array_get_idx(data, index);
 
-        discord_team_member *member = malloc(sizeof(*member));
+        discord_team_member *member = calloc(1, sizeof(*member));
 
         if (!member){
             log_write(
@@ -115,6 +115,7 @@ static bool construct_team_members(discord_team *team, json_object *data){
                 __FILE__
             );
 
+            state_hold_user(team->state, &member->user, NULL);
             team_member_free(member);
 
             success = false;
@@ -138,6 +139,9 @@ static bool construct_team_members(discord_team *team, json_object *data){
                 __FILE__
             );
 
+            state_hold_user(team->state, &member->user, NULL);
+            team_member_free(member);
+
             break;
         }
     }
@@ -295,6 +299,14 @@ void team_free(void *teamptr){
 
     json_object_put(team->raw_object);
 
+    size_t memberslen = list_get_length(team->members);
+
+    for (size_t index = 0; index < memberslen; ++index){
+        discord_team_member *member = list_get_generic(team->members, index);
+
+        state_hold_user(team->state, &member->user, NULL);
+    }
+
     list_free(team->members);
 
     free(team);
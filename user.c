@@ -2,31 +2,85 @@
 
 static const logctx *logger = NULL;
 
-static bool construct_user(discord_user *user){
-    bool success = true;
+static bool is_string_changed(const char *curr, json_object *valueobj){
+    const char *value = json_object_get_string(valueobj);
 
-    struct json_object_iterator curr = json_object_iter_begin(user->raw_object);
-    struct json_object_iterator end = json_object_iter_end(user->raw_object);
+    if (!curr || !value){
+        return curr != value;
+    }
+
+    return strcmp(curr, value);
+}
+
+static int get_user_changes(const discord_user *user, json_object *data){
+    int changes = 0;
+
+    struct json_object_iterator curr = json_object_iter_begin(data);
+    struct json_object_iterator end = json_object_iter_end(data);
 
     while (!json_object_iter_equal(&curr, &end)){
         const char *key = json_object_iter_peek_name(&curr);
         json_object *valueobj = json_object_iter_peek_value(&curr);
-        json_type type = json_object_get_type(valueobj);
 
-        bool skip = false;
-
-        if (!valueobj || type == json_type_null){
-            skip = true;
+        if (!strcmp(key, "username") && is_string_changed(user->username, valueobj)){
+            changes |= USER_FIELD_USERNAME;
+        }
+        else if (!strcmp(key, "discriminator") && is_string_changed(user->discriminator, valueobj)){
+            changes |= USER_FIELD_DISCRIMINATOR;
+        }
+        else if (!strcmp(key, "avatar") && is_string_changed(user->avatar, valueobj)){
+            changes |= USER_FIELD_AVATAR;
+        }
+        else if (!strcmp(key, "bot") && user->bot != json_object_get_boolean(valueobj)){
+            changes |= USER_FIELD_BOT;
+        }
+        else if (!strcmp(key, "system") && user->system != json_object_get_boolean(valueobj)){
+            changes |= USER_FIELD_SYSTEM;
         }
-        else if (type == json_type_array){
-            skip = !json_object_array_length(valueobj);
+        else if (!strcmp(key, "mfa_enabled") && user->mfa_enabled != json_object_get_boolean(valueobj)){
+            changes |= USER_FIELD_MFA_ENABLED;
+        }
+        else if (!strcmp(key, "banner") && is_string_changed(user->banner, valueobj)){
+            changes |= USER_FIELD_BANNER;
+        }
+        else if (!strcmp(key, "accent_color") && user->accent_color != json_object_get_int(valueobj)){
+            changes |= USER_FIELD_ACCENT_COLOR;
+        }
+        else if (!strcmp(key, "locale") && is_string_changed(user->locale, valueobj)){
+            changes |= USER_FIELD_LOCALE;
+        }
+        else if (!strcmp(key, "verified") && user->verified != json_object_get_boolean(valueobj)){
+            changes |= USER_FIELD_VERIFIED;
+        }
+        else if (!strcmp(key, "email") && is_string_changed(user->email, valueobj)){
+            changes |= USER_FIELD_EMAIL;
+        }
+        else if (!strcmp(key, "flags") && user->flags != json_object_get_int(valueobj)){
+            changes |= USER_FIELD_FLAGS;
+        }
+        else if (!strcmp(key, "premium_type") && user->premium_type != json_object_get_int(valueobj)){
+            changes |= USER_FIELD_PREMIUM_TYPE;
+        }
+        else if (!strcmp(key, "public_flags") && user->public_flags != json_object_get_int(valueobj)){
+            changes |= USER_FIELD_PUBLIC_FLAGS;
         }
 
-        if (skip){
-            json_object_iter_next(&curr);
+        json_object_iter_next(&curr);
+    }
 
-            continue;
-        }
+    return changes;
+}
+
+static bool construct_user(discord_user *user){
+    bool success = true;
+
+    struct json_object_iterator curr = json_object_iter_begin(user->raw_object);
+    struct json_object_iterator end = json_object_iter_end(user->raw_object);
+
+    /* null values are applied so updates can clear avatars, banners, etc. */
+    while (!json_object_iter_equal(&curr, &end)){
+        const char *key = json_object_iter_peek_name(&curr);
+        json_object *valueobj = json_object_iter_peek_value(&curr);
 
         if (!strcmp(key, "id")){
             const char *objstr = json_object_get_string(valueobj);
@@ -34,13 +88,25 @@ static bool construct_user(discord_user *user){
             success = snowflake_from_string(objstr, &user->id);
         }
         else if (!strcmp(key, "username")){
-            user->username = json_object_get_string(valueobj);
+            success = state_intern_string(
+                user->state,
+                &user->username,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "discriminator")){
-            user->discriminator = json_object_get_string(valueobj);
+            success = state_intern_string(
+                user->state,
+                &user->discriminator,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "avatar")){
-            user->avatar = json_object_get_string(valueobj);
+            success = state_intern_string(
+                user->state,
+                &user->avatar,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "bot")){
             user->bot = json_object_get_boolean(valueobj);
@@ -58,7 +124,11 @@ static bool construct_user(discord_user *user){
             user->accent_color = json_object_get_int(valueobj);
         }
         else if (!strcmp(key, "locale")){
-            user->locale = json_object_get_string(valueobj);
+            success = state_intern_string(
+                user->state,
+                &user->locale,
+                json_object_get_string(valueobj)
+            );
         }
         else if (!strcmp(key, "verified")){
             user->verified = json_object_get_boolean(valueobj);
@@ -95,6 +165,27 @@ static bool construct_user(discord_user *user){
     return success;
 }
 
+static bool compact_user(discord_user *user){
+    /* interned strings are owned by the state table and stay out of the arena */
+    const char **fields[] = {
+        user->state->strings ? NULL : &user->username,
+        user->state->strings ? NULL : &user->discriminator,
+        user->state->strings ? NULL : &user->avatar,
+        &user->banner,
+        user->state->strings ? NULL : &user->locale,
+        &user->email
+    };
+
+    return compact_object(
+        user->state,
+        &user->compact,
+        &user->raw_object,
+        fields,
+        sizeof(fields) / sizeof(*fields),
+        0
+    );
+}
+
 discord_user *user_init(discord_state *state, json_object *data){
     if (!state){
         log_write(
@@ -142,9 +233,90 @@ discord_user *user_init(discord_state *state, json_object *data){
         return NULL;
     }
 
+    if (state->compact && !compact_user(user)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] user_init() - compact_user call failed\n",
+            __FILE__
+        );
+
+        user_free(user);
+
+        return NULL;
+    }
+
     return user;
 }
 
+bool user_update(discord_user *user, json_object *data, int *changes){
+    if (!user){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] user_update() - user is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+    else if (!data){
+        log_write(
+            logger,
+            LOG_WARNING,
+            "[%s] user_update() - data is NULL\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    int fields = get_user_changes(user, data);
+
+    if (changes){
+        *changes = fields;
+    }
+
+    if (!fields){
+        return true;
+    }
+
+    if (!state_merge_object(user->state, &user->raw_object, data)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] user_update() - state_merge_object call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (!construct_user(user)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] user_update() - construct_user call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    if (user->state->compact && !compact_user(user)){
+        log_write(
+            logger,
+            LOG_ERROR,
+            "[%s] user_update() - compact_user call failed\n",
+            __FILE__
+        );
+
+        return false;
+    }
+
+    return true;
+}
+
 time_t user_get_creation_time(const discord_user *user){
     if (!user){
         log_write(
@@ -160,6 +332,14 @@ time_t user_get_creation_time(const discord_user *user){
     return snowflake_get_creation_time(user->id);
 }
 
+size_t user_get_size(const discord_user *user){
+    if (!user){
+        return 0;
+    }
+
+    return sizeof(*user) + cache_get_raw_size(user->raw_object, &user->compact);
+}
+
 void user_free(void *userptr){
     discord_user *user = userptr;
 
@@ -174,7 +354,16 @@ void user_free(void *userptr){
         return;
     }
 
+    cache_unlink(&user->state->cache, &user->cache);
+
     json_object_put(user->raw_object);
 
+    compact_release(user->state, &user->compact);
+
+    state_release_string(user->state, user->username);
+    state_release_string(user->state, user->discriminator);
+    state_release_string(user->state, user->avatar);
+    state_release_string(user->state, user->locale);
+
     free(user);
 }
@@ -38,9 +38,28 @@ typedef enum discord_user_flags {
     DISCORD_BOT_HTTP_INTERACTIONS = 524288
 } discord_user_flags;
 
+typedef enum discord_user_fields {
+    USER_FIELD_USERNAME = 1,
+    USER_FIELD_DISCRIMINATOR = 2,
+    USER_FIELD_AVATAR = 4,
+    USER_FIELD_BOT = 8,
+    USER_FIELD_SYSTEM = 16,
+    USER_FIELD_MFA_ENABLED = 32,
+    USER_FIELD_BANNER = 64,
+    USER_FIELD_ACCENT_COLOR = 128,
+    USER_FIELD_LOCALE = 256,
+    USER_FIELD_VERIFIED = 512,
+    USER_FIELD_EMAIL = 1024,
+    USER_FIELD_FLAGS = 2048,
+    USER_FIELD_PREMIUM_TYPE = 4096,
+    USER_FIELD_PUBLIC_FLAGS = 8192
+} discord_user_fields;
+
 typedef struct discord_user {
     discord_state *state;
     json_object *raw_object;
+    discord_compact compact;
+    discord_cache_node cache;
 
     snowflake id;
     const char *username;
@@ -60,8 +79,10 @@ typedef struct discord_user {
 } discord_user;
 
 discord_user *user_init(discord_state *, json_object *);
+bool user_update(discord_user *, json_object *, int *);
 
 time_t user_get_creation_time(const discord_user *);
+size_t user_get_size(const discord_user *);
 
 void user_free(void *);
 